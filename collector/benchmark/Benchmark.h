@@ -0,0 +1,45 @@
+#ifndef COLLECTOR_BENCHMARK_H
+#define COLLECTOR_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace collector {
+namespace benchmark {
+
+// Prevents the compiler from optimizing away the computation of value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile(""
+               :
+               : "r,m"(value)
+               : "memory");
+}
+
+// Runs fn iterations times, after a warm-up, and prints the average time per iteration.
+// Returns the average time per iteration in nanoseconds.
+template <typename Fn>
+double Run(const std::string& name, uint64_t iterations, Fn&& fn) {
+  for (uint64_t i = 0; i < iterations / 10; i++) {
+    fn();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; i++) {
+    fn();
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+  double ns_per_iteration = elapsed.count() / iterations;
+  std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+            << ns_per_iteration << " ns/op" << std::endl;
+  return ns_per_iteration;
+}
+
+}  // namespace benchmark
+}  // namespace collector
+
+#endif  // COLLECTOR_BENCHMARK_H
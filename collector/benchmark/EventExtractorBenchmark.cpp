@@ -0,0 +1,77 @@
+// Measures the per-call cost of extracting the process arguments and the syscall return value of an
+// event, through sinsp filter checks and through the direct accessors of SysdigEventExtractor.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "libsinsp/filterchecks.h"
+#include "libsinsp/sinsp.h"
+
+#include "Benchmark.h"
+#include "SysdigEventExtractor.h"
+
+using namespace collector;
+
+namespace {
+
+constexpr uint64_t kIterations = 10000000;
+constexpr int64_t kTid = 4242;
+
+std::unique_ptr<sinsp_filter_check> MakeFilterCheck(sinsp* inspector, const char* field) {
+  std::unique_ptr<sinsp_filter_check> check(g_filterlist.new_filter_check_from_fldname(field, inspector, true));
+  check->parse_field_name(field, true, false);
+  return check;
+}
+
+}  // namespace
+
+int main() {
+  sinsp inspector;
+
+  auto tinfo = inspector.build_threadinfo();
+  tinfo->m_tid = kTid;
+  tinfo->m_pid = kTid;
+  tinfo->m_comm = "nginx";
+  tinfo->m_exepath = "/usr/sbin/nginx";
+  tinfo->m_args = {"-g", "daemon off;", "-c", "/etc/nginx/nginx.conf"};
+  inspector.add_thread(std::move(tinfo));
+
+  // A close() exit event, returning 0, of the thread above.
+  uint8_t buffer[256];
+  char error[SCAP_LASTERR_SIZE];
+  size_t event_size;
+  if (scap_event_encode_params(scap_sized_buffer{buffer, sizeof(buffer)}, &event_size, error, PPME_SYSCALL_CLOSE_X, 1,
+                               static_cast<int64_t>(0)) != SCAP_SUCCESS) {
+    std::cerr << "Failed to encode event: " << error << std::endl;
+    return 1;
+  }
+  reinterpret_cast<scap_evt*>(buffer)->tid = kTid;
+
+  sinsp_evt event(&inspector);
+  event.init(buffer, 0);
+
+  auto args_check = MakeFilterCheck(&inspector, "proc.args");
+  benchmark::Run("proc.args, filter check", kIterations, [&] {
+    uint32_t len;
+    benchmark::DoNotOptimize(args_check->extract(&event, &len));
+  });
+
+  SysdigEventExtractor extractor;
+  extractor.Init(&inspector);
+  benchmark::Run("proc.args, direct", kIterations, [&] {
+    benchmark::DoNotOptimize(extractor.get_proc_args(&event));
+  });
+
+  auto rawres_check = MakeFilterCheck(&inspector, "evt.rawres");
+  benchmark::Run("evt.rawres, filter check", kIterations, [&] {
+    uint32_t len;
+    benchmark::DoNotOptimize(rawres_check->extract(&event, &len));
+  });
+
+  benchmark::Run("evt.rawres, direct", kIterations, [&] {
+    benchmark::DoNotOptimize(extractor.get_event_rawres(&event));
+  });
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+// Measures the per-event cost of the event thread accounting: counting events by type, and timing their
+// parsing and handling.
+
+#include <cstdint>
+#include <vector>
+
+#include "Benchmark.h"
+#include "EventStats.h"
+#include "TimeUtil.h"
+
+using namespace collector;
+
+namespace {
+
+constexpr uint64_t kIterations = 50000000;
+
+// The event types of a synthetic event stream.
+std::vector<uint16_t> EventTypes() {
+  std::vector<uint16_t> types(1024);
+  for (size_t i = 0; i < types.size(); i++) {
+    types[i] = (i * 7919) % PPM_EVENT_MAX;
+  }
+  return types;
+}
+
+// The accounting as done before sampling: system clock reads and volatile arrays, one per counter.
+struct VolatileStats {
+  volatile uint64_t nUserspaceEvents[PPM_EVENT_MAX] = {0};
+  volatile uint64_t nFilteredEvents[PPM_EVENT_MAX] = {0};
+  volatile uint64_t event_parse_micros[PPM_EVENT_MAX] = {0};
+  volatile uint64_t event_process_micros[PPM_EVENT_MAX] = {0};
+};
+
+}  // namespace
+
+int main() {
+  auto types = EventTypes();
+  size_t next = 0;
+
+  benchmark::Run("baseline (no accounting)", kIterations, [&] {
+    benchmark::DoNotOptimize(types[next++ & 1023]);
+  });
+
+  VolatileStats volatile_stats;
+  benchmark::Run("system clock, every event", kIterations, [&] {
+    uint16_t type = types[next++ & 1023];
+    auto parse_start = NowMicros();
+    volatile_stats.event_parse_micros[type] += NowMicros() - parse_start;
+    ++volatile_stats.nUserspaceEvents[type];
+    ++volatile_stats.nFilteredEvents[type];
+    auto process_start = NowMicros();
+    volatile_stats.event_process_micros[type] += NowMicros() - process_start;
+  });
+
+  for (uint32_t rate : {1, 64}) {
+    EventCounters counters;
+    EventTimingSampler sampler(rate);
+    benchmark::Run("sampled steady clock, 1 in " + std::to_string(rate), kIterations, [&] {
+      uint16_t type = types[next++ & 1023];
+      bool sampled = sampler.Sample();
+      int64_t parse_start = sampled ? EventTimingSampler::NowNanos() : 0;
+      auto& c = counters[type];
+      if (sampled) {
+        EventCounters::Add(c.parse_micros, sampler.ScaledMicros(EventTimingSampler::NowNanos() - parse_start));
+      }
+      EventCounters::Add(c.userspace, 1);
+      EventCounters::Add(c.filtered, 1);
+      int64_t process_start = sampled ? EventTimingSampler::NowNanos() : 0;
+      if (sampled) {
+        EventCounters::Add(c.process_micros, sampler.ScaledMicros(EventTimingSampler::NowNanos() - process_start));
+      }
+    });
+  }
+
+  return 0;
+}
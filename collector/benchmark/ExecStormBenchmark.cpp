@@ -0,0 +1,89 @@
+// Replays a synthetic exec storm, mostly a few health check commands run in a loop along with a trickle of
+// distinct commands, and measures the per-exec cost of coalescing, as well as how many signals are
+// formatted and sent with and without it.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "ExecCoalescer.h"
+#include "Hash.h"
+#include "RateLimit.h"
+
+using namespace collector;
+
+namespace {
+
+constexpr uint64_t kIterations = 10000000;
+// One exec every 100us, 10000 per second.
+constexpr uint64_t kExecIntervalNs = 100000;
+constexpr uint64_t kWindowNs = 30000000000;
+
+struct Exec {
+  std::string container_id;
+  std::string exepath;
+  std::string args;
+};
+
+// 90% of the execs are one of 8 health check commands, the others are all different.
+std::vector<Exec> ExecStorm() {
+  std::vector<Exec> execs(4096);
+  for (size_t i = 0; i < execs.size(); i++) {
+    if (i % 10 != 0) {
+      execs[i] = {"951e643e3c24", "/bin/sh", "-c /healthz.sh --check " + std::to_string(i % 8)};
+    } else {
+      execs[i] = {"951e643e3c24", "/usr/bin/curl", "-s http://localhost:8080/item/" + std::to_string(i)};
+    }
+  }
+  return execs;
+}
+
+Hash128 Key(const Exec& exec) {
+  return StreamingHash128().Add(exec.container_id).Add(exec.exepath).Add(exec.args).Finish();
+}
+
+}  // namespace
+
+int main() {
+  auto execs = ExecStorm();
+
+  uint64_t i = 0;
+  uint64_t sent = 0;
+  RateLimitCache rate_limiter;
+  benchmark::Run("exec storm, rate limiting only", kIterations, [&] {
+    const Exec& exec = execs[i++ % execs.size()];
+    // Every exec is formatted before being rate limited.
+    benchmark::DoNotOptimize(exec);
+    sent += rate_limiter.Allow(Key(exec));
+  });
+  std::cout << "  formatted: " << i << ", sent: " << sent << std::endl;
+
+  i = 0;
+  sent = 0;
+  uint64_t formatted = 0;
+  uint64_t ts = 0;
+  ExecCoalescer coalescer(kWindowNs);
+  RateLimitCache coalesced_rate_limiter;
+  benchmark::Run("exec storm, coalescing", kIterations, [&] {
+    const Exec& exec = execs[i++ % execs.size()];
+    ts += kExecIntervalNs;
+
+    ExecCoalescer::Summary summary;
+    while (coalescer.NextSummary(ts, &summary)) {
+      sent += coalesced_rate_limiter.Allow(summary.key);
+    }
+
+    Hash128 key = Key(exec);
+    if (ExecCoalescer::Summary* coalesced = coalescer.Coalesce(key, ts)) {
+      formatted += coalesced->count == 1;
+      return;
+    }
+    formatted++;
+    coalescer.Open(key, ts);
+    sent += coalesced_rate_limiter.Allow(key);
+  });
+  std::cout << "  formatted: " << formatted << ", sent (including summaries): " << sent << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,255 @@
+#ifndef COLLECTOR_MOCKSENSOR_H
+#define COLLECTOR_MOCKSENSOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+#include <google/protobuf/util/time_util.h>
+#include <grpcpp/create_channel.h>
+#include <grpcpp/security/credentials.h>
+#include <grpcpp/security/server_credentials.h>
+#include <grpcpp/server.h>
+#include <grpcpp/server_builder.h>
+
+#include "internalapi/sensor/network_connection_iservice.grpc.pb.h"
+#include "internalapi/sensor/signal_iservice.grpc.pb.h"
+
+#include "LatencyHistogram.h"
+#include "TimeUtil.h"
+
+namespace collector {
+namespace benchmark {
+
+// MockSensor serves SignalService and NetworkConnectionInfoService in-process, on a local port or a Unix
+// socket, so that the gRPC path of Collector can be measured on a single machine, without Sensor.
+//
+// It counts the streams, messages and bytes it receives, and records the delay between the time carried by
+// each message and its reception. It can also misbehave on demand: read slowly or not at all, so that the
+// HTTP/2 flow control windows fill up and the clients feel backpressure, drop all streams as a restarting
+// Sensor would, and send control messages on the network streams.
+class MockSensor {
+ public:
+  class Counters {
+   public:
+    uint64_t Streams() const { return streams_.load(std::memory_order_relaxed); }
+    uint64_t Messages() const { return messages_.load(std::memory_order_relaxed); }
+    uint64_t Bytes() const { return bytes_.load(std::memory_order_relaxed); }
+    const LatencyHistogram& Latency() const { return latency_; }
+
+   private:
+    friend class MockSensor;
+
+    void Reset() {
+      messages_.store(0, std::memory_order_relaxed);
+      bytes_.store(0, std::memory_order_relaxed);
+      latency_.Reset();
+    }
+
+    void Record(size_t bytes, const google::protobuf::Timestamp& time) {
+      bytes_.fetch_add(bytes, std::memory_order_relaxed);
+      if (time.seconds() != 0 || time.nanos() != 0) {
+        latency_.Record(NowMicros() - google::protobuf::util::TimeUtil::TimestampToMicroseconds(time));
+      }
+      messages_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> streams_{0};
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> bytes_{0};
+    LatencyHistogram latency_;
+  };
+
+  // "localhost:0" picks a free port, "unix:/path" listens on a Unix socket.
+  explicit MockSensor(std::string address = "localhost:0")
+      : address_(std::move(address)), signal_service_(this), network_service_(this) {}
+
+  ~MockSensor() { Shutdown(); }
+
+  bool Start() {
+    grpc::ServerBuilder builder;
+    int port = 0;
+    builder.AddListeningPort(address_, grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&signal_service_);
+    builder.RegisterService(&network_service_);
+    server_ = builder.BuildAndStart();
+    if (!server_) {
+      return false;
+    }
+    if (address_.compare(0, 5, "unix:") != 0) {
+      address_ = address_.substr(0, address_.rfind(':') + 1) + std::to_string(port);
+    }
+    return true;
+  }
+
+  void Shutdown() {
+    if (!server_) return;
+    Resume();
+    Disconnect();
+    server_->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
+    server_.reset();
+  }
+
+  // The address to connect to, with the port picked by Start().
+  const std::string& Address() const { return address_; }
+
+  std::shared_ptr<grpc::Channel> CreateChannel() const {
+    return grpc::CreateChannel(address_, grpc::InsecureChannelCredentials());
+  }
+
+  // Called with every signal received, from the threads of the server. Must be set before Start().
+  void SetSignalObserver(std::function<void(const sensor::SignalStreamMessage&)> observer) {
+    signal_observer_ = std::move(observer);
+  }
+
+  // Holds every message for this long before reading the next one, like a slow consumer.
+  void SetReadDelay(std::chrono::microseconds delay) { read_delay_micros_.store(delay.count()); }
+
+  // Stops reading from all streams until Resume().
+  void Pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = true;
+  }
+
+  void Resume() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = false;
+    resumed_.notify_all();
+  }
+
+  // Cancels all open streams, as if Sensor restarted. Clients are expected to reconnect.
+  void Disconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto* context : contexts_) {
+      context->TryCancel();
+    }
+    resumed_.notify_all();
+  }
+
+  // Sends the message on all open network streams. Returns the number of streams it was sent to.
+  size_t SendControlMessage(const sensor::NetworkFlowsControlMessage& msg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t sent = 0;
+    for (auto* stream : network_streams_) {
+      if (stream->Write(msg)) sent++;
+    }
+    return sent;
+  }
+
+  const Counters& Signals() const { return signals_; }
+  const Counters& Network() const { return network_; }
+
+  // Resets the message and byte counts and the latencies, but not the stream counts, between two runs.
+  void ResetCounters() {
+    signals_.Reset();
+    network_.Reset();
+  }
+
+  // Waits until the total number of messages received reaches count. Returns false on timeout.
+  static bool WaitFor(const Counters& counters, uint64_t count, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (counters.Messages() < count) {
+      if (std::chrono::steady_clock::now() >= deadline) return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+ private:
+  using NetworkStream = grpc::ServerReaderWriter<sensor::NetworkFlowsControlMessage, sensor::NetworkConnectionInfoMessage>;
+
+  class SignalServiceImpl : public sensor::SignalService::Service {
+   public:
+    explicit SignalServiceImpl(MockSensor* sensor) : sensor_(sensor) {}
+
+    grpc::Status PushSignals(grpc::ServerContext* context,
+                             grpc::ServerReaderWriter<v1::Empty, sensor::SignalStreamMessage>* stream) override {
+      sensor_->Open(context, nullptr, &sensor_->signals_);
+      sensor::SignalStreamMessage msg;
+      while (sensor_->WaitUntilReadable(context) && stream->Read(&msg)) {
+        const auto& signal = msg.signal().process_signal();
+        // Observed before being counted, so that waiting for the count is enough to see the signal.
+        if (sensor_->signal_observer_) {
+          sensor_->signal_observer_(msg);
+        }
+        sensor_->signals_.Record(msg.ByteSizeLong(), signal.time());
+      }
+      sensor_->Close(context, nullptr);
+      return grpc::Status::OK;
+    }
+
+   private:
+    MockSensor* sensor_;
+  };
+
+  class NetworkServiceImpl : public sensor::NetworkConnectionInfoService::Service {
+   public:
+    explicit NetworkServiceImpl(MockSensor* sensor) : sensor_(sensor) {}
+
+    grpc::Status PushNetworkConnectionInfo(grpc::ServerContext* context, NetworkStream* stream) override {
+      sensor_->Open(context, stream, &sensor_->network_);
+      sensor::NetworkConnectionInfoMessage msg;
+      while (sensor_->WaitUntilReadable(context) && stream->Read(&msg)) {
+        sensor_->network_.Record(msg.ByteSizeLong(), msg.info().time());
+      }
+      sensor_->Close(context, stream);
+      return grpc::Status::OK;
+    }
+
+   private:
+    MockSensor* sensor_;
+  };
+
+  void Open(grpc::ServerContext* context, NetworkStream* stream, Counters* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contexts_.insert(context);
+    if (stream) network_streams_.insert(stream);
+    counters->streams_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Close(grpc::ServerContext* context, NetworkStream* stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contexts_.erase(context);
+    if (stream) network_streams_.erase(stream);
+  }
+
+  // Applies the read delay, and blocks while paused. Returns false if the stream was cancelled meanwhile.
+  bool WaitUntilReadable(grpc::ServerContext* context) {
+    int64_t delay = read_delay_micros_.load();
+    if (delay > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(delay));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    resumed_.wait(lock, [&] { return !paused_ || context->IsCancelled(); });
+    return !context->IsCancelled();
+  }
+
+  std::string address_;
+  SignalServiceImpl signal_service_;
+  NetworkServiceImpl network_service_;
+  std::unique_ptr<grpc::Server> server_;
+
+  Counters signals_;
+  Counters network_;
+  std::function<void(const sensor::SignalStreamMessage&)> signal_observer_;
+  std::atomic<int64_t> read_delay_micros_{0};
+
+  std::mutex mutex_;
+  std::condition_variable resumed_;
+  bool paused_ = false;
+  std::unordered_set<grpc::ServerContext*> contexts_;
+  std::unordered_set<NetworkStream*> network_streams_;
+};
+
+}  // namespace benchmark
+}  // namespace collector
+
+#endif  // COLLECTOR_MOCKSENSOR_H
@@ -0,0 +1,84 @@
+// Measures the cost of building a process signal, in time and in heap allocations, once the formatter has
+// warmed up, and the cost of the UUID generation on its own.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "libsinsp/sinsp.h"
+
+#include "Benchmark.h"
+#include "ProcessSignalFormatter.h"
+#include "Utility.h"
+
+using namespace collector;
+
+namespace {
+
+constexpr uint64_t kIterations = 1000000;
+
+std::atomic<uint64_t> g_allocations{0};
+
+sinsp_threadinfo* AddThread(sinsp* inspector, int64_t tid, int64_t ptid, int64_t vpid, const char* exepath) {
+  auto tinfo = inspector->build_threadinfo();
+  tinfo->m_tid = tid;
+  tinfo->m_pid = tid;
+  tinfo->m_ptid = ptid;
+  tinfo->m_vpid = vpid;
+  tinfo->m_comm = exepath;
+  tinfo->m_exepath = exepath;
+  tinfo->m_container_id = "951e643e3c24";
+  tinfo->m_clone_ts = 1700000000000000000;
+  tinfo->m_args = {"-g", "daemon off;", "-c", "/etc/nginx/nginx.conf"};
+  int64_t key = tinfo->m_tid;
+  inspector->add_thread(std::move(tinfo));
+  return inspector->get_thread_ref(key, false).get();
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+int main() {
+  sinsp inspector;
+
+  // A process with a parent and a grandparent in the same container.
+  AddThread(&inspector, 100, 1, 1, "/usr/bin/tini");
+  AddThread(&inspector, 101, 100, 2, "/bin/sh");
+  sinsp_threadinfo* tinfo = AddThread(&inspector, 102, 101, 3, "/usr/sbin/nginx");
+
+  ProcessSignalFormatter formatter(&inspector);
+
+  benchmark::Run("UUIDStr", kIterations, [] {
+    benchmark::DoNotOptimize(UUIDStr());
+  });
+
+  // The first signal sizes the reused message and fills the lineage cache.
+  formatter.ToProtoMessage(tinfo);
+
+  uint64_t iterations = 0;
+  uint64_t allocations = g_allocations.load();
+  benchmark::Run("process signal, existing process", kIterations, [&] {
+    benchmark::DoNotOptimize(formatter.ToProtoMessage(tinfo));
+    iterations++;
+  });
+  double allocations_per_signal = static_cast<double>(g_allocations.load() - allocations) / iterations;
+  std::cout << "allocations per signal: " << allocations_per_signal << std::endl;
+
+  return 0;
+}
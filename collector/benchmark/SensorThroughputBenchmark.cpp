@@ -0,0 +1,234 @@
+// Drives SignalServiceClient and NetworkStatusNotifier against an in-process MockSensor, and measures the
+// throughput and latency of the gRPC path, as well as how it behaves when Sensor reads slowly or restarts.
+//
+// Usage: SensorThroughputBenchmark [address], where address defaults to a Unix socket in /tmp.
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CollectorConfig.h"
+#include "CollectorStats.h"
+#include "ConnTracker.h"
+#include "MockSensor.h"
+#include "NetworkConnectionInfoServiceComm.h"
+#include "NetworkStatusNotifier.h"
+#include "ProtoUtil.h"
+#include "SignalServiceClient.h"
+
+using namespace collector;
+using benchmark::MockSensor;
+
+namespace {
+
+constexpr uint64_t kSignals = 200000;
+constexpr uint64_t kSlowSignals = 20000;
+constexpr size_t kConnections = 20000;
+constexpr int kScrapes = 5;
+constexpr std::chrono::seconds kTimeout{30};
+
+sensor::SignalStreamMessage MakeSignal(uint64_t i) {
+  sensor::SignalStreamMessage msg;
+  auto* signal = msg.mutable_signal()->mutable_process_signal();
+  signal->set_id(std::to_string(i));
+  signal->set_container_id("951e643e3c24");
+  signal->set_name("curl");
+  signal->set_exec_file_path("/usr/bin/curl");
+  signal->set_args("-s http://localhost:8080/item/" + std::to_string(i));
+  signal->set_pid(i % 32768);
+  *signal->mutable_time() = CurrentTimeProto();
+  return msg;
+}
+
+// Returns whether the signal was dropped. Like the process signal handler, pushes the signal again when the
+// client asks for the existing processes, on the first signal of a new stream.
+bool Push(SignalServiceClient& client, const sensor::SignalStreamMessage& msg) {
+  auto result = client.PushSignals(msg);
+  if (result == SignalHandler::NEEDS_REFRESH) {
+    result = client.PushSignals(msg);
+  }
+  return result == SignalHandler::ERROR;
+}
+
+// The upper bound of the bucket holding the given quantile.
+uint64_t Quantile(const LatencyHistogram& histogram, double quantile) {
+  LatencyHistogram::Snapshot snapshot;
+  histogram.Read(&snapshot);
+  uint64_t total = 0;
+  for (uint64_t count : snapshot.counts) total += count;
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LatencyHistogram::kNumBounds; i++) {
+    seen += snapshot.counts[i];
+    if (seen >= quantile * total) return uint64_t{1} << i;
+  }
+  return uint64_t{1} << LatencyHistogram::kNumBounds;
+}
+
+void ReportLatency(const MockSensor::Counters& counters) {
+  std::cout << "  latency p50 <= " << Quantile(counters.Latency(), 0.5) << "us, p99 <= "
+            << Quantile(counters.Latency(), 0.99) << "us" << std::endl;
+}
+
+void Report(const std::string& name, const MockSensor::Counters& counters, std::chrono::duration<double> elapsed) {
+  std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed << std::setprecision(0)
+            << counters.Messages() / elapsed.count() << " msg/s" << std::setw(12) << std::setprecision(2)
+            << counters.Bytes() / elapsed.count() / (1 << 20) << " MiB/s" << std::endl;
+  ReportLatency(counters);
+}
+
+bool WaitForStreams(const MockSensor::Counters& counters, uint64_t streams) {
+  auto deadline = std::chrono::steady_clock::now() + kTimeout;
+  while (counters.Streams() < streams) {
+    if (std::chrono::steady_clock::now() >= deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void RunSignals(MockSensor& sensor) {
+  auto& stats = CollectorStats::GetOrCreate();
+  SignalServiceClient client(sensor.CreateChannel());
+  client.Start();
+  if (!WaitForStreams(sensor.Signals(), 1)) {
+    std::cerr << "The signal stream was not established" << std::endl;
+    return;
+  }
+
+  // As fast as possible.
+  sensor.ResetCounters();
+  uint64_t dropped = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < kSignals; i++) {
+    dropped += Push(client, MakeSignal(i));
+  }
+  MockSensor::WaitFor(sensor.Signals(), kSignals - dropped, kTimeout);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  Report("signals", sensor.Signals(), elapsed);
+  std::cout << "  sent: " << kSignals << ", dropped: " << dropped
+            << ", batched writes: " << stats.GetCounter(CollectorStats::process_send_writes) << std::endl;
+
+  // Sensor reads slowly, the queue fills up and signals are dropped.
+  sensor.SetReadDelay(std::chrono::microseconds(100));
+  sensor.ResetCounters();
+  dropped = 0;
+  start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < kSlowSignals; i++) {
+    dropped += Push(client, MakeSignal(i));
+  }
+  MockSensor::WaitFor(sensor.Signals(), kSlowSignals - dropped, kTimeout);
+  elapsed = std::chrono::steady_clock::now() - start;
+  Report("signals, slow consumer (100us/msg)", sensor.Signals(), elapsed);
+  std::cout << "  sent: " << kSlowSignals << ", dropped: " << dropped << std::endl;
+  sensor.SetReadDelay(std::chrono::microseconds(0));
+
+  // Sensor restarts while signals flow at 10k/s. Signals pushed meanwhile are replayed.
+  std::atomic<bool> stop{false};
+  std::thread producer([&] {
+    for (uint64_t i = 0; !stop; i++) {
+      Push(client, MakeSignal(i));
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  uint64_t streams = sensor.Signals().Streams();
+  start = std::chrono::steady_clock::now();
+  sensor.Disconnect();
+  bool reconnected = WaitForStreams(sensor.Signals(), streams + 1);
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  stop = true;
+  producer.join();
+
+  std::cout << std::left << std::setw(48) << "signals, Sensor restart" << std::right << std::setw(12)
+            << std::setprecision(0) << std::chrono::duration<double, std::milli>(elapsed).count() << " ms to reconnect"
+            << (reconnected ? "" : " (timed out)") << std::endl;
+  std::cout << "  replayed: " << stats.GetCounter(CollectorStats::process_replay_sent)
+            << ", dropped from replay: " << stats.GetCounter(CollectorStats::process_replay_dropped) << std::endl;
+
+  client.Stop();
+}
+
+// Reports a fixed population of connections, a fifth of which is replaced by every scrape.
+class ChurningScraper : public IConnScraper {
+ public:
+  bool Scrape(std::vector<Connection>* connections, std::vector<ContainerEndpoint>* listen_endpoints) override {
+    for (size_t i = 0; i < kConnections; i++) {
+      size_t id = i % 5 == 0 ? i + generation_ * kConnections : i;
+      Address remote(10, (id >> 16) & 0xff, (id >> 8) & 0xff, id & 0xff);
+      connections->emplace_back("951e643e3c24", Endpoint(Address(172, 17, 0, 2), 34000 + (id % 20000)),
+                                Endpoint(remote, 443), L4Proto::TCP, false);
+    }
+    generation_++;
+    return true;
+  }
+
+ private:
+  size_t generation_ = 0;
+};
+
+class BenchmarkConfig : public CollectorConfig {
+ public:
+  BenchmarkConfig() {
+    scrape_interval_ = 1;
+    turn_off_scrape_ = false;
+    // Deltas are split, so that their messages are built while the previous ones are written.
+    network_message_max_bytes_ = 64 * 1024;
+  }
+};
+
+void RunNetwork(MockSensor& sensor) {
+  BenchmarkConfig config;
+  auto conn_tracker = std::make_shared<ConnectionTracker>();
+  auto comm = std::make_shared<NetworkConnectionInfoServiceComm>("benchmark", sensor.CreateChannel());
+  NetworkStatusNotifier notifier(std::make_shared<ChurningScraper>(), conn_tracker, comm, config);
+
+  // Messages are paced by the scrape interval, only their size and delivery delay matter.
+  notifier.Start();
+  std::this_thread::sleep_for(std::chrono::seconds(config.ScrapeInterval()) * kScrapes);
+
+  // Known public IPs, as Sensor sends them.
+  sensor::NetworkFlowsControlMessage control;
+  control.mutable_public_ip_addresses()->add_ipv4_addresses(0x08080808);
+  control.mutable_ip_networks()->set_ipv4_networks(std::string("\x0a\x00\x00\x00\x08", 5));
+  size_t controlled = sensor.SendControlMessage(control);
+
+  notifier.Stop();
+
+  uint64_t messages = sensor.Network().Messages();
+  uint64_t bytes = sensor.Network().Bytes();
+  std::cout << std::left << std::setw(48) << "network, " + std::to_string(kConnections) + " connections"
+            << std::right << std::setw(12) << (messages ? bytes / messages : 0) << " bytes/msg" << std::endl;
+  ReportLatency(sensor.Network());
+  std::cout << "  messages: " << messages << ", deltas split: "
+            << CollectorStats::GetOrCreate().GetCounter(CollectorStats::net_split_deltas)
+            << ", control messages sent: " << controlled << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string address = argc > 1 ? argv[1] : "unix:/tmp/mock-sensor-" + std::to_string(getpid()) + ".sock";
+
+  MockSensor sensor(address);
+  if (!sensor.Start()) {
+    std::cerr << "Failed to listen on " << address << std::endl;
+    return 1;
+  }
+  std::cout << "Mock Sensor listening on " << sensor.Address() << std::endl;
+
+  RunSignals(sensor);
+  RunNetwork(sensor);
+
+  sensor.Shutdown();
+  if (address.compare(0, 5, "unix:") == 0) {
+    unlink(address.c_str() + 5);
+  }
+  return 0;
+}
@@ -173,12 +173,18 @@ int main(int argc, char** argv) {
   signal(SIGSEGV, AbortHandler);
   signal(SIGTERM, ShutdownHandler);
   signal(SIGINT, ShutdownHandler);
+  // A signal or network file whose reader went away fails the writes with EPIPE instead of killing collector.
+  signal(SIGPIPE, SIG_IGN);
 
   config.grpc_channel = std::move(sensor_connection);
 
   CollectorService collector(config, &g_control, &g_signum);
 
-  if (!SetupKernelDriver(collector, args->GRPCServer(), config)) {
+  if (config.IsReplay()) {
+    if (!collector.InitReplay()) {
+      CLOG(FATAL) << "Failed to open the capture to replay.";
+    }
+  } else if (!SetupKernelDriver(collector, args->GRPCServer(), config)) {
     startup_diagnostics.Log();
     CLOG(FATAL) << "Failed to initialize collector kernel components.";
   }
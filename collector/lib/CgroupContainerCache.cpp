@@ -0,0 +1,27 @@
+#include "CgroupContainerCache.h"
+
+#include "CollectorStats.h"
+#include "Utility.h"
+
+namespace collector {
+
+constexpr size_t CgroupContainerCache::kDefaultMaxSize;
+
+const std::string& CgroupContainerCache::Resolve(const std::string& cgroup) {
+  auto it = cache_.find(cgroup);
+  if (it != cache_.end()) {
+    COUNTER_INC(CollectorStats::container_cgroup_cache_hits);
+    return it->second;
+  }
+  COUNTER_INC(CollectorStats::container_cgroup_cache_misses);
+
+  if (cache_.size() >= max_size_) {
+    cache_.clear();
+    COUNTER_INC(CollectorStats::container_cgroup_cache_flushes);
+  }
+
+  auto container_id = ExtractContainerIDFromCgroup(cgroup);
+  return cache_.emplace(cgroup, container_id ? std::string(*container_id) : std::string()).first->second;
+}
+
+}  // namespace collector
@@ -0,0 +1,37 @@
+#ifndef COLLECTOR_CGROUPCONTAINERCACHE_H
+#define COLLECTOR_CGROUPCONTAINERCACHE_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+namespace collector {
+
+// CgroupContainerCache remembers the container ID extracted from each cgroup path, or that the path does
+// not belong to a container, so that the threads of a cgroup do not each parse the same path again.
+//
+// The container ID of a cgroup only depends on its path, so entries never become stale: the cgroup of a
+// removed container simply stops being looked up. The cache is bounded, and cleared when it is full, to
+// get rid of those entries. Lookups are reported through the container_cgroup_cache_* counters.
+//
+// Not thread-safe.
+class CgroupContainerCache {
+ public:
+  static constexpr size_t kDefaultMaxSize = 4096;
+
+  explicit CgroupContainerCache(size_t max_size = kDefaultMaxSize) : max_size_(max_size) {}
+
+  // Returns the (short) container ID of the cgroup, or an empty string if it does not belong to a
+  // container. The returned reference is valid until the next call.
+  const std::string& Resolve(const std::string& cgroup);
+
+  size_t Size() const { return cache_.size(); }
+
+ private:
+  size_t max_size_;
+  std::unordered_map<std::string, std::string> cache_;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_CGROUPCONTAINERCACHE_H
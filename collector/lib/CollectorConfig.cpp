@@ -44,10 +44,88 @@ BoolEnvVar enable_external_ips("ROX_ENABLE_EXTERNAL_IPS", false);
 
 BoolEnvVar enable_connection_stats("ROX_COLLECTOR_ENABLE_CONNECTION_STATS", true);
 
+// If true, adapt the scrape interval to the measured scrape cost and to the changes missed by the event stream.
+BoolEnvVar adaptive_scrape("ROX_COLLECTOR_ADAPTIVE_SCRAPE", false);
+
+// Bounds for the adaptive scrape interval, in seconds.
+IntEnvVar scrape_interval_min("ROX_COLLECTOR_SCRAPE_INTERVAL_MIN", CollectorConfig::kScrapeIntervalMin);
+IntEnvVar scrape_interval_max("ROX_COLLECTOR_SCRAPE_INTERVAL_MAX", CollectorConfig::kScrapeIntervalMax);
+
+// If true, the network and process signal handlers do their work on dedicated threads, fed by the event thread.
+BoolEnvVar pipelined_dispatch("ROX_COLLECTOR_PIPELINED_DISPATCH", false);
+
+// Capacity of the queue of each pipelined signal handler.
+IntEnvVar pipeline_queue_size("ROX_COLLECTOR_PIPELINE_QUEUE_SIZE", CollectorConfig::kPipelineQueueSize);
+
+// Capacity of the queue of process signals waiting to be sent to Sensor.
+IntEnvVar signal_queue_size("ROX_COLLECTOR_SIGNAL_QUEUE_SIZE", CollectorConfig::kSignalQueueSize);
+
+// If true, the oldest queued process signal is dropped to make room when the queue is full, rather than the new one.
+BoolEnvVar signal_queue_drop_oldest("ROX_COLLECTOR_SIGNAL_QUEUE_DROP_OLDEST", false);
+
+// Size, in bytes, of the buffer of process signals replayed after the stream to Sensor was down. 0 disables replaying.
+IntEnvVar signal_replay_buffer_bytes("ROX_COLLECTOR_SIGNAL_REPLAY_BUFFER_BYTES", CollectorConfig::kSignalReplayBufferBytes);
+
+// The window, in seconds, during which identical execs are coalesced. 0 disables coalescing.
+IntEnvVar exec_coalesce_window("ROX_COLLECTOR_EXEC_COALESCE_WINDOW", CollectorConfig::kExecCoalesceWindow);
+
+// Time the parsing and handling of one in this many events.
+IntEnvVar event_timing_sample_rate("ROX_COLLECTOR_EVENT_TIMING_SAMPLE_RATE", CollectorConfig::kEventTimingSampleRate);
+
+// Number of existing processes sent to Sensor between two events, after the stream was (re)established.
+IntEnvVar existing_processes_batch_size("ROX_COLLECTOR_EXISTING_PROCESSES_BATCH_SIZE", CollectorConfig::kExistingProcessesBatchSize);
+
+// Maximum number of existing processes sent to Sensor per second. 0 disables the limit.
+IntEnvVar existing_processes_rate("ROX_COLLECTOR_EXISTING_PROCESSES_RATE", CollectorConfig::kExistingProcessesRate);
+
+// If true, stop capturing the least valuable syscalls while kernel drops or event handling lag are sustained.
+BoolEnvVar syscall_shedding("ROX_COLLECTOR_SYSCALL_SHEDDING", false);
+
+// If true, leave details out of process signals while event handling lag is sustained.
+BoolEnvVar enrichment_degradation("ROX_COLLECTOR_ENRICHMENT_DEGRADATION", false);
+
+// If true, the writes of process signals and network messages to Sensor are arbitrated by priority and byte budget.
+BoolEnvVar signal_scheduler("ROX_COLLECTOR_SIGNAL_SCHEDULER", false);
+
+// Priorities of the process signal and network streams, the higher one is written first.
+IntEnvVar process_signal_priority("ROX_COLLECTOR_PROCESS_SIGNAL_PRIORITY", CollectorConfig::kProcessSignalPriority);
+IntEnvVar network_signal_priority("ROX_COLLECTOR_NETWORK_SIGNAL_PRIORITY", CollectorConfig::kNetworkSignalPriority);
+
+// Bytes per second the process signal and network streams may write to Sensor. 0 disables the limit.
+IntEnvVar process_signal_bytes_per_second("ROX_COLLECTOR_PROCESS_SIGNAL_BYTES_PER_SECOND", 0);
+IntEnvVar network_signal_bytes_per_second("ROX_COLLECTOR_NETWORK_SIGNAL_BYTES_PER_SECOND", 0);
+
+// Bounds of the messages network deltas are split into, in encoded bytes and in entries. 0 disables a bound.
+IntEnvVar network_message_max_bytes("ROX_COLLECTOR_NETWORK_MESSAGE_MAX_BYTES", CollectorConfig::kNetworkMessageMaxBytes);
+IntEnvVar network_message_max_entries("ROX_COLLECTOR_NETWORK_MESSAGE_MAX_ENTRIES", 0);
+
+// Path to a capture file to replay instead of collecting live events from the kernel.
+StringEnvVar replay_file("ROX_COLLECTOR_REPLAY_FILE", "");
+
+// If true, events of the replayed capture are delivered at the pace they were recorded at.
+BoolEnvVar replay_realtime("ROX_COLLECTOR_REPLAY_REALTIME", false);
+
+// Paths of the files (or named pipes) process signals and network messages are written to, as size-delimited
+// records, when there is no Sensor to send them to.
+StringEnvVar signal_file("ROX_COLLECTOR_SIGNAL_FILE", "");
+StringEnvVar network_file("ROX_COLLECTOR_NETWORK_FILE", "");
+
 }  // namespace
 
 constexpr bool CollectorConfig::kTurnOffScrape;
 constexpr int CollectorConfig::kScrapeInterval;
+constexpr int CollectorConfig::kScrapeIntervalMin;
+constexpr int CollectorConfig::kScrapeIntervalMax;
+constexpr int CollectorConfig::kPipelineQueueSize;
+constexpr int CollectorConfig::kSignalQueueSize;
+constexpr int CollectorConfig::kSignalReplayBufferBytes;
+constexpr int CollectorConfig::kExecCoalesceWindow;
+constexpr int CollectorConfig::kEventTimingSampleRate;
+constexpr int CollectorConfig::kExistingProcessesBatchSize;
+constexpr int CollectorConfig::kExistingProcessesRate;
+constexpr int CollectorConfig::kProcessSignalPriority;
+constexpr int CollectorConfig::kNetworkSignalPriority;
+constexpr int CollectorConfig::kNetworkMessageMaxBytes;
 constexpr CollectionMethod CollectorConfig::kCollectionMethod;
 constexpr const char* CollectorConfig::kSyscalls[];
 constexpr bool CollectorConfig::kEnableProcessesListeningOnPorts;
@@ -68,6 +146,31 @@ void CollectorConfig::InitCollectorConfig(CollectorArgs* args) {
   collect_connection_status_ = collect_connection_status.value();
   enable_external_ips_ = enable_external_ips.value();
   enable_connection_stats_ = enable_connection_stats.value();
+  adaptive_scrape_ = adaptive_scrape.value();
+  scrape_interval_min_ = scrape_interval_min.value();
+  scrape_interval_max_ = scrape_interval_max.value();
+  pipelined_dispatch_ = pipelined_dispatch.value();
+  pipeline_queue_size_ = pipeline_queue_size.value();
+  signal_queue_size_ = signal_queue_size.value();
+  signal_queue_drop_oldest_ = signal_queue_drop_oldest.value();
+  signal_replay_buffer_bytes_ = signal_replay_buffer_bytes.value();
+  exec_coalesce_window_ = exec_coalesce_window.value();
+  event_timing_sample_rate_ = event_timing_sample_rate.value();
+  existing_processes_batch_size_ = existing_processes_batch_size.value();
+  existing_processes_rate_ = existing_processes_rate.value();
+  syscall_shedding_ = syscall_shedding.value();
+  enrichment_degradation_ = enrichment_degradation.value();
+  signal_scheduler_ = signal_scheduler.value();
+  process_signal_priority_ = process_signal_priority.value();
+  network_signal_priority_ = network_signal_priority.value();
+  process_signal_bytes_per_second_ = process_signal_bytes_per_second.value();
+  network_signal_bytes_per_second_ = network_signal_bytes_per_second.value();
+  network_message_max_bytes_ = network_message_max_bytes.value();
+  network_message_max_entries_ = network_message_max_entries.value();
+  replay_file_ = replay_file.value();
+  replay_realtime_ = replay_realtime.value();
+  signal_file_ = signal_file.value();
+  network_file_ = network_file.value();
 
   for (const auto& syscall : kSyscalls) {
     syscalls_.push_back(syscall);
@@ -179,6 +282,91 @@ void CollectorConfig::InitCollectorConfig(CollectorArgs* args) {
     enable_core_dump_ = true;
   }
 
+  if (adaptive_scrape_) {
+    if (scrape_interval_min_ <= 0 || scrape_interval_max_ < scrape_interval_min_) {
+      CLOG(ERROR) << "Invalid adaptive scrape interval bounds [" << scrape_interval_min_ << ", " << scrape_interval_max_
+                  << "], using [" << kScrapeIntervalMin << ", " << kScrapeIntervalMax << "]";
+      scrape_interval_min_ = kScrapeIntervalMin;
+      scrape_interval_max_ = kScrapeIntervalMax;
+    }
+    CLOG(INFO) << "Adaptive scrape interval enabled, bounds: [" << scrape_interval_min_ << "s, " << scrape_interval_max_ << "s]";
+  }
+
+  if (pipelined_dispatch_) {
+    if (pipeline_queue_size_ <= 0) {
+      CLOG(ERROR) << "Invalid pipeline queue size " << pipeline_queue_size_ << ", using " << kPipelineQueueSize;
+      pipeline_queue_size_ = kPipelineQueueSize;
+    }
+    CLOG(INFO) << "Pipelined signal dispatch enabled, queue size: " << pipeline_queue_size_;
+  }
+
+  if (signal_queue_size_ <= 0) {
+    CLOG(ERROR) << "Invalid signal queue size " << signal_queue_size_ << ", using " << kSignalQueueSize;
+    signal_queue_size_ = kSignalQueueSize;
+  }
+
+  if (signal_replay_buffer_bytes_ < 0) {
+    CLOG(ERROR) << "Invalid signal replay buffer size " << signal_replay_buffer_bytes_ << ", using " << kSignalReplayBufferBytes;
+    signal_replay_buffer_bytes_ = kSignalReplayBufferBytes;
+  }
+
+  if (exec_coalesce_window_ < 0) {
+    CLOG(ERROR) << "Invalid exec coalescing window " << exec_coalesce_window_ << ", using " << kExecCoalesceWindow;
+    exec_coalesce_window_ = kExecCoalesceWindow;
+  }
+
+  if (event_timing_sample_rate_ <= 0) {
+    CLOG(ERROR) << "Invalid event timing sample rate " << event_timing_sample_rate_ << ", using " << kEventTimingSampleRate;
+    event_timing_sample_rate_ = kEventTimingSampleRate;
+  }
+
+  if (existing_processes_batch_size_ <= 0) {
+    CLOG(ERROR) << "Invalid existing processes batch size " << existing_processes_batch_size_ << ", using " << kExistingProcessesBatchSize;
+    existing_processes_batch_size_ = kExistingProcessesBatchSize;
+  }
+
+  if (existing_processes_rate_ < 0) {
+    CLOG(ERROR) << "Invalid existing processes rate " << existing_processes_rate_ << ", using " << kExistingProcessesRate;
+    existing_processes_rate_ = kExistingProcessesRate;
+  }
+
+  if (syscall_shedding_) {
+    CLOG(INFO) << "Overload-aware syscall shedding enabled";
+  }
+
+  if (enrichment_degradation_) {
+    CLOG(INFO) << "Overload-aware process enrichment degradation enabled";
+  }
+
+  if (signal_scheduler_) {
+    if (process_signal_bytes_per_second_ < 0) {
+      CLOG(ERROR) << "Invalid process signal bytes per second " << process_signal_bytes_per_second_ << ", using no limit";
+      process_signal_bytes_per_second_ = 0;
+    }
+    if (network_signal_bytes_per_second_ < 0) {
+      CLOG(ERROR) << "Invalid network signal bytes per second " << network_signal_bytes_per_second_ << ", using no limit";
+      network_signal_bytes_per_second_ = 0;
+    }
+    CLOG(INFO) << "Signal scheduler enabled, process signals priority: " << process_signal_priority_
+               << ", network priority: " << network_signal_priority_;
+  }
+
+  if (network_message_max_bytes_ < 0) {
+    CLOG(ERROR) << "Invalid network message max bytes " << network_message_max_bytes_ << ", using " << kNetworkMessageMaxBytes;
+    network_message_max_bytes_ = kNetworkMessageMaxBytes;
+  }
+
+  if (network_message_max_entries_ < 0) {
+    CLOG(ERROR) << "Invalid network message max entries " << network_message_max_entries_ << ", using no limit";
+    network_message_max_entries_ = 0;
+  }
+
+  if (IsReplay()) {
+    // The output of a replay must only depend on the capture, not on the host it runs on.
+    turn_off_scrape_ = true;
+    CLOG(INFO) << "Replaying capture " << replay_file_ << (replay_realtime_ ? " in real time" : " as fast as possible");
+  }
+
   HandleAfterglowEnvVars();
   HandleConnectionStatsEnvVars();
   HandleSinspEnvVars();
@@ -347,6 +535,24 @@ std::ostream& operator<<(std::ostream& os, const CollectorConfig& c) {
   return os
          << "collection_method:" << c.GetCollectionMethod()
          << ", scrape_interval:" << c.ScrapeInterval()
+         << ", adaptive_scrape:" << c.AdaptiveScrape()
+         << ", pipelined_dispatch:" << c.PipelinedDispatch()
+         << ", signal_queue_size:" << c.SignalQueueSize()
+         << ", signal_queue_drop_oldest:" << c.SignalQueueDropOldest()
+         << ", signal_replay_buffer_bytes:" << c.SignalReplayBufferBytes()
+         << ", exec_coalesce_window:" << c.ExecCoalesceWindow()
+         << ", syscall_shedding:" << c.SyscallShedding()
+         << ", enrichment_degradation:" << c.EnrichmentDegradation()
+         << ", signal_scheduler:" << c.EnableSignalScheduler()
+         << ", process_signal_priority:" << c.ProcessSignalPriority()
+         << ", network_signal_priority:" << c.NetworkSignalPriority()
+         << ", process_signal_bytes_per_second:" << c.ProcessSignalBytesPerSecond()
+         << ", network_signal_bytes_per_second:" << c.NetworkSignalBytesPerSecond()
+         << ", network_message_max_bytes:" << c.NetworkMessageMaxBytes()
+         << ", network_message_max_entries:" << c.NetworkMessageMaxEntries()
+         << ", replay_file:" << c.ReplayFile()
+         << ", signal_file:" << c.SignalFile()
+         << ", network_file:" << c.NetworkFile()
          << ", turn_off_scrape:" << c.TurnOffScrape()
          << ", hostname:" << c.Hostname()
          << ", processesListeningOnPorts:" << c.IsProcessesListeningOnPortsEnabled()
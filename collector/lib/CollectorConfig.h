@@ -20,6 +20,18 @@ class CollectorConfig {
  public:
   static constexpr bool kTurnOffScrape = false;
   static constexpr int kScrapeInterval = 30;
+  static constexpr int kScrapeIntervalMin = 10;
+  static constexpr int kScrapeIntervalMax = 120;
+  static constexpr int kPipelineQueueSize = 4096;
+  static constexpr int kSignalQueueSize = 4096;
+  static constexpr int kSignalReplayBufferBytes = 16 * 1024 * 1024;
+  static constexpr int kExecCoalesceWindow = 0;
+  static constexpr int kEventTimingSampleRate = 64;
+  static constexpr int kExistingProcessesBatchSize = 100;
+  static constexpr int kExistingProcessesRate = 5000;
+  static constexpr int kProcessSignalPriority = 1;
+  static constexpr int kNetworkSignalPriority = 0;
+  static constexpr int kNetworkMessageMaxBytes = 1024 * 1024;
   static constexpr CollectionMethod kCollectionMethod = CollectionMethod::CORE_BPF;
   static constexpr const char* kSyscalls[] = {
       "accept",
@@ -56,6 +68,32 @@ class CollectorConfig {
   bool TurnOffScrape() const;
   bool ScrapeListenEndpoints() const { return scrape_listen_endpoints_; }
   int ScrapeInterval() const;
+  bool AdaptiveScrape() const { return adaptive_scrape_; }
+  int ScrapeIntervalMin() const { return scrape_interval_min_; }
+  int ScrapeIntervalMax() const { return scrape_interval_max_; }
+  bool PipelinedDispatch() const { return pipelined_dispatch_; }
+  int PipelineQueueSize() const { return pipeline_queue_size_; }
+  int SignalQueueSize() const { return signal_queue_size_; }
+  bool SignalQueueDropOldest() const { return signal_queue_drop_oldest_; }
+  int SignalReplayBufferBytes() const { return signal_replay_buffer_bytes_; }
+  int ExecCoalesceWindow() const { return exec_coalesce_window_; }
+  int EventTimingSampleRate() const { return event_timing_sample_rate_; }
+  int ExistingProcessesBatchSize() const { return existing_processes_batch_size_; }
+  int ExistingProcessesRate() const { return existing_processes_rate_; }
+  bool SyscallShedding() const { return syscall_shedding_; }
+  bool EnrichmentDegradation() const { return enrichment_degradation_; }
+  bool EnableSignalScheduler() const { return signal_scheduler_; }
+  int ProcessSignalPriority() const { return process_signal_priority_; }
+  int NetworkSignalPriority() const { return network_signal_priority_; }
+  int ProcessSignalBytesPerSecond() const { return process_signal_bytes_per_second_; }
+  int NetworkSignalBytesPerSecond() const { return network_signal_bytes_per_second_; }
+  int NetworkMessageMaxBytes() const { return network_message_max_bytes_; }
+  int NetworkMessageMaxEntries() const { return network_message_max_entries_; }
+  bool IsReplay() const { return !replay_file_.empty(); }
+  const std::string& ReplayFile() const { return replay_file_; }
+  bool ReplayRealtime() const { return replay_realtime_; }
+  const std::string& SignalFile() const { return signal_file_; }
+  const std::string& NetworkFile() const { return network_file_; }
   std::string Hostname() const;
   std::string HostProc() const;
   CollectionMethod GetCollectionMethod() const;
@@ -85,6 +123,31 @@ class CollectorConfig {
 
  protected:
   int scrape_interval_;
+  bool adaptive_scrape_ = false;
+  int scrape_interval_min_ = kScrapeIntervalMin;
+  int scrape_interval_max_ = kScrapeIntervalMax;
+  bool pipelined_dispatch_ = false;
+  int pipeline_queue_size_ = kPipelineQueueSize;
+  int signal_queue_size_ = kSignalQueueSize;
+  bool signal_queue_drop_oldest_ = false;
+  int signal_replay_buffer_bytes_ = kSignalReplayBufferBytes;
+  int exec_coalesce_window_ = kExecCoalesceWindow;
+  int event_timing_sample_rate_ = kEventTimingSampleRate;
+  int existing_processes_batch_size_ = kExistingProcessesBatchSize;
+  int existing_processes_rate_ = kExistingProcessesRate;
+  bool syscall_shedding_ = false;
+  bool enrichment_degradation_ = false;
+  bool signal_scheduler_ = false;
+  int process_signal_priority_ = kProcessSignalPriority;
+  int network_signal_priority_ = kNetworkSignalPriority;
+  int process_signal_bytes_per_second_ = 0;
+  int network_signal_bytes_per_second_ = 0;
+  int network_message_max_bytes_ = kNetworkMessageMaxBytes;
+  int network_message_max_entries_ = 0;
+  std::string replay_file_;
+  bool replay_realtime_ = false;
+  std::string signal_file_;
+  std::string network_file_;
   CollectionMethod collection_method_;
   bool turn_off_scrape_;
   std::vector<std::string> syscalls_;
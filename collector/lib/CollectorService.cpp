@@ -4,12 +4,15 @@ extern "C" {
 #include <signal.h>
 }
 
+#include <array>
+#include <chrono>
 #include <memory>
 
 #include "CivetServer.h"
 #include "CollectorStatsExporter.h"
 #include "ConnTracker.h"
 #include "Containers.h"
+#include "DelimitedFileSink.h"
 #include "Diagnostics.h"
 #include "GRPCUtil.h"
 #include "GetKernelObject.h"
@@ -17,6 +20,8 @@ extern "C" {
 #include "LogLevel.h"
 #include "NetworkStatusNotifier.h"
 #include "ProfilerHandler.h"
+#include "Replay.h"
+#include "SignalScheduler.h"
 #include "SysdigService.h"
 #include "Utility.h"
 #include "prometheus/exposer.h"
@@ -69,13 +74,23 @@ void CollectorService::RunForever() {
     CLOG(INFO) << "Sensor connectivity is successful";
   }
 
+  std::shared_ptr<SignalScheduler> signal_scheduler;
+  if (config_.grpc_channel && config_.EnableSignalScheduler()) {
+    std::array<SignalScheduler::StreamConfig, SignalScheduler::NUM_STREAMS> streams;
+    streams[SignalScheduler::PROCESS].priority = config_.ProcessSignalPriority();
+    streams[SignalScheduler::PROCESS].bytes_per_second = config_.ProcessSignalBytesPerSecond();
+    streams[SignalScheduler::NETWORK].priority = config_.NetworkSignalPriority();
+    streams[SignalScheduler::NETWORK].bytes_per_second = config_.NetworkSignalBytesPerSecond();
+    signal_scheduler = std::make_shared<SignalScheduler>(streams);
+  }
+
   if (!config_.grpc_channel || !config_.DisableNetworkFlows()) {
     // In case if no GRPC is used, continue to setup networking infrasturcture
     // with empty grpc_channel. NetworkConnectionInfoServiceComm will pick it
     // up and use stdout instead.
     std::shared_ptr<ProcessStore> process_store;
     if (config_.IsProcessesListeningOnPortsEnabled()) {
-      process_store = std::make_shared<ProcessStore>(&sysdig_);
+      process_store = std::make_shared<ProcessStore>(&sysdig_, config_.HostProc());
     }
     std::shared_ptr<IConnScraper> conn_scraper = std::make_shared<ConnScraper>(config_.HostProc(), process_store);
     conn_tracker = std::make_shared<ConnectionTracker>();
@@ -84,7 +99,12 @@ void CollectorService::RunForever() {
     conn_tracker->UpdateIgnoredNetworks(config_.IgnoredNetworks());
     conn_tracker->EnableExternalIPs(config_.EnableExternalIPs());
 
-    auto network_connection_info_service_comm = std::make_shared<NetworkConnectionInfoServiceComm>(config_.Hostname(), config_.grpc_channel);
+    std::shared_ptr<DelimitedFileSink> network_file_sink;
+    if (!config_.grpc_channel && !config_.NetworkFile().empty()) {
+      network_file_sink = DelimitedFileSink::Open(config_.NetworkFile());
+    }
+    auto network_connection_info_service_comm = std::make_shared<NetworkConnectionInfoServiceComm>(config_.Hostname(), config_.grpc_channel,
+                                                                                                   std::move(network_file_sink));
 
     net_status_notifier = MakeUnique<NetworkStatusNotifier>(conn_scraper,
                                                             conn_tracker,
@@ -92,6 +112,7 @@ void CollectorService::RunForever() {
                                                             config_,
                                                             config_.EnableConnectionStats() ? exporter.GetConnectionsTotalReporter() : 0,
                                                             config_.EnableConnectionStats() ? exporter.GetConnectionsRateReporter() : 0);
+    net_status_notifier->SetSignalScheduler(signal_scheduler);
     net_status_notifier->Start();
   }
 
@@ -99,15 +120,25 @@ void CollectorService::RunForever() {
     CLOG(FATAL) << "Unable to start collector stats exporter";
   }
 
+  sysdig_.SetSignalScheduler(signal_scheduler);
   sysdig_.Init(config_, conn_tracker);
   sysdig_.Start();
+  auto start_time = std::chrono::steady_clock::now();
 
   ControlValue cv;
   while ((cv = control_->load(std::memory_order_relaxed)) != STOP_COLLECTOR) {
     sysdig_.Run(*control_);
+    if (sysdig_.CaptureEnded()) {
+      CLOG(INFO) << "Reached the end of the replayed capture";
+      break;
+    }
     CLOG(DEBUG) << "Interrupted collector!";
   }
 
+  if (config_.IsReplay()) {
+    LogReplayReport(std::chrono::steady_clock::now() - start_time);
+  }
+
   int signal = signum_.load();
 
   if (signal != 0) {
@@ -128,6 +159,31 @@ bool CollectorService::InitKernel(const DriverCandidate& candidate) {
   return sysdig_.InitKernel(config_, candidate);
 }
 
+bool CollectorService::InitReplay() {
+  return sysdig_.InitReplay(config_);
+}
+
+void CollectorService::LogReplayReport(std::chrono::nanoseconds duration) {
+  ReplayReport report;
+  report.duration = duration;
+
+  SysdigStats stats;
+  if (sysdig_.GetStats(&stats)) {
+    for (int i = 0; i < PPM_EVENT_MAX; i++) {
+      report.events += stats.nUserspaceEvents[i];
+      report.filtered_events += stats.nFilteredEvents[i];
+    }
+    report.process_signals = stats.nProcessSent;
+  }
+  report.handlers = sysdig_.GetHandlerStats();
+
+  const auto& collector_stats = CollectorStats::GetOrCreate();
+  report.network_updates = collector_stats.GetCounter(CollectorStats::net_conn_deltas) +
+                           collector_stats.GetCounter(CollectorStats::net_cep_deltas);
+
+  CLOG(INFO) << report;
+}
+
 bool CollectorService::WaitForGRPCServer() {
   std::string error_str;
   auto interrupt = [this] { return control_->load(std::memory_order_relaxed) == STOP_COLLECTOR; };
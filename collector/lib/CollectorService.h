@@ -1,6 +1,7 @@
 #ifndef _COLLECTOR_SERVICE_H_
 #define _COLLECTOR_SERVICE_H_
 
+#include <chrono>
 #include <vector>
 
 #include "CollectorConfig.h"
@@ -20,9 +21,11 @@ class CollectorService {
   void RunForever();
 
   bool InitKernel(const DriverCandidate& candidate);
+  bool InitReplay();
 
  private:
   bool WaitForGRPCServer();
+  void LogReplayReport(std::chrono::nanoseconds duration);
 
   CollectorConfig config_;
 
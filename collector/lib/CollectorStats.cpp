@@ -12,6 +12,11 @@ std::array<std::string, CollectorStats::counter_type_max> CollectorStats::counte
     COUNTER_NAMES};
 #undef X
 
+#define X(n) #n,
+std::array<std::string, CollectorStats::histogram_type_max> CollectorStats::histogram_type_to_name = {
+    HISTOGRAM_NAMES};
+#undef X
+
 CollectorStats& CollectorStats::GetOrCreate() {
   static CollectorStats stats;
 
@@ -26,6 +31,9 @@ void CollectorStats::Reset() {
   for (int i = 0; i < counter_type_max; i++) {
     CollectorStats::GetOrCreate().counter_[i] = 0;
   }
+  for (int i = 0; i < histogram_type_max; i++) {
+    CollectorStats::GetOrCreate().histogram_[i].Reset();
+  }
 }
 
 }  // namespace collector
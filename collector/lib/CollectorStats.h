@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "LatencyHistogram.h"
 #include "TimeUtil.h"
 
 #define TIMER_NAMES     \
@@ -14,7 +15,12 @@
   X(net_fetch_state)    \
   X(net_create_message) \
   X(net_write_message)  \
-  X(process_info_wait)
+  X(process_info_wait)  \
+  X(process_info_batch_wait)
+
+#define HISTOGRAM_NAMES   \
+  X(process_signal_write) \
+  X(network_status_write)
 
 #define COUNTER_NAMES                       \
   X(net_conn_updates)                       \
@@ -23,20 +29,72 @@
   X(net_cep_updates)                        \
   X(net_cep_deltas)                         \
   X(net_cep_inactive)                       \
+  X(net_messages)                           \
+  X(net_split_deltas)                       \
   X(net_known_ip_networks)                  \
   X(net_known_public_ips)                   \
+  X(net_scrape_interval_ms)                 \
+  X(net_scrape_interval_increased)          \
+  X(net_scrape_interval_decreased)          \
+  X(net_scrape_interval_unchanged)          \
+  X(net_scrape_missed_conns)                \
+  X(net_pipeline_queue_depth)               \
+  X(net_pipeline_queue_full)                \
+  X(net_pipeline_dropped)                   \
   X(process_lineage_counts)                 \
   X(process_lineage_total)                  \
   X(process_lineage_sqr_total)              \
   X(process_lineage_string_total)           \
   X(process_info_hit)                       \
   X(process_info_miss)                      \
-  X(rate_limit_flushing_counts)             \
+  X(process_info_batch_timeouts)            \
+  X(process_info_procfs_fallback)           \
+  X(process_keys_interned)                  \
+  X(process_store_full)                     \
+  X(process_pipeline_queue_depth)           \
+  X(process_pipeline_queue_full)            \
+  X(process_pipeline_dropped)               \
+  X(process_send_queue_depth)               \
+  X(process_send_queue_dropped)             \
+  X(process_send_batches)                   \
+  X(process_send_writes)                    \
+  X(process_replay_buffered)                \
+  X(process_replay_dropped)                 \
+  X(process_replay_sent)                    \
+  X(file_sink_records)                      \
+  X(file_sink_bytes)                        \
+  X(file_sink_errors)                       \
+  X(scheduler_priority_holds)               \
+  X(scheduler_budget_holds)                 \
+  X(scheduler_hold_micros)                  \
+  X(process_existing_remaining)             \
+  X(process_existing_resent)                \
+  X(process_existing_dropped)               \
+  X(container_cgroup_cache_hits)            \
+  X(container_cgroup_cache_misses)          \
+  X(container_cgroup_cache_flushes)         \
+  X(process_lineage_cache_hits)             \
+  X(process_lineage_cache_misses)           \
+  X(process_lineage_cache_flushes)          \
+  X(process_exec_coalesced)                 \
+  X(process_exec_summaries)                 \
+  X(rate_limit_evictions)                   \
+  X(syscall_shedding_level)                 \
+  X(syscall_shedding_escalations)           \
+  X(syscall_shedding_recoveries)            \
+  X(enrichment_tier)                        \
+  X(enrichment_escalations)                 \
+  X(enrichment_recoveries)                  \
+  X(process_signals_degraded)               \
   X(procfs_could_not_open_fd_dir)           \
   X(procfs_could_not_open_proc_dir)         \
   X(procfs_could_not_open_pid_dir)          \
   X(procfs_could_not_get_network_namespace) \
   X(procfs_could_not_get_socket_inodes)     \
+  X(procfs_fd_readlink_calls)               \
+  X(procfs_fd_walks_full)                   \
+  X(procfs_fd_walks_skipped)                \
+  X(procfs_fd_cache_fallbacks)              \
   X(procfs_could_not_read_exe)              \
   X(procfs_could_not_read_cmdline)          \
   X(event_timestamp_distant_past)           \
@@ -84,12 +142,25 @@ class CollectorStats {
     counter_[index] += val;
   }
 
+#define X(n) n,
+  enum HistogramType {
+    HISTOGRAM_NAMES
+        X(histogram_type_max)
+  };
+#undef X
+  static std::array<std::string, histogram_type_max> histogram_type_to_name;
+
+  inline LatencyHistogram& GetHistogram(size_t index) { return histogram_[index]; }
+  inline const LatencyHistogram& GetHistogram(size_t index) const { return histogram_[index]; }
+
  private:
   std::array<std::atomic<int64_t>, timer_type_max> timer_count_ = {{}};
   std::array<std::atomic<int64_t>, timer_type_max> timer_total_us_ = {{}};
 
   std::array<std::atomic<int64_t>, counter_type_max> counter_ = {{}};
 
+  std::array<LatencyHistogram, histogram_type_max> histogram_;
+
   CollectorStats(){};
 };
 
@@ -137,6 +208,8 @@ ScopedTimer<T> scoped_timer(T* timer_array, size_t index) {
 #define COUNTER_INC(i) COUNTER_ADD(i, 1)
 #define COUNTER_ZERO(i) COUNTER_SET(i, 0)
 
+#define HISTOGRAM_RECORD(i, micros) CollectorStats::GetOrCreate().GetHistogram(i).Record(micros);
+
 }  // namespace collector
 
 #endif  // COLLECTOR_COLLECTORSTATS_H
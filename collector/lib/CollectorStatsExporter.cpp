@@ -10,6 +10,7 @@
 #include "SysdigService.h"
 #include "Utility.h"
 #include "prometheus/gauge.h"
+#include "prometheus/histogram.h"
 #include "prometheus/summary.h"
 
 namespace collector {
@@ -104,6 +105,32 @@ class CollectorTimerGauge {
   prometheus::Gauge* times_us_avg_;
 };
 
+// Adds the durations recorded in a LatencyHistogram since the previous update to a prometheus histogram.
+class CollectorLatencyHistogram {
+ public:
+  CollectorLatencyHistogram(prometheus::Family<prometheus::Histogram>& family,
+                            const std::map<std::string, std::string>& labels,
+                            const LatencyHistogram& source)
+      : histogram_(&family.Add(labels, LatencyHistogram::Bounds())), source_(&source) {}
+
+  void Update() {
+    LatencyHistogram::Snapshot current;
+    source_->Read(&current);
+
+    std::vector<double> increments(LatencyHistogram::kNumBuckets);
+    for (size_t i = 0; i < LatencyHistogram::kNumBuckets; i++) {
+      increments[i] = current.counts[i] - last_.counts[i];
+    }
+    histogram_->ObserveMultiple(increments, current.sum_micros - last_.sum_micros);
+    last_ = current;
+  }
+
+ private:
+  prometheus::Histogram* histogram_;
+  const LatencyHistogram* source_;
+  LatencyHistogram::Snapshot last_;
+};
+
 void CollectorStatsExporter::run() {
   auto& collectorEventCounters = prometheus::BuildGauge()
                                      .Name("rox_collector_events")
@@ -143,6 +170,23 @@ void CollectorStatsExporter::run() {
     collector_counters[ct] = &(collector_counters_gauge.Add({{"type", CollectorStats::counter_type_to_name[ct]}}));
   }
 
+  auto& collector_histograms = prometheus::BuildHistogram()
+                                   .Name("rox_collector_write_latency_us")
+                                   .Help("Collector signal write latencies, in microseconds")
+                                   .Register(*registry_);
+  std::vector<std::unique_ptr<CollectorLatencyHistogram>> latencies;
+  for (int i = 0; i < CollectorStats::histogram_type_max; i++) {
+    auto ht = (CollectorStats::HistogramType)(i);
+    latencies.push_back(MakeUnique<CollectorLatencyHistogram>(collector_histograms,
+                                                              std::map<std::string, std::string>{{"type", CollectorStats::histogram_type_to_name[ht]}},
+                                                              CollectorStats::GetOrCreate().GetHistogram(ht)));
+  }
+
+  auto& collectorTypedEventLatencies = prometheus::BuildHistogram()
+                                           .Name("rox_collector_event_latency_us")
+                                           .Help("Collector event latencies by event type, in microseconds")
+                                           .Register(*registry_);
+
   auto& collectorTypedEventCounters = prometheus::BuildGauge()
                                           .Name("rox_collector_events_typed")
                                           .Help("Collector events by event type")
@@ -203,6 +247,16 @@ void CollectorStatsExporter::run() {
         std::map<std::string, std::string>{{"step", "parse"}, {"event_type", event_name}, {"event_dir", event_dir}});
     typed[i].process_micros_avg = &collectorTypedEventTimesAvg.Add(
         std::map<std::string, std::string>{{"step", "process"}, {"event_type", event_name}, {"event_dir", event_dir}});
+
+    const auto& event_latencies = sysdig_->GetEventLatencies(i);
+    latencies.push_back(MakeUnique<CollectorLatencyHistogram>(
+        collectorTypedEventLatencies,
+        std::map<std::string, std::string>{{"step", "queue"}, {"event_type", event_name}, {"event_dir", event_dir}},
+        event_latencies.queue));
+    latencies.push_back(MakeUnique<CollectorLatencyHistogram>(
+        collectorTypedEventLatencies,
+        std::map<std::string, std::string>{{"step", "handle"}, {"event_type", event_name}, {"event_dir", event_dir}},
+        event_latencies.handle));
   }
 
   while (thread_.Pause(std::chrono::seconds(5))) {
@@ -254,6 +308,9 @@ void CollectorStatsExporter::run() {
       auto ct = (CollectorStats::CounterType)(i);
       collector_counters[ct]->Set(CollectorStats::GetOrCreate().GetCounter(ct));
     }
+    for (auto& latency : latencies) {
+      latency->Update();
+    }
 
     int64_t lineage_count_stat = CollectorStats::GetOrCreate().GetCounter(CollectorStats::process_lineage_counts);
     int64_t lineage_count_total = CollectorStats::GetOrCreate().GetCounter(CollectorStats::process_lineage_total);
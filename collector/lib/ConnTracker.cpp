@@ -27,8 +27,15 @@ bool AdvertisedEndpointEquality::operator()(const ContainerEndpoint& lhs, const
     auto& rhs_originator = *rhs.originator();
 
     /* Here is the real difference with the comparator in ContainerEndpointMap.
-       We only compare attributes that are part of the serialized originator process object: storage::NetworkProcessUniqueKey */
-    if ((lhs_originator.comm() != rhs_originator.comm()) || (lhs_originator.exe_path() != rhs_originator.exe_path()) || (lhs_originator.args() != rhs_originator.args())) {
+       We only compare attributes that are part of the serialized originator process object: storage::NetworkProcessUniqueKey.
+       When both processes provide their interned key, these attributes are equal if and only if the keys are the same. */
+    const ProcessKey* lhs_key = lhs_originator.key();
+    const ProcessKey* rhs_key = rhs_originator.key();
+    if (lhs_key && rhs_key) {
+      if (lhs_key != rhs_key) {
+        return false;
+      }
+    } else if ((lhs_originator.comm() != rhs_originator.comm()) || (lhs_originator.exe_path() != rhs_originator.exe_path()) || (lhs_originator.args() != rhs_originator.args())) {
       return false;
     }
   }
@@ -46,11 +53,20 @@ void ConnectionTracker::UpdateConnection(const Connection& conn, int64_t timesta
   }
 }
 
-void ConnectionTracker::Update(
+size_t ConnectionTracker::Update(
     const std::vector<Connection>& all_conns,
     const std::vector<ContainerEndpoint>& all_listen_endpoints,
     int64_t timestamp) {
+  size_t missed = 0;
   WITH_LOCK(mutex_) {
+    // Count the scraped connections the event stream did not report as active
+    for (const auto& curr_conn : all_conns) {
+      auto it = conn_state_.find(curr_conn);
+      if (it == conn_state_.end() || !it->second.IsActive()) {
+        ++missed;
+      }
+    }
+
     // Mark all existing connections and listen endpoints as inactive
     for (auto& prev_conn : conn_state_) {
       prev_conn.second.SetActive(false);
@@ -69,6 +85,7 @@ void ConnectionTracker::Update(
       EmplaceOrUpdateNoLock(curr_endpoint, new_status);
     }
   }
+  return missed;
 }
 
 IPNet ConnectionTracker::NormalizeAddressNoLock(const Address& address) const {
@@ -92,7 +92,9 @@ class ConnectionTracker {
     UpdateConnection(conn, timestamp, false);
   }
 
-  void Update(const std::vector<Connection>& all_conns, const std::vector<ContainerEndpoint>& all_listen_endpoints, int64_t timestamp);
+  // Replace the set of active connections and listen endpoints with the result of a scrape. Returns the number of
+  // scraped connections which were not already known to be active, i.e., which the event stream has missed.
+  size_t Update(const std::vector<Connection>& all_conns, const std::vector<ContainerEndpoint>& all_listen_endpoints, int64_t timestamp);
 
   // Atomically fetch a snapshot of the current state, removing all inactive connections if requested.
   ConnMap FetchConnState(bool normalize = false, bool clear_inactive = true);
@@ -5,6 +5,8 @@
 #include "container_engine/container_engine_base.h"
 #include "threadinfo.h"
 
+#include "CgroupContainerCache.h"
+
 namespace collector {
 class ContainerEngine : public libsinsp::container_engine::container_engine_base {
  public:
@@ -12,16 +14,19 @@ class ContainerEngine : public libsinsp::container_engine::container_engine_base
 
   bool resolve(sinsp_threadinfo* tinfo, bool query_os_for_missing_info) override {
     for (const auto& cgroup : tinfo->cgroups()) {
-      auto container_id = ExtractContainerIDFromCgroup(cgroup.second);
+      const auto& container_id = cgroup_cache_.Resolve(cgroup.second);
 
-      if (container_id) {
-        tinfo->m_container_id = *container_id;
+      if (!container_id.empty()) {
+        tinfo->m_container_id = container_id;
         return true;
       }
     }
 
     return false;
   }
+
+ private:
+  CgroupContainerCache cgroup_cache_;
 };
 }  // namespace collector
 
@@ -0,0 +1,123 @@
+#include "DelimitedFileSink.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include "CollectorStats.h"
+#include "Logging.h"
+#include "Utility.h"
+
+namespace collector {
+
+constexpr size_t DelimitedFileSink::kDefaultBufferSize;
+constexpr std::chrono::seconds DelimitedFileSink::kFlushInterval;
+
+using google::protobuf::io::CodedOutputStream;
+
+std::unique_ptr<DelimitedFileSink> DelimitedFileSink::Open(const std::string& path, size_t buffer_size) {
+  FDHandle fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600));
+  if (!fd.valid()) {
+    CLOG(ERROR) << "Failed to open " << path << ": " << StrError();
+    return nullptr;
+  }
+  return std::unique_ptr<DelimitedFileSink>(new DelimitedFileSink(path, std::move(fd), buffer_size));
+}
+
+DelimitedFileSink::DelimitedFileSink(std::string path, FDHandle fd, size_t buffer_size)
+    : path_(std::move(path)), fd_(std::move(fd)), buffer_(buffer_size),
+      next_flush_(std::chrono::steady_clock::now() + kFlushInterval) {
+  flusher_.Start(&DelimitedFileSink::RunFlusher, this);
+}
+
+DelimitedFileSink::~DelimitedFileSink() {
+  flusher_.Stop();
+  Flush();
+}
+
+void DelimitedFileSink::RunFlusher() {
+  for (;;) {
+    std::chrono::steady_clock::duration wait;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto now = std::chrono::steady_clock::now();
+      if (now >= next_flush_) {
+        FlushLocked();
+      }
+      wait = next_flush_ - now;
+    }
+    if (!flusher_.Pause(std::chrono::duration_cast<std::chrono::system_clock::duration>(wait))) {
+      return;
+    }
+  }
+}
+
+bool DelimitedFileSink::Write(const google::protobuf::MessageLite& msg) {
+  size_t size = msg.ByteSizeLong();
+  size_t record_size = CodedOutputStream::VarintSize32(size) + size;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool ok = true;
+  if (used_ + record_size > buffer_.size()) {
+    ok = FlushLocked();
+  }
+
+  if (record_size > buffer_.size()) {
+    large_record_.resize(record_size);
+    auto* target = reinterpret_cast<uint8_t*>(&large_record_[0]);
+    target = CodedOutputStream::WriteVarint32ToArray(size, target);
+    msg.SerializeWithCachedSizesToArray(target);
+    ok = WriteOut(reinterpret_cast<const uint8_t*>(large_record_.data()), record_size) && ok;
+  } else {
+    uint8_t* target = buffer_.data() + used_;
+    target = CodedOutputStream::WriteVarint32ToArray(size, target);
+    msg.SerializeWithCachedSizesToArray(target);
+    used_ += record_size;
+  }
+  COUNTER_INC(CollectorStats::file_sink_records);
+  COUNTER_ADD(CollectorStats::file_sink_bytes, record_size);
+
+  if (std::chrono::steady_clock::now() >= next_flush_) {
+    ok = FlushLocked() && ok;
+  }
+  return ok;
+}
+
+bool DelimitedFileSink::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return FlushLocked();
+}
+
+bool DelimitedFileSink::FlushLocked() {
+  next_flush_ = std::chrono::steady_clock::now() + kFlushInterval;
+  if (used_ == 0) return true;
+
+  bool ok = WriteOut(buffer_.data(), used_);
+  used_ = 0;
+  return ok;
+}
+
+bool DelimitedFileSink::WriteOut(const uint8_t* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(fd_.get(), data, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      COUNTER_INC(CollectorStats::file_sink_errors);
+      if (errno == EPIPE) {
+        CLOG_THROTTLED(ERROR, std::chrono::seconds(10)) << "The reader of " << path_ << " went away";
+        return false;
+      }
+      CLOG_THROTTLED(ERROR, std::chrono::seconds(10)) << "Failed to write to " << path_ << ": " << StrError();
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace collector
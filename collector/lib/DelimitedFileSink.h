@@ -0,0 +1,67 @@
+#ifndef COLLECTOR_DELIMITEDFILESINK_H
+#define COLLECTOR_DELIMITEDFILESINK_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/message_lite.h>
+
+#include "FileSystem.h"
+#include "StoppableThread.h"
+
+namespace collector {
+
+// DelimitedFileSink writes protobuf messages to a file or a named pipe, as a stream of records each prefixed
+// with its size as a varint. This is the framing of google::protobuf::util::SerializeDelimitedToOstream, so the
+// records can be read back with ParseDelimitedFromZeroCopyStream, as the signal-reader tool does.
+//
+// Records are serialized straight into a large buffer, which is written out when full, and at least every
+// kFlushInterval so that a reader on a pipe does not wait for long: a background thread flushes the records
+// left in the buffer once writes stop. A pipe whose reader went away fails the writes with EPIPE, as
+// collector ignores SIGPIPE.
+//
+// Thread-safe.
+class DelimitedFileSink {
+ public:
+  static constexpr size_t kDefaultBufferSize = 1 << 20;
+  static constexpr std::chrono::seconds kFlushInterval{1};
+
+  // Opens the file for appending, creating it if needed. Opening a named pipe blocks until it has a reader.
+  // Returns null if the file cannot be opened.
+  static std::unique_ptr<DelimitedFileSink> Open(const std::string& path, size_t buffer_size = kDefaultBufferSize);
+
+  ~DelimitedFileSink();
+
+  // Returns false if buffered records could not be written out.
+  bool Write(const google::protobuf::MessageLite& msg);
+  bool Flush();
+
+  const std::string& Path() const { return path_; }
+
+ private:
+  DelimitedFileSink(std::string path, FDHandle fd, size_t buffer_size);
+
+  bool WriteOut(const uint8_t* data, size_t size);
+  bool FlushLocked();
+  void RunFlusher();
+
+  std::string path_;
+  FDHandle fd_;
+
+  std::mutex mutex_;
+  std::vector<uint8_t> buffer_;
+  size_t used_ = 0;
+  std::chrono::steady_clock::time_point next_flush_;
+  // A record larger than the buffer is serialized here, and written out on its own.
+  std::string large_record_;
+
+  StoppableThread flusher_;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_DELIMITEDFILESINK_H
@@ -7,6 +7,7 @@
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/support/async_stream.h>
 
+#include "DelimitedFileSink.h"
 #include "Logging.h"
 
 // This file defines an alternative client interface for bidirectional GRPC streams. The interface supports:
@@ -296,6 +297,12 @@ class IDuplexClientWriter : public virtual IDuplexClient {
   virtual Result Write(const W& obj, const gpr_timespec& deadline) = 0;
   virtual Result WriteAsync(const W& obj) = 0;
 
+  // Waits until the pending asynchronous write, if any, completed. Writers which complete their writes
+  // synchronously are always writable.
+  virtual Result WaitUntilWritable(const gpr_timespec& deadline) {
+    return Result(Status::OK);
+  }
+
   // Templated methods
 
   template <typename TS = time_point>
@@ -303,6 +310,11 @@ class IDuplexClientWriter : public virtual IDuplexClient {
                const TS& time_spec = time_point::max()) {
     return Write(obj, ToDeadline(time_spec));
   }
+
+  template <typename TS = time_point>
+  Result WaitUntilWritable(const TS& time_spec = time_point::max()) {
+    return WaitUntilWritable(ToDeadline(time_spec));
+  }
 };
 
 // Base class for duplex clients.
@@ -535,10 +547,34 @@ class DuplexClientWriter : public DuplexClient, public IDuplexClientWriter<W> {
     return Result(WriteAsyncInternal(obj));
   }
 
+  // Asynchronous write with options. A write with a buffer hint may complete before the message is sent, GRPC
+  // can then coalesce it with the next writes.
+  Result WriteAsync(const W& obj, grpc::WriteOptions options) {
+    return Result(WriteAsyncInternal(obj, options));
+  }
+
+  // Waits until the pending asynchronous write, if any, completed. Fails if the stream had an error.
+  Result WaitUntilWritable(const gpr_timespec& deadline) {
+    Result res(Status::OK);
+    if (CheckFlags(Pending(Op::WRITE))) {
+      res = Poll([](Flags fl) { return (fl & Pending(Op::WRITE)) == 0 || (fl & STREAM_ERROR) != 0; }, deadline);
+    }
+    if (res && CheckFlags(STREAM_ERROR)) {
+      return Result(Status::ERROR);
+    }
+    return res;
+  }
+
+  template <typename TS = time_point>
+  Result WaitUntilWritable(const TS& time_spec = time_point::max()) {
+    return WaitUntilWritable(ToDeadline(time_spec));
+  }
+
  protected:
   DuplexClientWriter(grpc::ClientContext* context) : DuplexClient(context) {}
 
   virtual OpDescriptor WriteAsyncInternal(const W& obj) = 0;
+  virtual OpDescriptor WriteAsyncInternal(const W& obj, grpc::WriteOptions options) = 0;
 };
 
 template <typename W, typename R>
@@ -637,6 +673,10 @@ class DuplexClientReaderWriter : public DuplexClientWriter<W> {
     return DoAsync<const W&>(&RW::Write, obj, Op::WRITE);
   }
 
+  OpDescriptor WriteAsyncInternal(const W& obj, grpc::WriteOptions options) override {
+    return DoAsync<const W&, grpc::WriteOptions>(&RW::Write, obj, options, Op::WRITE);
+  }
+
   OpDescriptor WritesDoneAsyncInternal() override {
     return DoAsync<>(&RW::WritesDone, Op::WRITES_DONE);
   }
@@ -726,16 +766,16 @@ class StdoutDuplexClientWriter : public IDuplexClientWriter<W> {
   // Write methods.
 
   Result Write(const W& obj, const gpr_timespec& deadline) {
-    std::string output;
-    google::protobuf::util::MessageToJsonString(obj, &output, google::protobuf::util::JsonPrintOptions{});
-    CLOG(DEBUG) << "GRPC: " << output;
-    return Result(Status::OK);
+    return WriteAsync(obj);
   }
 
   Result WriteAsync(const W& obj) {
-    std::string output;
-    google::protobuf::util::MessageToJsonString(obj, &output, google::protobuf::util::JsonPrintOptions{});
-    CLOG(DEBUG) << "GRPC: " << output;
+    // The conversion to JSON costs more than building the message, skip it unless it is logged.
+    if (CLOG_ENABLED(DEBUG)) {
+      std::string output;
+      google::protobuf::util::MessageToJsonString(obj, &output, google::protobuf::util::JsonPrintOptions{});
+      CLOG(DEBUG) << "GRPC: " << output;
+    }
     return Result(Status::OK);
   }
 
@@ -787,6 +827,24 @@ class StdoutDuplexClientWriter : public IDuplexClientWriter<W> {
   // virtual OpDescriptor WriteAsyncInternal(const W& obj) = 0;
 };
 
+// Writes the messages to a file, as size-delimited records, instead of a stream. Nothing is ever read.
+template <typename W>
+class FileDuplexClientWriter : public StdoutDuplexClientWriter<W> {
+ public:
+  explicit FileDuplexClientWriter(std::shared_ptr<DelimitedFileSink> sink) : sink_(std::move(sink)) {}
+
+  Result Write(const W& obj, const gpr_timespec& deadline) override {
+    return WriteAsync(obj);
+  }
+
+  Result WriteAsync(const W& obj) override {
+    return Result(sink_->Write(obj) ? Status::OK : Status::ERROR);
+  }
+
+ private:
+  std::shared_ptr<DelimitedFileSink> sink_;
+};
+
 }  // namespace grpc_duplex_impl
 
 // Export public definitions.
@@ -0,0 +1,49 @@
+#include "EnrichmentDegrader.h"
+
+#include "CollectorStats.h"
+#include "Logging.h"
+
+namespace collector {
+
+constexpr int EnrichmentDegrader::kFull;
+constexpr int EnrichmentDegrader::kParentLineage;
+constexpr int EnrichmentDegrader::kTruncatedArgs;
+constexpr int EnrichmentDegrader::kMinimal;
+constexpr size_t EnrichmentDegrader::kTruncatedArgsLength;
+constexpr std::chrono::microseconds EnrichmentDegrader::kHighLag;
+constexpr std::chrono::microseconds EnrichmentDegrader::kLowLag;
+constexpr int EnrichmentDegrader::kSustainedWindows;
+constexpr int EnrichmentDegrader::kRecoveryWindows;
+
+EnrichmentDegrader::EnrichmentDegrader() {
+  COUNTER_SET(CollectorStats::enrichment_tier, kFull);
+}
+
+int EnrichmentDegrader::Update(std::chrono::microseconds max_lag) {
+  if (max_lag >= kHighLag) {
+    calm_windows_ = 0;
+    if (++lagging_windows_ >= kSustainedWindows && tier_ < kMinimal) {
+      lagging_windows_ = 0;
+      tier_++;
+      COUNTER_INC(CollectorStats::enrichment_escalations);
+      CLOG(WARNING) << "Events are handled late (lag " << max_lag.count()
+                    << "us), degrading process enrichment: tier " << tier_;
+    }
+  } else if (max_lag < kLowLag) {
+    lagging_windows_ = 0;
+    if (++calm_windows_ >= kRecoveryWindows && tier_ > kFull) {
+      calm_windows_ = 0;
+      tier_--;
+      COUNTER_INC(CollectorStats::enrichment_recoveries);
+      CLOG(INFO) << "Event handling lag has subsided, restoring process enrichment: tier " << tier_;
+    }
+  } else {
+    lagging_windows_ = 0;
+    calm_windows_ = 0;
+  }
+
+  COUNTER_SET(CollectorStats::enrichment_tier, tier_);
+  return tier_;
+}
+
+}  // namespace collector
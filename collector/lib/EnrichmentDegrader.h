@@ -0,0 +1,52 @@
+#ifndef COLLECTOR_ENRICHMENTDEGRADER_H
+#define COLLECTOR_ENRICHMENTDEGRADER_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace collector {
+
+// EnrichmentDegrader decides how much of the details of process signals is collected while events are
+// handled late, so that the event thread spends less time per exec and keeps draining the ring buffers
+// rather than letting the kernel drop whole events.
+//
+// It is fed, about once per second, with the largest delay observed between an event being emitted and
+// being handled. After kSustainedWindows lagging windows in a row, the next tier is entered; after
+// kRecoveryWindows calm windows in a row, the previous one is restored. Every decision is reported
+// through the enrichment_* counters.
+class EnrichmentDegrader {
+ public:
+  // Full details.
+  static constexpr int kFull = 0;
+  // The lineage is limited to the parent.
+  static constexpr int kParentLineage = 1;
+  // As above, and the arguments are truncated to kTruncatedArgsLength.
+  static constexpr int kTruncatedArgs = 2;
+  // Neither lineage nor arguments. Credentials are always kept, policies rely on them.
+  static constexpr int kMinimal = 3;
+
+  static constexpr size_t kTruncatedArgsLength = 256;
+
+  // Event handling delay above which a window is lagging.
+  static constexpr std::chrono::microseconds kHighLag = std::chrono::seconds(1);
+  // Event handling delay below which a window is calm.
+  static constexpr std::chrono::microseconds kLowLag = std::chrono::milliseconds(250);
+  static constexpr int kSustainedWindows = 2;
+  static constexpr int kRecoveryWindows = 10;
+
+  EnrichmentDegrader();
+
+  // Records the largest handling delay observed since the previous call. Returns the tier to apply.
+  int Update(std::chrono::microseconds max_lag);
+
+  int Tier() const { return tier_; }
+
+ private:
+  int tier_ = kFull;
+  int lagging_windows_ = 0;
+  int calm_windows_ = 0;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_ENRICHMENTDEGRADER_H
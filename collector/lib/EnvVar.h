@@ -9,6 +9,7 @@
 #include <cctype>
 #include <cstdlib>
 #include <mutex>
+#include <string>
 #include <utility>
 
 #include "Logging.h"
@@ -61,6 +62,25 @@ struct ParseBool {
   }
 };
 
+struct ParseInt {
+  bool operator()(int* out, const std::string& str_val) const {
+    try {
+      size_t pos;
+      *out = std::stoi(str_val, &pos);
+      return pos == str_val.size();
+    } catch (...) {
+      return false;
+    }
+  }
+};
+
+struct ParseString {
+  bool operator()(std::string* out, const std::string& str_val) const {
+    *out = str_val;
+    return true;
+  }
+};
+
 struct ParseStringList {
   bool operator()(std::vector<std::string>* out, std::string str_val) {
     *out = SplitStringView(std::string_view(str_val), ',');
@@ -71,6 +91,8 @@ struct ParseStringList {
 }  // namespace internal
 
 using BoolEnvVar = EnvVar<bool, internal::ParseBool>;
+using IntEnvVar = EnvVar<int, internal::ParseInt>;
+using StringEnvVar = EnvVar<std::string, internal::ParseString>;
 using StringListEnvVar = EnvVar<std::vector<std::string>, internal::ParseStringList>;
 
 }  // namespace collector
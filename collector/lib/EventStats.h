@@ -0,0 +1,98 @@
+#ifndef COLLECTOR_EVENTSTATS_H
+#define COLLECTOR_EVENTSTATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <time.h>
+
+#include "LatencyHistogram.h"
+#include "ppm_events_public.h"
+
+namespace collector {
+
+// EventCounters holds the counters kept by the event thread for every event type.
+//
+// Each counter has a single writer, the event thread, which updates it with a relaxed load and store
+// rather than an atomic read-modify-write, so an update costs as much as a plain increment. Other threads
+// may read the counters at any time without locking. The counters of an event type share a cache line,
+// so accounting for an event touches a single line.
+class EventCounters {
+ public:
+  struct alignas(32) Counters {
+    std::atomic<uint64_t> userspace{0};       // events processed by userspace
+    std::atomic<uint64_t> filtered{0};        // events post filtering
+    std::atomic<uint64_t> parse_micros{0};    // (estimated) total microseconds spent parsing
+    std::atomic<uint64_t> process_micros{0};  // (estimated) total microseconds spent in signal handlers
+  };
+
+  // Must only be called from the single writer of counter.
+  static void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  Counters& operator[](uint16_t event_type) { return counters_[event_type]; }
+  const Counters& operator[](uint16_t event_type) const { return counters_[event_type]; }
+
+ private:
+  std::array<Counters, PPM_EVENT_MAX> counters_;
+};
+
+// EventTimingSampler selects the events whose parsing and handling is timed: one in every `rate` events.
+// Durations measured on sampled events are scaled by the rate, so accumulated totals remain estimates
+// of the time spent on all events.
+class EventTimingSampler {
+ public:
+  // The rate is rounded up to a power of two. A rate of 1 times every event.
+  explicit EventTimingSampler(uint32_t rate = 1) : mask_(1) {
+    while (mask_ < rate) {
+      mask_ <<= 1;
+    }
+    mask_ -= 1;
+  }
+
+  bool Sample() { return (count_++ & mask_) == 0; }
+
+  uint64_t Rate() const { return mask_ + 1; }
+
+  // The estimated total, in microseconds, represented by a duration measured on a sampled event.
+  uint64_t ScaledMicros(int64_t sampled_nanos) const { return sampled_nanos * Rate() / 1000; }
+
+  // A monotonic clock, read through the vDSO. Reading the TSC directly would be cheaper, but is not
+  // portable to all the architectures we support.
+  static int64_t NowNanos() {
+    return std::chrono::steady_clock::now().time_since_epoch() / std::chrono::nanoseconds(1);
+  }
+
+  // CPU time consumed by the calling thread. Unlike NowNanos, this costs a system call.
+  static int64_t ThreadCpuNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+ private:
+  uint64_t count_ = 0;
+  uint64_t mask_;
+};
+
+// The latency histograms of an event type, recorded on sampled events: how long its events waited to be
+// read from the ring buffer (queue), and how long they took to be handled once read (handle).
+struct EventLatencies {
+  LatencyHistogram queue;
+  LatencyHistogram handle;
+};
+
+// Estimated work done by a signal handler on the event thread, accumulated over sampled events.
+struct HandlerStats {
+  std::string name;
+  uint64_t calls = 0;
+  uint64_t cpu_micros = 0;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_EVENTSTATS_H
@@ -0,0 +1,57 @@
+#include "ExecCoalescer.h"
+
+#include "CollectorStats.h"
+
+namespace collector {
+
+constexpr size_t ExecCoalescer::kDefaultMaxKeys;
+
+ExecCoalescer::Summary* ExecCoalescer::Coalesce(const Hash128& key, uint64_t ts) {
+  auto it = windows_.find(key);
+  if (it == windows_.end() || ts >= it->second.end_ts) {
+    return nullptr;
+  }
+
+  Summary& summary = it->second.summary;
+  summary.count++;
+  summary.last_ts = ts;
+  COUNTER_INC(CollectorStats::process_exec_coalesced);
+  return &summary;
+}
+
+void ExecCoalescer::Open(const Hash128& key, uint64_t ts) {
+  if (windows_.size() >= max_keys_ || windows_.find(key) != windows_.end()) {
+    return;
+  }
+
+  Window& window = windows_[key];
+  window.end_ts = ts + window_ns_;
+  window.summary.key = key;
+  window.summary.count = 0;
+  window.summary.first_ts = ts;
+  window.summary.last_ts = ts;
+  order_.push_back(key);
+}
+
+bool ExecCoalescer::NextSummary(uint64_t ts, Summary* summary) {
+  while (!order_.empty()) {
+    auto it = windows_.find(order_.front());
+    if (it->second.end_ts > ts) {
+      return false;
+    }
+
+    order_.pop_front();
+    bool coalesced = it->second.summary.count > 0;
+    if (coalesced) {
+      *summary = std::move(it->second.summary);
+    }
+    windows_.erase(it);
+    if (coalesced) {
+      COUNTER_INC(CollectorStats::process_exec_summaries);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace collector
@@ -0,0 +1,79 @@
+#ifndef COLLECTOR_EXECCOALESCER_H
+#define COLLECTOR_EXECCOALESCER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+#include "internalapi/sensor/signal_iservice.pb.h"
+
+#include "Hash.h"
+
+namespace collector {
+
+// ExecCoalescer recognizes bursts of identical execs, as run by shell scripts and health check loops, so
+// that only the first exec of a burst and a summary of the others are formatted and sent.
+//
+// The first exec of a key opens a window, of a fixed length, during which the other execs of the key are
+// only counted. Once the window has ended, its summary holds the signal of the first coalesced exec, to be
+// sent with the time of the last one, along with the number of coalesced execs. The next exec of the key
+// opens a new window. Timestamps are those of the events, in nanoseconds.
+//
+// The number of open windows is bounded: when it is reached, the execs of new keys are not coalesced.
+//
+// Not thread-safe.
+class ExecCoalescer {
+ public:
+  using SignalStreamMessage = sensor::SignalStreamMessage;
+
+  static constexpr size_t kDefaultMaxKeys = 4096;
+
+  struct Summary {
+    Hash128 key;
+    // The signal of the first coalesced exec, set by the caller.
+    SignalStreamMessage signal_msg;
+    // The number of execs which were coalesced, not counting the one which opened the window.
+    uint64_t count;
+    // The timestamps of the exec which opened the window and of the last coalesced one.
+    uint64_t first_ts;
+    uint64_t last_ts;
+  };
+
+  explicit ExecCoalescer(uint64_t window_ns, size_t max_keys = kDefaultMaxKeys)
+      : window_ns_(window_ns), max_keys_(max_keys) {}
+
+  // Returns the summary of the open window of the key if the exec falls into it, in which case it has been
+  // counted and must not be sent, or null. The caller sets the signal of the summary on the first coalesced
+  // exec, when the count is 1.
+  Summary* Coalesce(const Hash128& key, uint64_t ts);
+
+  // Opens a window for the key, on an exec which is sent as usual.
+  void Open(const Hash128& key, uint64_t ts);
+
+  // Closes the windows which ended before ts, until one of them coalesced execs, whose summary is returned.
+  // Returns false when no such window is left.
+  bool NextSummary(uint64_t ts, Summary* summary);
+
+  size_t Size() const { return windows_.size(); }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Hash128& key) const { return key.low; }
+  };
+
+  struct Window {
+    uint64_t end_ts;
+    Summary summary;
+  };
+
+  uint64_t window_ns_;
+  size_t max_keys_;
+  std::unordered_map<Hash128, Window, KeyHash> windows_;
+  // The keys of the open windows, in the order they were opened, which is also the order they end.
+  std::deque<Hash128> order_;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_EXECCOALESCER_H
@@ -0,0 +1,51 @@
+#include "ExistingProcessCursor.h"
+
+#include <algorithm>
+
+#include "CollectorStats.h"
+
+namespace collector {
+
+ExistingProcessCursor::ExistingProcessCursor(size_t batch_size, size_t rate)
+    : batch_size_(std::max<size_t>(batch_size, 1)), rate_(rate) {}
+
+void ExistingProcessCursor::Start(SignalHandler* handler, std::vector<int64_t> tids, int64_t now_micros) {
+  handler_ = handler;
+  tids_ = std::move(tids);
+  next_ = 0;
+  start_micros_ = now_micros;
+  COUNTER_SET(CollectorStats::process_existing_remaining, Remaining());
+}
+
+void ExistingProcessCursor::Stop() {
+  handler_ = nullptr;
+  tids_.clear();
+  next_ = 0;
+  COUNTER_SET(CollectorStats::process_existing_remaining, 0);
+}
+
+void ExistingProcessCursor::NextBatch(int64_t now_micros, std::vector<int64_t>* batch) {
+  batch->clear();
+  if (!Active()) {
+    return;
+  }
+
+  size_t count = std::min(batch_size_, Remaining());
+  if (rate_ > 0) {
+    int64_t elapsed_micros = std::max<int64_t>(now_micros - start_micros_, 0);
+    size_t allowed = batch_size_ + static_cast<size_t>(elapsed_micros * rate_ / 1000000);
+    count = std::min(count, allowed > next_ ? allowed - next_ : 0);
+  }
+
+  batch->assign(tids_.begin() + next_, tids_.begin() + next_ + count);
+  next_ += count;
+  COUNTER_ADD(CollectorStats::process_existing_resent, count);
+
+  if (Remaining() == 0) {
+    Stop();
+  } else if (count > 0) {
+    COUNTER_SET(CollectorStats::process_existing_remaining, Remaining());
+  }
+}
+
+}  // namespace collector
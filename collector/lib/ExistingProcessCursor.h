@@ -0,0 +1,47 @@
+#ifndef COLLECTOR_EXISTINGPROCESSCURSOR_H
+#define COLLECTOR_EXISTINGPROCESSCURSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace collector {
+
+class SignalHandler;
+
+// ExistingProcessCursor tracks the progress of sending the processes which already exist to a signal
+// handler, typically after the stream to Sensor was (re)established.
+//
+// Rather than going through the whole thread table at once, which would stop the consumption of the
+// kernel buffers for as long as it takes to format and write every signal, the event thread takes a
+// snapshot of the thread ids and sends them in batches of at most batch_size between two events. The
+// total number of processes sent is kept below rate per second (after an initial batch), so Sensor is not
+// flooded either. A rate of 0 disables the limit.
+class ExistingProcessCursor {
+ public:
+  explicit ExistingProcessCursor(size_t batch_size = 1, size_t rate = 0);
+
+  void Start(SignalHandler* handler, std::vector<int64_t> tids, int64_t now_micros);
+  void Stop();
+
+  bool Active() const { return handler_ != nullptr; }
+  SignalHandler* Handler() const { return handler_; }
+  size_t Remaining() const { return tids_.size() - next_; }
+
+  // Fills batch with the thread ids to send now, which may be none when the rate is exceeded, and
+  // advances past them. The cursor stops once all thread ids were taken.
+  void NextBatch(int64_t now_micros, std::vector<int64_t>* batch);
+
+ private:
+  size_t batch_size_;
+  size_t rate_;
+
+  SignalHandler* handler_ = nullptr;
+  std::vector<int64_t> tids_;
+  size_t next_ = 0;
+  int64_t start_micros_ = 0;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_EXISTINGPROCESSCURSOR_H
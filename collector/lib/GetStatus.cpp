@@ -4,6 +4,8 @@
 
 #include <json/json.h>
 
+#include "LoadShedder.h"
+
 namespace collector {
 
 bool GetStatus::handleGet(CivetServer* server, struct mg_connection* conn) {
@@ -21,6 +23,13 @@ bool GetStatus::handleGet(CivetServer* server, struct mg_connection* conn) {
     status["collector"]["events"] = Json::UInt64(stats.nEvents);
     status["collector"]["drops"] = Json::UInt64(stats.nDrops);
     status["collector"]["preemptions"] = Json::UInt64(stats.nPreemptions);
+    status["collector"]["syscall_shedding_level"] = Json::UInt64(stats.nSyscallSheddingLevel);
+
+    Json::Value shed_syscalls(Json::arrayValue);
+    for (const auto& syscall : LoadShedder::SyscallsShedAt(stats.nSyscallSheddingLevel)) {
+      shed_syscalls.append(syscall);
+    }
+    status["collector"]["shed_syscalls"] = shed_syscalls;
 
     mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n");
     mg_printf(conn, "%s\n", status.toStyledString().c_str());
@@ -2,6 +2,9 @@
 #define COLLECTOR_HASH_H
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -94,6 +97,95 @@ size_t HashAll(const FirstArg& first, const RestArgs&... rest) {
   return CombineHashes(Hasher()(first), HashAll(rest...));
 }
 
+// A 128-bit hash value.
+struct Hash128 {
+  uint64_t low = 0;
+  uint64_t high = 0;
+
+  bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+  bool operator!=(const Hash128& other) const { return !(*this == other); }
+};
+
+// StreamingHash128 computes a 128-bit hash over a sequence of fields, with the mixing functions of MurmurHash3
+// (x64, 128 bits), without copying the fields into a single buffer. Each field is hashed along with its length,
+// so that ("ab", "c") and ("a", "bc") hash differently. The values are not stable across architectures, they
+// must not be persisted.
+class StreamingHash128 {
+ public:
+  explicit StreamingHash128(uint64_t seed = 0) : h1_(seed), h2_(seed) {}
+
+  StreamingHash128& Add(const char* data, size_t len) {
+    total_len_ += len;
+    for (; len >= 16; data += 16, len -= 16) {
+      uint64_t k1, k2;
+      std::memcpy(&k1, data, 8);
+      std::memcpy(&k2, data + 8, 8);
+      MixBlock(k1, k2);
+    }
+
+    // The remaining 0 to 15 bytes, zero padded, and their count in the last byte.
+    uint64_t k1 = 0, k2 = 0;
+    std::memcpy(&k1, data, std::min<size_t>(len, 8));
+    if (len > 8) {
+      std::memcpy(&k2, data + 8, len - 8);
+    }
+    k2 ^= static_cast<uint64_t>(len) << 56;
+    MixBlock(k1, k2);
+    return *this;
+  }
+
+  StreamingHash128& Add(const std::string& field) { return Add(field.data(), field.size()); }
+
+  Hash128 Finish() const {
+    uint64_t h1 = h1_ ^ total_len_;
+    uint64_t h2 = h2_ ^ total_len_;
+    h1 += h2;
+    h2 += h1;
+    h1 = FinalMix(h1);
+    h2 = FinalMix(h2);
+    h1 += h2;
+    h2 += h1;
+    return Hash128{h1, h2};
+  }
+
+ private:
+  static constexpr uint64_t kC1 = 0x87c37b91114253d5ULL;
+  static constexpr uint64_t kC2 = 0x4cf5ad432745937fULL;
+
+  static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  static uint64_t FinalMix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+  }
+
+  void MixBlock(uint64_t k1, uint64_t k2) {
+    k1 *= kC1;
+    k1 = Rotl(k1, 31);
+    k1 *= kC2;
+    h1_ ^= k1;
+    h1_ = Rotl(h1_, 27);
+    h1_ += h2_;
+    h1_ = h1_ * 5 + 0x52dce729;
+
+    k2 *= kC2;
+    k2 = Rotl(k2, 33);
+    k2 *= kC1;
+    h2_ ^= k2;
+    h2_ = Rotl(h2_, 31);
+    h2_ += h1_;
+    h2_ = h2_ * 5 + 0x38495ab5;
+  }
+
+  uint64_t h1_;
+  uint64_t h2_;
+  uint64_t total_len_ = 0;
+};
+
 template <typename E>
 using UnorderedSet = std::unordered_set<E, Hasher>;
 
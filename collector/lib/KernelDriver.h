@@ -25,15 +25,30 @@ class IKernelDriver {
  public:
   virtual bool Setup(const CollectorConfig& config, sinsp& inspector) = 0;
 
+  std::unordered_set<ppm_sc_code> GetSyscallList(const CollectorConfig& config) {
+    std::unordered_set<ppm_sc_code> ppm_sc = GetSyscallCodes(config.Syscalls());
+
+    /*
+     * Earlier version of Falco used to include procexit and sched_switch by
+     * default, now we have to explicitly add it alongside with the required
+     * syscalls. procexit is essential for keeping threadinfo cache under
+     * control, and sched_switch makes conveying process information more
+     * reliable.
+     */
+    ppm_sc.insert((ppm_sc_code)PPM_SC_SCHED_PROCESS_EXIT);
+    ppm_sc.insert((ppm_sc_code)PPM_SC_SCHED_SWITCH);
+    return ppm_sc;
+  }
+
   /*
    * Convert text representation of event type into an actual syscall code
    * using g_syscall_table.
    */
-  std::unordered_set<ppm_sc_code> GetSyscallList(const CollectorConfig& config) {
+  static std::unordered_set<ppm_sc_code> GetSyscallCodes(const std::vector<std::string>& syscalls) {
     std::unordered_set<ppm_sc_code> ppm_sc;
     const EventNames& event_names = EventNames::GetInstance();
 
-    for (const auto& syscall_str : config.Syscalls()) {
+    for (const auto& syscall_str : syscalls) {
       for (ppm_event_code event_id : event_names.GetEventIDs(syscall_str)) {
         uint16_t syscall_id = event_names.GetEventSyscallID(event_id);
         if (!syscall_id) {
@@ -44,16 +59,6 @@ class IKernelDriver {
         ppm_sc.insert((ppm_sc_code)syscall.ppm_sc);
       }
     }
-
-    /*
-     * Earlier version of Falco used to include procexit and sched_switch by
-     * default, now we have to explicitly add it alongside with the required
-     * syscalls. procexit is essential for keeping threadinfo cache under
-     * control, and sched_switch makes conveying process information more
-     * reliable.
-     */
-    ppm_sc.insert((ppm_sc_code)PPM_SC_SCHED_PROCESS_EXIT);
-    ppm_sc.insert((ppm_sc_code)PPM_SC_SCHED_SWITCH);
     return ppm_sc;
   }
 };
@@ -0,0 +1,76 @@
+#ifndef COLLECTOR_LATENCYHISTOGRAM_H
+#define COLLECTOR_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace collector {
+
+// LatencyHistogram counts durations, in microseconds, into buckets whose upper bounds are the powers of
+// two from 1us to 2^24us (about 17s), plus a last bucket for longer durations. Recording a duration is a
+// couple of relaxed atomic additions, so it may be done from any thread, including the event thread.
+//
+// Counts are cumulative. Exporters compute the difference between two snapshots.
+class LatencyHistogram {
+ public:
+  static constexpr size_t kNumBounds = 25;
+  static constexpr size_t kNumBuckets = kNumBounds + 1;
+
+  struct Snapshot {
+    std::array<uint64_t, kNumBuckets> counts = {};
+    uint64_t sum_micros = 0;
+  };
+
+  // The upper bounds of all buckets but the last, in microseconds.
+  static std::vector<double> Bounds() {
+    std::vector<double> bounds;
+    bounds.reserve(kNumBounds);
+    for (size_t i = 0; i < kNumBounds; i++) {
+      bounds.push_back(static_cast<double>(uint64_t{1} << i));
+    }
+    return bounds;
+  }
+
+  static size_t BucketOf(int64_t micros) {
+    if (micros <= 1) {
+      return 0;
+    }
+    size_t bucket = 64 - __builtin_clzll(static_cast<uint64_t>(micros - 1));
+    return bucket < kNumBounds ? bucket : kNumBounds;
+  }
+
+  // Records `count` occurrences of a duration, which is more than one when the duration was measured on
+  // a sampled event. Negative durations, caused by clock adjustments, are recorded as 0.
+  void Record(int64_t micros, uint64_t count = 1) {
+    if (micros < 0) {
+      micros = 0;
+    }
+    counts_[BucketOf(micros)].fetch_add(count, std::memory_order_relaxed);
+    sum_micros_.fetch_add(static_cast<uint64_t>(micros) * count, std::memory_order_relaxed);
+  }
+
+  void Read(Snapshot* snapshot) const {
+    for (size_t i = 0; i < kNumBuckets; i++) {
+      snapshot->counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    snapshot->sum_micros = sum_micros_.load(std::memory_order_relaxed);
+  }
+
+  void Reset() {
+    for (auto& count : counts_) {
+      count.store(0, std::memory_order_relaxed);
+    }
+    sum_micros_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> counts_ = {{}};
+  std::atomic<uint64_t> sum_micros_{0};
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_LATENCYHISTOGRAM_H
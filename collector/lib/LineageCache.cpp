@@ -0,0 +1,78 @@
+#include "LineageCache.h"
+
+#include <algorithm>
+
+#include "CollectorStats.h"
+
+namespace collector {
+
+constexpr size_t LineageCache::kDefaultMaxSize;
+
+const LineageCache::Lineage* LineageCache::Find(const Key& parent) const {
+  auto it = entries_.find(parent.tid);
+  if (it == entries_.end() || it->second.clone_ts != parent.clone_ts || it->second.exec_ts != parent.exec_ts) {
+    COUNTER_INC(CollectorStats::process_lineage_cache_misses);
+    return nullptr;
+  }
+  COUNTER_INC(CollectorStats::process_lineage_cache_hits);
+  return &it->second.lineage;
+}
+
+const LineageCache::Lineage* LineageCache::Insert(const Key& parent, Lineage lineage, std::vector<int64_t> visited) {
+  Erase(parent.tid);
+  if (entries_.size() >= max_size_) {
+    Clear();
+    COUNTER_INC(CollectorStats::process_lineage_cache_flushes);
+  }
+
+  for (int64_t tid : visited) {
+    dependents_[tid].push_back(parent.tid);
+  }
+
+  Entry& entry = entries_[parent.tid];
+  entry.clone_ts = parent.clone_ts;
+  entry.exec_ts = parent.exec_ts;
+  entry.lineage = std::move(lineage);
+  entry.visited = std::move(visited);
+  return &entry.lineage;
+}
+
+void LineageCache::Invalidate(int64_t tid) {
+  auto it = dependents_.find(tid);
+  if (it == dependents_.end()) {
+    return;
+  }
+
+  std::vector<int64_t> keys = std::move(it->second);
+  dependents_.erase(it);
+  for (int64_t key : keys) {
+    Erase(key);
+  }
+}
+
+void LineageCache::Clear() {
+  entries_.clear();
+  dependents_.clear();
+}
+
+void LineageCache::Erase(int64_t tid) {
+  auto it = entries_.find(tid);
+  if (it == entries_.end()) {
+    return;
+  }
+
+  for (int64_t visited : it->second.visited) {
+    auto dependents = dependents_.find(visited);
+    if (dependents == dependents_.end()) {
+      continue;
+    }
+    auto& keys = dependents->second;
+    keys.erase(std::remove(keys.begin(), keys.end(), tid), keys.end());
+    if (keys.empty()) {
+      dependents_.erase(dependents);
+    }
+  }
+  entries_.erase(it);
+}
+
+}  // namespace collector
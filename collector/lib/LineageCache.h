@@ -0,0 +1,77 @@
+#ifndef COLLECTOR_LINEAGECACHE_H
+#define COLLECTOR_LINEAGECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace collector {
+
+// LineageCache remembers the collapsed lineage collected above a parent process, so that the processes it
+// keeps spawning do not each walk the same chain of ancestors again.
+//
+// Entries are keyed by the thread ID of the parent, along with its clone and last exec timestamps, which
+// tell apart a reused thread ID and the successive programs run by the parent. Each entry also remembers the
+// threads visited while collecting it: an exec by one of them changes its exec file path, a setuid its uid,
+// and its exit reparents its children, so all of them invalidate the entries which depend on it. The cache is
+// bounded, and cleared when it is full.
+//
+// Not thread-safe.
+class LineageCache {
+ public:
+  static constexpr size_t kDefaultMaxSize = 4096;
+
+  struct Ancestor {
+    std::string exec_file_path;
+    uint32_t uid;
+  };
+
+  // An immutable lineage, closest ancestor first.
+  struct Lineage {
+    std::vector<Ancestor> ancestors;
+    // The total length of the exec file paths of the ancestors.
+    size_t string_length = 0;
+  };
+
+  struct Key {
+    int64_t tid;
+    uint64_t clone_ts;
+    uint64_t exec_ts;
+  };
+
+  explicit LineageCache(size_t max_size = kDefaultMaxSize) : max_size_(max_size) {}
+
+  // Returns the lineage cached for the parent, or null. The returned pointer is valid until the next change.
+  const Lineage* Find(const Key& parent) const;
+
+  // Caches the lineage of the parent, collected while visiting the given threads, starting with the parent.
+  const Lineage* Insert(const Key& parent, Lineage lineage, std::vector<int64_t> visited);
+
+  // Drops the entries whose lineage visited the thread, to be called when it execs, changes its uid or exits.
+  void Invalidate(int64_t tid);
+
+  void Clear();
+
+  size_t Size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint64_t clone_ts;
+    uint64_t exec_ts;
+    Lineage lineage;
+    std::vector<int64_t> visited;
+  };
+
+  void Erase(int64_t tid);
+
+  size_t max_size_;
+  std::unordered_map<int64_t, Entry> entries_;
+  // The keys of the entries which visited each thread.
+  std::unordered_map<int64_t, std::vector<int64_t>> dependents_;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_LINEAGECACHE_H
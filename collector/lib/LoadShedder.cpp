@@ -0,0 +1,92 @@
+#include "LoadShedder.h"
+
+#include <algorithm>
+#include <array>
+
+#include "CollectorStats.h"
+#include "Logging.h"
+
+namespace collector {
+
+constexpr double LoadShedder::kHighDropRatio;
+constexpr double LoadShedder::kLowDropRatio;
+constexpr std::chrono::microseconds LoadShedder::kMaxLag;
+constexpr int LoadShedder::kSustainedWindows;
+constexpr int LoadShedder::kRecoveryWindows;
+
+namespace {
+
+// Syscalls shed at each level, on top of those of the previous levels.
+const std::array<std::vector<std::string>, 2> kShedLevels = {{
+    // The working directory is only used to report process signals.
+    {"chdir", "fchdir"},
+    // Credential changes only refresh the user of already known processes. Process lineages are not cached
+    // while they are shed, as the uid changes of ancestors would no longer invalidate them.
+    {"setuid", "setgid", "setresuid", "setresgid"},
+}};
+
+}  // namespace
+
+LoadShedder::LoadShedder() {
+  COUNTER_SET(CollectorStats::syscall_shedding_level, 0);
+}
+
+int LoadShedder::MaxLevel() {
+  return kShedLevels.size();
+}
+
+std::vector<std::string> LoadShedder::SyscallsShedAt(int level) {
+  std::vector<std::string> syscalls;
+  for (int i = 0; i < level && i < MaxLevel(); i++) {
+    syscalls.insert(syscalls.end(), kShedLevels[i].begin(), kShedLevels[i].end());
+  }
+  return syscalls;
+}
+
+bool LoadShedder::ShedsUidChanges(int level) {
+  auto syscalls = SyscallsShedAt(level);
+  return std::find(syscalls.begin(), syscalls.end(), "setuid") != syscalls.end();
+}
+
+int LoadShedder::Update(uint64_t events, uint64_t drops, std::chrono::microseconds max_lag) {
+  if (!primed_ || events < last_events_ || drops < last_drops_) {
+    primed_ = true;
+    last_events_ = events;
+    last_drops_ = drops;
+    return level_;
+  }
+
+  uint64_t window_events = events - last_events_;
+  uint64_t window_drops = drops - last_drops_;
+  last_events_ = events;
+  last_drops_ = drops;
+
+  double drop_ratio = window_drops > 0 ? static_cast<double>(window_drops) / (window_events + window_drops) : 0.0;
+
+  if (drop_ratio >= kHighDropRatio || max_lag >= kMaxLag) {
+    calm_windows_ = 0;
+    if (++overloaded_windows_ >= kSustainedWindows && level_ < MaxLevel()) {
+      overloaded_windows_ = 0;
+      level_++;
+      COUNTER_INC(CollectorStats::syscall_shedding_escalations);
+      CLOG(WARNING) << "Collector is overloaded (drop ratio " << drop_ratio << ", lag " << max_lag.count()
+                    << "us), shedding syscalls: level " << level_;
+    }
+  } else if (drop_ratio <= kLowDropRatio && max_lag < kMaxLag / 2) {
+    overloaded_windows_ = 0;
+    if (++calm_windows_ >= kRecoveryWindows && level_ > 0) {
+      calm_windows_ = 0;
+      level_--;
+      COUNTER_INC(CollectorStats::syscall_shedding_recoveries);
+      CLOG(INFO) << "Collector load has subsided, restoring shed syscalls: level " << level_;
+    }
+  } else {
+    overloaded_windows_ = 0;
+    calm_windows_ = 0;
+  }
+
+  COUNTER_SET(CollectorStats::syscall_shedding_level, level_);
+  return level_;
+}
+
+}  // namespace collector
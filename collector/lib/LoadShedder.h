@@ -0,0 +1,59 @@
+#ifndef COLLECTOR_LOADSHEDDER_H
+#define COLLECTOR_LOADSHEDDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace collector {
+
+// LoadShedder decides which syscalls collector stops capturing while it cannot keep up with the kernel.
+//
+// It is fed, about once per second, with the capture statistics and the largest delay observed between an
+// event being emitted and being handled. A window is overloaded when a significant fraction of the events
+// were dropped by the kernel, or when events were handled late. After kSustainedWindows overloaded windows
+// in a row, one more level of syscalls is shed, least valuable first, so that the events the network graph
+// and process signals depend on (connect, accept, close, execve, ...) are no longer dropped at random.
+// After kRecoveryWindows calm windows in a row, the last shed level is restored.
+// Every decision is reported through the syscall_shedding_* counters.
+class LoadShedder {
+ public:
+  // Fraction of dropped events above which a window is overloaded.
+  static constexpr double kHighDropRatio = 0.01;
+  // Fraction of dropped events below which a window is calm.
+  static constexpr double kLowDropRatio = 0.001;
+  // Event handling delay above which a window is overloaded.
+  static constexpr std::chrono::microseconds kMaxLag = std::chrono::seconds(2);
+  static constexpr int kSustainedWindows = 3;
+  static constexpr int kRecoveryWindows = 30;
+
+  LoadShedder();
+
+  // Records the outcome of a window, given the cumulative event and drop counts of the capture and the
+  // largest handling delay observed since the previous call. Returns the shedding level to apply.
+  int Update(uint64_t events, uint64_t drops, std::chrono::microseconds max_lag);
+
+  int Level() const { return level_; }
+
+  static int MaxLevel();
+
+  // All the syscalls which are not captured at the given level.
+  static std::vector<std::string> SyscallsShedAt(int level);
+
+  // Whether the uid changes of processes are not captured at the given level.
+  static bool ShedsUidChanges(int level);
+
+ private:
+  bool primed_ = false;
+  uint64_t last_events_ = 0;
+  uint64_t last_drops_ = 0;
+
+  int level_ = 0;
+  int overloaded_windows_ = 0;
+  int calm_windows_ = 0;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_LOADSHEDDER_H
@@ -0,0 +1,113 @@
+#ifndef COLLECTOR_MPMCQUEUE_H
+#define COLLECTOR_MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace collector {
+
+// MPMCQueue is a bounded, lock-free queue which any number of threads may push to and pop from.
+//
+// Each slot carries a sequence number telling whether it is ready to be written for a given lap around the
+// ring, or to be read. Threads claim a position with a compare-and-swap on the tail (resp. head) index, then
+// publish the item (resp. release the slot) through the slot's sequence number, so pushing and popping
+// never wait for another thread holding a lock.
+template <typename T>
+class MPMCQueue {
+ public:
+  // The capacity is rounded up to the next power of two.
+  explicit MPMCQueue(size_t capacity) : capacity_(RoundUpToPowerOfTwo(capacity)), mask_(capacity_ - 1), slots_(new Slot[capacity_]) {
+    for (size_t i = 0; i < capacity_; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPMCQueue(const MPMCQueue&) = delete;
+  MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+  // Returns false, leaving item untouched, if the queue is full.
+  bool TryPush(T&& item) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->item = std::move(item);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if the queue is empty.
+  bool TryPop(T* item) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+
+    *item = std::move(slot->item);
+    slot->sequence.store(pos + capacity_, std::memory_order_release);
+    return true;
+  }
+
+  // The number of queued items. Only a snapshot when called concurrently with producers or consumers.
+  size_t Size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T item;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_MPMCQUEUE_H
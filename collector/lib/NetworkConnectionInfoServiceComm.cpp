@@ -16,7 +16,9 @@ std::unique_ptr<grpc::ClientContext> NetworkConnectionInfoServiceComm::CreateCli
   return ctx;
 }
 
-NetworkConnectionInfoServiceComm::NetworkConnectionInfoServiceComm(std::string hostname, std::shared_ptr<grpc::Channel> channel) : hostname_(std::move(hostname)), channel_(std::move(channel)) {
+NetworkConnectionInfoServiceComm::NetworkConnectionInfoServiceComm(std::string hostname, std::shared_ptr<grpc::Channel> channel,
+                                                                   std::shared_ptr<DelimitedFileSink> file_sink)
+    : hostname_(std::move(hostname)), channel_(std::move(channel)), file_sink_(std::move(file_sink)) {
   if (channel_) {
     stub_ = sensor::NetworkConnectionInfoService::NewStub(channel_);
   }
@@ -50,6 +52,8 @@ std::unique_ptr<IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>> Netwo
     return DuplexClient::CreateWithReadCallback(
         &sensor::NetworkConnectionInfoService::Stub::AsyncPushNetworkConnectionInfo,
         channel_, context_.get(), std::move(receive_func));
+  } else if (file_sink_) {
+    return MakeUnique<collector::grpc_duplex_impl::FileDuplexClientWriter<sensor::NetworkConnectionInfoMessage>>(file_sink_);
   } else {
     return MakeUnique<collector::grpc_duplex_impl::StdoutDuplexClientWriter<sensor::NetworkConnectionInfoMessage>>();
   }
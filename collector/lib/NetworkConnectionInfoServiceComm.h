@@ -33,7 +33,9 @@ class INetworkConnectionInfoServiceComm {
 
 class NetworkConnectionInfoServiceComm : public INetworkConnectionInfoServiceComm {
  public:
-  NetworkConnectionInfoServiceComm(std::string hostname, std::shared_ptr<grpc::Channel> channel);
+  // Without a channel, messages are written to file_sink if set, and logged otherwise.
+  NetworkConnectionInfoServiceComm(std::string hostname, std::shared_ptr<grpc::Channel> channel,
+                                   std::shared_ptr<DelimitedFileSink> file_sink = nullptr);
 
   void ResetClientContext() override;
   bool WaitForConnectionReady(const std::function<bool()>& check_interrupted) override;
@@ -57,6 +59,7 @@ class NetworkConnectionInfoServiceComm : public INetworkConnectionInfoServiceCom
   std::string hostname_;
   std::shared_ptr<grpc::Channel> channel_;
   std::unique_ptr<sensor::NetworkConnectionInfoService::Stub> stub_;
+  std::shared_ptr<DelimitedFileSink> file_sink_;
 
   std::mutex context_mutex_;
   std::unique_ptr<grpc::ClientContext> context_;
@@ -113,7 +113,15 @@ std::optional<Connection> NetworkSignalHandler::GetConnection(sinsp_evt* evt) {
 }
 
 SignalHandler::Result NetworkSignalHandler::HandleSignal(sinsp_evt* evt) {
-  auto modifier = modifiers[evt->get_type()];
+  return HandleTaggedSignal(evt, GetEventTag(evt->get_type()));
+}
+
+SignalHandler::EventTag NetworkSignalHandler::GetEventTag(uint16_t event_type) {
+  return static_cast<EventTag>(modifiers[event_type]);
+}
+
+SignalHandler::Result NetworkSignalHandler::HandleTaggedSignal(sinsp_evt* evt, EventTag tag) {
+  auto modifier = static_cast<Modifier>(tag);
   if (modifier == Modifier::INVALID) return SignalHandler::IGNORED;
 
   auto result = GetConnection(evt);
@@ -121,6 +129,13 @@ SignalHandler::Result NetworkSignalHandler::HandleSignal(sinsp_evt* evt) {
     return SignalHandler::IGNORED;
   }
 
+  if (pipeline_) {
+    if (!pipeline_->Push({std::move(*result), static_cast<int64_t>(evt->get_ts() / 1000UL), modifier == Modifier::ADD})) {
+      return SignalHandler::ERROR;
+    }
+    return SignalHandler::PROCESSED;
+  }
+
   conn_tracker_->UpdateConnection(*result, evt->get_ts() / 1000UL, modifier == Modifier::ADD);
   return SignalHandler::PROCESSED;
 }
@@ -129,7 +144,29 @@ std::vector<std::string> NetworkSignalHandler::GetRelevantEvents() {
   return {"close<", "shutdown<", "connect<", "accept<", "getsockopt<"};
 }
 
+void NetworkSignalHandler::EnablePipeline(size_t queue_capacity) {
+  pipeline_ = std::make_unique<SignalPipeline<ConnectionUpdate>>(
+      queue_capacity, kMaxBackpressure,
+      SignalPipeline<ConnectionUpdate>::Counters{
+          CollectorStats::net_pipeline_queue_depth,
+          CollectorStats::net_pipeline_queue_full,
+          CollectorStats::net_pipeline_dropped,
+      });
+}
+
+bool NetworkSignalHandler::Start() {
+  if (pipeline_) {
+    return pipeline_->Start([this](ConnectionUpdate& update) {
+      conn_tracker_->UpdateConnection(update.conn, update.timestamp, update.added);
+    });
+  }
+  return true;
+}
+
 bool NetworkSignalHandler::Stop() {
+  if (pipeline_) {
+    pipeline_->Stop();
+  }
   event_extractor_.ClearWrappers();
   return true;
 }
@@ -1,10 +1,12 @@
 #ifndef COLLECTOR_NETWORKSIGNALHANDLER_H
 #define COLLECTOR_NETWORKSIGNALHANDLER_H
 
+#include <memory>
 #include <optional>
 
 #include "ConnTracker.h"
 #include "SignalHandler.h"
+#include "SignalPipeline.h"
 #include "SysdigEventExtractor.h"
 #include "SysdigService.h"
 
@@ -19,12 +21,28 @@ class NetworkSignalHandler final : public SignalHandler {
 
   std::string GetName() override { return "NetworkSignalHandler"; }
   Result HandleSignal(sinsp_evt* evt) override;
+  EventTag GetEventTag(uint16_t event_type) override;
+  Result HandleTaggedSignal(sinsp_evt* evt, EventTag tag) override;
   std::vector<std::string> GetRelevantEvents() override;
+  bool Start() override;
   bool Stop() override;
 
   void SetCollectConnectionStatus(bool collect_connection_status) { collect_connection_status_ = collect_connection_status; }
 
+  // Update the connection tracker from a dedicated worker, fed through a queue of the given capacity,
+  // instead of from the event thread.
+  void EnablePipeline(size_t queue_capacity);
+
  private:
+  struct ConnectionUpdate {
+    Connection conn;
+    int64_t timestamp = 0;
+    bool added = false;
+  };
+
+  // How long the event thread waits for room in a full queue before dropping a connection update.
+  static constexpr std::chrono::milliseconds kMaxBackpressure{1};
+
   std::optional<Connection> GetConnection(sinsp_evt* evt);
 
   SysdigEventExtractor event_extractor_;
@@ -32,6 +50,8 @@ class NetworkSignalHandler final : public SignalHandler {
   SysdigStats* stats_;
 
   bool collect_connection_status_;
+
+  std::unique_ptr<SignalPipeline<ConnectionUpdate>> pipeline_;
 };
 
 }  // namespace collector
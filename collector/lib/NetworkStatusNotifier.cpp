@@ -1,6 +1,7 @@
 #include "NetworkStatusNotifier.h"
 
 #include <google/protobuf/util/time_util.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include "CollectorStats.h"
 #include "DuplexGRPC.h"
@@ -14,6 +15,11 @@ namespace collector {
 
 namespace {
 
+// The encoded size of a message as an element of a repeated field.
+size_t EntrySize(const google::protobuf::MessageLite& entry) {
+  return 1 + google::protobuf::internal::WireFormatLite::LengthDelimitedSize(entry.ByteSizeLong());
+}
+
 storage::L4Protocol TranslateL4Protocol(L4Proto proto) {
   switch (proto) {
     case L4Proto::TCP:
@@ -197,7 +203,7 @@ void NetworkStatusNotifier::ReportConnectionStats() {
   }
 }
 
-bool NetworkStatusNotifier::UpdateAllConnsAndEndpoints() {
+bool NetworkStatusNotifier::UpdateAllConnsAndEndpoints(std::chrono::milliseconds* next_interval) {
   if (turn_off_scraping_) {
     return true;
   }
@@ -212,10 +218,15 @@ bool NetworkStatusNotifier::UpdateAllConnsAndEndpoints() {
       return false;
     }
   }
+  auto scrape_duration = std::chrono::microseconds(NowMicros() - ts);
+
+  size_t missed_conns = 0;
   WITH_TIMER(CollectorStats::net_scrape_update) {
-    conn_tracker_->Update(all_conns, all_listen_endpoints, ts);
+    missed_conns = conn_tracker_->Update(all_conns, all_listen_endpoints, ts);
   }
 
+  *next_interval = scrape_scheduler_.OnScrape(scrape_duration, all_conns.size(), missed_conns);
+
   return true;
 }
 
@@ -227,15 +238,17 @@ void NetworkStatusNotifier::RunSingle(IDuplexClientWriter<sensor::NetworkConnect
   auto next_scrape = std::chrono::system_clock::now();
 
   while (writer->Sleep(next_scrape)) {
-    next_scrape = std::chrono::system_clock::now() + std::chrono::seconds(scrape_interval_);
-
-    if (!UpdateAllConnsAndEndpoints()) {
+    auto scrape_start = std::chrono::system_clock::now();
+    auto interval = scrape_scheduler_.Interval();
+    bool scraped = UpdateAllConnsAndEndpoints(&interval);
+    next_scrape = scrape_start + interval;
+    if (!scraped) {
       continue;
     }
 
     ReportConnectionStats();
 
-    const sensor::NetworkConnectionInfoMessage* msg;
+    int64_t time_micros = NowMicros();
     ConnMap new_conn_state;
     AdvertisedEndpointMap new_cep_state;
     WITH_TIMER(CollectorStats::net_fetch_state) {
@@ -246,22 +259,22 @@ void NetworkStatusNotifier::RunSingle(IDuplexClientWriter<sensor::NetworkConnect
       ConnectionTracker::ComputeDelta(new_cep_state, &old_cep_state);
     }
 
-    WITH_TIMER(CollectorStats::net_create_message) {
-      msg = CreateInfoMessage(old_conn_state, old_cep_state);
-      old_conn_state = std::move(new_conn_state);
-      old_cep_state = std::move(new_cep_state);
-    }
+    // The messages are built from the delta while they are written, it is moved out of the way of the next state.
+    ConnMap delta_conn = std::move(old_conn_state);
+    AdvertisedEndpointMap delta_cep = std::move(old_cep_state);
+    old_conn_state = std::move(new_conn_state);
+    old_cep_state = std::move(new_cep_state);
 
-    if (!msg) {
+    if (delta_conn.empty() && delta_cep.empty()) {
       continue;
     }
 
-    WITH_TIMER(CollectorStats::net_write_message) {
-      if (!writer->Write(*msg, next_scrape)) {
-        CLOG(ERROR) << "Failed to write network connection info";
-        return;
-      }
+    if (!WriteDelta(writer, delta_conn, delta_cep, next_scrape)) {
+      CLOG(ERROR) << "Failed to write network connection info";
+      return;
     }
+    // From the collection of the connection state to its delivery.
+    HISTOGRAM_RECORD(CollectorStats::network_status_write, NowMicros() - time_micros);
   }
 }
 
@@ -274,16 +287,17 @@ void NetworkStatusNotifier::RunSingleAfterglow(IDuplexClientWriter<sensor::Netwo
   int64_t time_at_last_scrape = NowMicros();
 
   while (writer->Sleep(next_scrape)) {
-    next_scrape = std::chrono::system_clock::now() + std::chrono::seconds(scrape_interval_);
-
-    if (!UpdateAllConnsAndEndpoints()) {
+    auto scrape_start = std::chrono::system_clock::now();
+    auto interval = scrape_scheduler_.Interval();
+    bool scraped = UpdateAllConnsAndEndpoints(&interval);
+    next_scrape = scrape_start + interval;
+    if (!scraped) {
       continue;
     }
 
     ReportConnectionStats();
 
     int64_t time_micros = NowMicros();
-    const sensor::NetworkConnectionInfoMessage* msg;
     AdvertisedEndpointMap new_cep_state;
     ConnMap new_conn_state, delta_conn;
     WITH_TIMER(CollectorStats::net_fetch_state) {
@@ -294,58 +308,115 @@ void NetworkStatusNotifier::RunSingleAfterglow(IDuplexClientWriter<sensor::Netwo
       ConnectionTracker::ComputeDelta(new_cep_state, &old_cep_state);
     }
 
-    WITH_TIMER(CollectorStats::net_create_message) {
-      // Report the deltas
-      msg = CreateInfoMessage(delta_conn, old_cep_state);
-      // Add new connections to the old_state and remove inactive connections that are older than the afterglow period.
-      ConnectionTracker::UpdateOldState(&old_conn_state, new_conn_state, time_micros, afterglow_period_micros_);
-      old_cep_state = std::move(new_cep_state);
-      time_at_last_scrape = time_micros;
-    }
+    // Add new connections to the old_state and remove inactive connections that are older than the afterglow period.
+    ConnectionTracker::UpdateOldState(&old_conn_state, new_conn_state, time_micros, afterglow_period_micros_);
+    AdvertisedEndpointMap delta_cep = std::move(old_cep_state);
+    old_cep_state = std::move(new_cep_state);
+    time_at_last_scrape = time_micros;
 
-    if (!msg) {
+    if (delta_conn.empty() && delta_cep.empty()) {
       continue;
     }
 
+    // Report the deltas
+    if (!WriteDelta(writer, delta_conn, delta_cep, next_scrape)) {
+      CLOG(ERROR) << "Failed to write network connection info";
+      return;
+    }
+    // From the collection of the connection state to its delivery.
+    HISTOGRAM_RECORD(CollectorStats::network_status_write, NowMicros() - time_micros);
+  }
+}
+
+bool NetworkStatusNotifier::WriteDelta(IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>* writer,
+                                       const ConnMap& conn_delta, const AdvertisedEndpointMap& cep_delta,
+                                       const std::chrono::system_clock::time_point& deadline) {
+  auto interrupted = [this] { return thread_.should_stop(); };
+  if (signal_scheduler_) {
+    signal_scheduler_->SetBusy(SignalScheduler::NETWORK, true);
+  }
+
+  DeltaCursor cursor(conn_delta, cep_delta);
+  bool written = true;
+  bool pending = false;
+  while (written && !cursor.Done()) {
+    const sensor::NetworkConnectionInfoMessage* msg;
+    WITH_TIMER(CollectorStats::net_create_message) {
+      msg = CreateInfoMessage(&cursor);
+    }
+    COUNTER_INC(CollectorStats::net_messages);
+    if (pending && cursor.Done()) {
+      COUNTER_INC(CollectorStats::net_split_deltas);
+    }
+
     WITH_TIMER(CollectorStats::net_write_message) {
-      if (!writer->Write(*msg, next_scrape)) {
-        CLOG(ERROR) << "Failed to write network connection info";
-        return;
+      written = !signal_scheduler_ ||
+                signal_scheduler_->Acquire(SignalScheduler::NETWORK, msg->ByteSizeLong(), interrupted);
+      if (written && pending) {
+        written = static_cast<bool>(writer->WaitUntilWritable(deadline));
+      }
+      // GRPC serializes a message as soon as its write is started, so the next message can be built in its
+      // place while it is sent. The last one is waited for.
+      if (written && cursor.Done()) {
+        written = static_cast<bool>(writer->Write(*msg, deadline));
+        pending = false;
+      } else if (written) {
+        written = static_cast<bool>(writer->WriteAsync(*msg));
+        pending = true;
       }
     }
   }
+
+  if (signal_scheduler_) {
+    signal_scheduler_->SetBusy(SignalScheduler::NETWORK, false);
+  }
+  return written;
 }
 
-sensor::NetworkConnectionInfoMessage* NetworkStatusNotifier::CreateInfoMessage(const ConnMap& conn_delta, const AdvertisedEndpointMap& endpoint_delta) {
-  if (conn_delta.empty() && endpoint_delta.empty()) return nullptr;
+sensor::NetworkConnectionInfoMessage* NetworkStatusNotifier::CreateInfoMessage(DeltaCursor* cursor) {
+  if (cursor->Done()) return nullptr;
 
   Reset();
   auto* msg = AllocateRoot();
   auto* info = msg->mutable_info();
 
-  AddConnections(info->mutable_updated_connections(), conn_delta);
-  COUNTER_ADD(CollectorStats::net_conn_deltas, conn_delta.size());
-  AddContainerEndpoints(info->mutable_updated_endpoints(), endpoint_delta);
-  COUNTER_ADD(CollectorStats::net_cep_deltas, endpoint_delta.size());
+  size_t entries = 0, bytes = 0;
+  AddConnections(info->mutable_updated_connections(), cursor, &entries, &bytes);
+  COUNTER_ADD(CollectorStats::net_conn_deltas, info->updated_connections_size());
+  AddContainerEndpoints(info->mutable_updated_endpoints(), cursor, &entries, &bytes);
+  COUNTER_ADD(CollectorStats::net_cep_deltas, info->updated_endpoints_size());
 
   *info->mutable_time() = CurrentTimeProto();
 
   return msg;
 }
 
-void NetworkStatusNotifier::AddConnections(::google::protobuf::RepeatedPtrField<sensor::NetworkConnection>* updates, const ConnMap& delta) {
-  for (const auto& delta_entry : delta) {
+bool NetworkStatusNotifier::MessageFull(size_t entries, size_t bytes) const {
+  return (max_message_entries_ > 0 && entries >= max_message_entries_) ||
+         (max_message_bytes_ > 0 && bytes >= max_message_bytes_);
+}
+
+void NetworkStatusNotifier::AddConnections(::google::protobuf::RepeatedPtrField<sensor::NetworkConnection>* updates, DeltaCursor* cursor,
+                                           size_t* entries, size_t* bytes) {
+  for (; cursor->conn_it != cursor->conn_end && !MessageFull(*entries, *bytes); ++cursor->conn_it) {
+    const auto& delta_entry = *cursor->conn_it;
     auto* conn_proto = ConnToProto(delta_entry.first);
     if (!delta_entry.second.IsActive()) {
       *conn_proto->mutable_close_timestamp() = google::protobuf::util::TimeUtil::MicrosecondsToTimestamp(
           delta_entry.second.LastActiveTime());
     }
     updates->AddAllocated(conn_proto);
+    ++*entries;
+    if (max_message_bytes_ > 0) {
+      *bytes += EntrySize(*conn_proto);
+    }
   }
 }
 
-void NetworkStatusNotifier::AddContainerEndpoints(::google::protobuf::RepeatedPtrField<sensor::NetworkEndpoint>* updates, const AdvertisedEndpointMap& delta) {
-  for (const auto& delta_entry : delta) {
+void NetworkStatusNotifier::AddContainerEndpoints(::google::protobuf::RepeatedPtrField<sensor::NetworkEndpoint>* updates, DeltaCursor* cursor,
+                                                  size_t* entries, size_t* bytes) {
+  for (; cursor->cep_it != cursor->cep_end && !MessageFull(*entries, *bytes); ++cursor->cep_it) {
+    const auto& delta_entry = *cursor->cep_it;
     auto* endpoint_proto = ContainerEndpointToProto(delta_entry.first);
 
     CLOG(DEBUG) << delta_entry.first << " active:" << delta_entry.second.IsActive();
@@ -355,6 +426,10 @@ void NetworkStatusNotifier::AddContainerEndpoints(::google::protobuf::RepeatedPt
           delta_entry.second.LastActiveTime());
     }
     updates->AddAllocated(endpoint_proto);
+    ++*entries;
+    if (max_message_bytes_ > 0) {
+      *bytes += EntrySize(*endpoint_proto);
+    }
   }
 }
 
@@ -9,6 +9,8 @@
 #include "NetworkConnectionInfoServiceComm.h"
 #include "ProcfsScraper.h"
 #include "ProtoAllocator.h"
+#include "ScrapeScheduler.h"
+#include "SignalScheduler.h"
 #include "StoppableThread.h"
 
 namespace collector {
@@ -22,12 +24,17 @@ class NetworkStatusNotifier : protected ProtoAllocator<sensor::NetworkConnection
                         std::shared_ptr<CollectorConnectionStats<unsigned int>> connections_total_reporter = 0,
                         std::shared_ptr<CollectorConnectionStats<float>> connections_rate_reporter = 0)
       : conn_scraper_(conn_scraper),
-        scrape_interval_(config.ScrapeInterval()),
+        scrape_scheduler_(std::chrono::seconds(config.ScrapeInterval()),
+                          std::chrono::seconds(config.ScrapeIntervalMin()),
+                          std::chrono::seconds(config.ScrapeIntervalMax()),
+                          config.AdaptiveScrape()),
         turn_off_scraping_(config.TurnOffScrape()),
         scrape_listen_endpoints_(config.ScrapeListenEndpoints()),
         conn_tracker_(std::move(conn_tracker)),
         afterglow_period_micros_(config.AfterglowPeriod()),
         enable_afterglow_(config.EnableAfterglow()),
+        max_message_bytes_(config.NetworkMessageMaxBytes()),
+        max_message_entries_(config.NetworkMessageMaxEntries()),
         comm_(comm),
         connections_total_reporter_(connections_total_reporter),
         connections_rate_reporter_(connections_rate_reporter) {
@@ -36,10 +43,29 @@ class NetworkStatusNotifier : protected ProtoAllocator<sensor::NetworkConnection
   void Start();
   void Stop();
 
+  // Arbitrates the writes with those of the process signals. Must be called before Start().
+  void SetSignalScheduler(std::shared_ptr<SignalScheduler> scheduler) { signal_scheduler_ = std::move(scheduler); }
+
  private:
-  sensor::NetworkConnectionInfoMessage* CreateInfoMessage(const ConnMap& conn_delta, const AdvertisedEndpointMap& cep_delta);
-  void AddConnections(::google::protobuf::RepeatedPtrField<sensor::NetworkConnection>* updates, const ConnMap& delta);
-  void AddContainerEndpoints(::google::protobuf::RepeatedPtrField<sensor::NetworkEndpoint>* updates, const AdvertisedEndpointMap& delta);
+  // The entries of a delta not yet added to a message.
+  struct DeltaCursor {
+    DeltaCursor(const ConnMap& conn_delta, const AdvertisedEndpointMap& cep_delta)
+        : conn_it(conn_delta.begin()), conn_end(conn_delta.end()), cep_it(cep_delta.begin()), cep_end(cep_delta.end()) {}
+
+    bool Done() const { return conn_it == conn_end && cep_it == cep_end; }
+
+    ConnMap::const_iterator conn_it, conn_end;
+    AdvertisedEndpointMap::const_iterator cep_it, cep_end;
+  };
+
+  // Builds the next message of the delta, up to the maximum size and number of entries, and advances the cursor
+  // past the entries it holds. The message is only valid until the next call. Returns null once the delta is
+  // exhausted.
+  sensor::NetworkConnectionInfoMessage* CreateInfoMessage(DeltaCursor* cursor);
+  bool MessageFull(size_t entries, size_t bytes) const;
+  // Adds entries from the cursor until the message is full, counting them and their encoded size.
+  void AddConnections(::google::protobuf::RepeatedPtrField<sensor::NetworkConnection>* updates, DeltaCursor* cursor, size_t* entries, size_t* bytes);
+  void AddContainerEndpoints(::google::protobuf::RepeatedPtrField<sensor::NetworkEndpoint>* updates, DeltaCursor* cursor, size_t* entries, size_t* bytes);
 
   sensor::NetworkConnection* ConnToProto(const Connection& conn);
   sensor::NetworkEndpoint* ContainerEndpointToProto(const ContainerEndpoint& cep);
@@ -50,23 +76,34 @@ class NetworkStatusNotifier : protected ProtoAllocator<sensor::NetworkConnection
 
   void Run();
   void WaitUntilWriterStarted(IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>* writer, int wait_time);
-  bool UpdateAllConnsAndEndpoints();
+  // Scrapes the connections and endpoints into the tracker. Sets the interval until the next scrape, as decided
+  // from this one, unless it failed.
+  bool UpdateAllConnsAndEndpoints(std::chrono::milliseconds* next_interval);
   void RunSingle(IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>* writer);
   void RunSingleAfterglow(IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>* writer);
+  // Sends the delta as a sequence of bounded messages. Each message is built while the previous one is being
+  // written. Returns false if a write failed, or if the notifier is stopping.
+  bool WriteDelta(IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>* writer,
+                  const ConnMap& conn_delta, const AdvertisedEndpointMap& cep_delta,
+                  const std::chrono::system_clock::time_point& deadline);
   void ReceivePublicIPs(const sensor::IPAddressList& public_ips);
   void ReceiveIPNetworks(const sensor::IPNetworkList& networks);
 
   StoppableThread thread_;
 
   std::shared_ptr<IConnScraper> conn_scraper_;
-  int scrape_interval_;
+  ScrapeScheduler scrape_scheduler_;
   bool turn_off_scraping_;
   bool scrape_listen_endpoints_;
   std::shared_ptr<ConnectionTracker> conn_tracker_;
 
   int64_t afterglow_period_micros_;
   bool enable_afterglow_;
+  // Bounds of each message a delta is split into, 0 for no bound.
+  size_t max_message_bytes_;
+  size_t max_message_entries_;
   std::shared_ptr<INetworkConnectionInfoServiceComm> comm_;
+  std::shared_ptr<SignalScheduler> signal_scheduler_;
 
   std::shared_ptr<CollectorConnectionStats<unsigned int>> connections_total_reporter_;
   std::shared_ptr<CollectorConnectionStats<float>> connections_rate_reporter_;
@@ -1,88 +1,301 @@
 #include "Process.h"
 
+#include <algorithm>
 #include <chrono>
+#include <string_view>
 
 #include "CollectorStats.h"
+#include "Hash.h"
+#include "ProcfsScraper.h"
 #include "SysdigService.h"
 
 namespace collector {
 
 const std::string Process::NOT_AVAILABLE("N/A");
 
-ProcessStore::ProcessStore(SysdigService* falco_instance) : falco_instance_(falco_instance) {
-  cache_ = std::make_shared<std::unordered_map<uint64_t, std::weak_ptr<Process>>>();
+namespace {
+
+// The attributes of an interned ProcessKey, pointing into the key itself.
+struct ProcessKeyView {
+  std::string_view comm;
+  std::string_view exe_path;
+  std::string_view args;
+
+  bool operator==(const ProcessKeyView& other) const {
+    return comm == other.comm && exe_path == other.exe_path && args == other.args;
+  }
+
+  size_t Hash() const { return HashAll(comm, exe_path, args); }
+};
+
+// ProcessKeyInterner keeps track of the live ProcessKeys. Keys remove themselves from it when the last
+// reference to them is dropped, so every entry points into a live key.
+class ProcessKeyInterner {
+ public:
+  static ProcessKeyInterner& GetInstance() {
+    // Never destroyed, as keys may outlive static destruction.
+    static auto* interner = new ProcessKeyInterner;
+    return *interner;
+  }
+
+  std::shared_ptr<const ProcessKey> Intern(std::string comm, std::string exe_path, std::string args) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = keys_.find(ProcessKeyView{comm, exe_path, args});
+    if (it != keys_.end()) {
+      if (auto key = it->second.lock()) {
+        return key;
+      }
+      // The last reference to this key is being dropped, it is about to release itself.
+      keys_.erase(it);
+    }
+
+    std::shared_ptr<const ProcessKey> key(
+        new ProcessKey{std::move(comm), std::move(exe_path), std::move(args)},
+        [this](const ProcessKey* key) { Release(key); });
+    keys_.emplace(ProcessKeyView{key->comm, key->exe_path, key->args}, key);
+    COUNTER_SET(CollectorStats::process_keys_interned, keys_.size());
+
+    return key;
+  }
+
+ private:
+  void Release(const ProcessKey* key) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      // The entry may already belong to a newer key with the same attributes.
+      auto it = keys_.find(ProcessKeyView{key->comm, key->exe_path, key->args});
+      if (it != keys_.end() && it->second.expired()) {
+        keys_.erase(it);
+        COUNTER_SET(CollectorStats::process_keys_interned, keys_.size());
+      }
+    }
+
+    delete key;
+  }
+
+  std::mutex mutex_;
+  UnorderedMap<ProcessKeyView, std::weak_ptr<const ProcessKey>> keys_;
+};
+
+const std::shared_ptr<const ProcessKey>& NotAvailableKey() {
+  static const auto* key = new std::shared_ptr<const ProcessKey>(ProcessKey::Intern("N/A", "N/A", "N/A"));
+  return *key;
 }
 
-const std::shared_ptr<IProcess> ProcessStore::Fetch(uint64_t pid) {
-  auto cached_process_pair_iter = cache_->find(pid);
+}  // namespace
+
+std::shared_ptr<const ProcessKey> ProcessKey::Intern(std::string comm, std::string exe_path, std::string args) {
+  return ProcessKeyInterner::GetInstance().Intern(std::move(comm), std::move(exe_path), std::move(args));
+}
+
+constexpr std::chrono::milliseconds ProcessStore::kBatchResolutionTimeout;
+constexpr size_t ProcessStore::kNumShards;
+constexpr size_t ProcessStore::kDefaultMaxSize;
+
+ProcessStore::Cache::Cache(size_t max_size)
+    : max_shard_size_(std::max<size_t>(1, max_size / kNumShards)) {}
 
-  if (cached_process_pair_iter != cache_->end()) {
-    return cached_process_pair_iter->second.lock();
+std::shared_ptr<Process> ProcessStore::Cache::Find(uint64_t pid) {
+  auto& shard = ShardFor(pid);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  auto it = shard.processes.find(pid);
+  if (it == shard.processes.end()) {
+    return nullptr;
   }
 
-  std::shared_ptr<Process> cached_process = std::make_shared<Process>(pid, cache_, falco_instance_);
+  return it->second.lock();
+}
+
+std::shared_ptr<Process> ProcessStore::Cache::Insert(const std::shared_ptr<Process>& process) {
+  auto& shard = ShardFor(process->pid());
+  std::lock_guard<std::mutex> lock(shard.mutex);
 
-  cache_->emplace(pid, cached_process);
-  return cached_process;
+  auto it = shard.processes.find(process->pid());
+  if (it != shard.processes.end()) {
+    if (auto cached_process = it->second.lock()) {
+      return cached_process;
+    }
+    it->second = process;
+    return process;
+  }
+
+  if (shard.processes.size() >= max_shard_size_) {
+    // Entries are removed by processes being destroyed, purge the ones which did not get to it yet.
+    for (auto entry = shard.processes.begin(); entry != shard.processes.end();) {
+      entry = entry->second.expired() ? shard.processes.erase(entry) : std::next(entry);
+    }
+
+    if (shard.processes.size() >= max_shard_size_) {
+      COUNTER_INC(CollectorStats::process_store_full);
+      return process;
+    }
+  }
+
+  shard.processes.emplace(process->pid(), process);
+  return process;
 }
 
-std::string Process::container_id() const {
-  WaitForProcessInfo();
+void ProcessStore::Cache::Erase(uint64_t pid) {
+  auto& shard = ShardFor(pid);
+  std::lock_guard<std::mutex> lock(shard.mutex);
 
-  if (falco_threadinfo_) {
-    return falco_threadinfo_->m_container_id;
+  auto it = shard.processes.find(pid);
+  if (it != shard.processes.end() && it->second.expired()) {
+    shard.processes.erase(it);
   }
+}
 
-  return NOT_AVAILABLE;
+size_t ProcessStore::Cache::Size() const {
+  size_t size = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size += shard.processes.size();
+  }
+  return size;
 }
 
-std::string Process::comm() const {
-  WaitForProcessInfo();
+ProcessStore::ProcessStore(SysdigService* falco_instance, std::string host_proc, size_t max_size)
+    : falco_instance_(falco_instance), host_proc_(std::move(host_proc)), cache_(std::make_shared<Cache>(max_size)) {
+}
+
+std::shared_ptr<Process> ProcessStore::FindOrCreate(uint64_t pid, bool* created) {
+  *created = false;
 
-  if (falco_threadinfo_) {
-    return falco_threadinfo_->get_comm();
+  if (auto process = cache_->Find(pid)) {
+    return process;
   }
 
-  return NOT_AVAILABLE;
+  // The process is marked as pending before it is published, and its information is requested by the
+  // caller only once it is known to be the cached one.
+  auto process = std::make_shared<Process>(pid, cache_);
+  process->process_info_pending_resolution_ = true;
+
+  auto cached_process = cache_->Insert(process);
+  *created = cached_process == process;
+
+  return cached_process;
 }
 
-std::string Process::exe() const {
+const std::shared_ptr<IProcess> ProcessStore::Fetch(uint64_t pid) {
+  bool created;
+  auto process = FindOrCreate(pid, &created);
+
+  if (created) {
+    if (falco_instance_) {
+      falco_instance_->GetProcessInformation(pid, process->falco_callback_);
+    } else {
+      process->ResolveFromProcfs(host_proc_);
+    }
+  }
+
+  return process;
+}
+
+std::vector<std::shared_ptr<IProcess>> ProcessStore::FetchBatch(const std::vector<uint64_t>& pids) {
+  std::vector<std::shared_ptr<IProcess>> processes;
+  processes.reserve(pids.size());
+
+  std::vector<std::shared_ptr<Process>> unresolved;
+  std::vector<uint64_t> unresolved_pids;
+
+  for (uint64_t pid : pids) {
+    bool created;
+    auto process = FindOrCreate(pid, &created);
+
+    if (created) {
+      unresolved.push_back(process);
+      unresolved_pids.push_back(pid);
+    }
+
+    processes.push_back(std::move(process));
+  }
+
+  if (unresolved.empty()) {
+    return processes;
+  }
+
+  if (falco_instance_) {
+    struct BatchState {
+      std::mutex mutex;
+      std::condition_variable condition;
+      bool done = false;
+    };
+    auto state = std::make_shared<BatchState>();
+
+    // The callback holds the only strong reference to the batch state handed over to the event thread,
+    // so a late resolution after the timeout is simply dropped.
+    auto callback = std::make_shared<std::function<void(const std::vector<std::shared_ptr<sinsp_threadinfo>>&)>>(
+        [unresolved, state](const std::vector<std::shared_ptr<sinsp_threadinfo>>& process_infos) {
+          for (size_t i = 0; i < unresolved.size() && i < process_infos.size(); i++) {
+            unresolved[i]->ResolveFromThreadInfo(process_infos[i].get());
+          }
+
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->done = true;
+          state->condition.notify_all();
+        });
+
+    falco_instance_->GetProcessInformationBatch(std::move(unresolved_pids), callback);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    WITH_TIMER(CollectorStats::process_info_batch_wait) {
+      if (!state->condition.wait_for(lock, kBatchResolutionTimeout, [&state] { return state->done; })) {
+        COUNTER_INC(CollectorStats::process_info_batch_timeouts);
+      }
+    }
+  }
+
+  // Anything Falco could not resolve in time is read from procfs.
+  for (auto& process : unresolved) {
+    process->ResolveFromProcfs(host_proc_);
+  }
+
+  return processes;
+}
+
+std::string Process::container_id() const {
   WaitForProcessInfo();
 
-  if (falco_threadinfo_) {
-    return falco_threadinfo_->get_exe();
+  if (process_info_available_) {
+    return container_id_;
   }
 
   return NOT_AVAILABLE;
 }
 
-std::string Process::exe_path() const {
+std::string Process::comm() const {
+  return key()->comm;
+}
+
+std::string Process::exe() const {
   WaitForProcessInfo();
 
-  if (falco_threadinfo_) {
-    return falco_threadinfo_->get_exepath();
+  if (process_info_available_) {
+    return exe_;
   }
 
   return NOT_AVAILABLE;
 }
 
+std::string Process::exe_path() const {
+  return key()->exe_path;
+}
+
 std::string Process::args() const {
-  WaitForProcessInfo();
+  return key()->args;
+}
 
-  if (!falco_threadinfo_) {
-    return NOT_AVAILABLE;
-  }
+const ProcessKey* Process::key() const {
+  WaitForProcessInfo();
 
-  if (falco_threadinfo_->m_args.empty()) {
-    return "";
+  if (process_info_available_) {
+    return key_.get();
   }
 
-  std::ostringstream args;
-  for (auto it = falco_threadinfo_->m_args.begin(); it != falco_threadinfo_->m_args.end();) {
-    args << *it++;
-    if (it != falco_threadinfo_->m_args.end()) args << " ";
-  }
-  return args.str();
+  return NotAvailableKey().get();
 }
 
 Process::Process(
@@ -103,8 +316,22 @@ Process::Process(
 
 Process::~Process() {
   if (cache_) {
-    cache_->erase(pid_);
+    cache_->Erase(pid_);
+  }
+}
+
+void Process::SetProcessInfoNoLock(const sinsp_threadinfo& process_info) {
+  container_id_ = process_info.m_container_id;
+  exe_ = process_info.get_exe();
+
+  std::string args;
+  for (auto it = process_info.m_args.begin(); it != process_info.m_args.end();) {
+    args += *it++;
+    if (it != process_info.m_args.end()) args += ' ';
   }
+
+  key_ = ProcessKey::Intern(process_info.get_comm(), process_info.get_exepath(), std::move(args));
+  process_info_available_ = true;
 }
 
 void Process::ProcessInfoResolved(std::shared_ptr<sinsp_threadinfo> process_info) {
@@ -112,11 +339,62 @@ void Process::ProcessInfoResolved(std::shared_ptr<sinsp_threadinfo> process_info
 
   if (process_info) {
     CLOG(DEBUG) << "Process-info resolved. PID: " << pid() << " Exe: " + process_info->m_exe;
+    SetProcessInfoNoLock(*process_info);
   } else {
     CLOG(WARNING) << "Process-info request failed. PID: " << pid();
   }
 
-  falco_threadinfo_ = process_info;
+  process_info_pending_resolution_ = false;
+
+  process_info_condition_.notify_all();
+}
+
+bool Process::ResolveFromThreadInfo(const sinsp_threadinfo* process_info) {
+  if (!process_info) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(process_info_mutex_);
+
+  if (process_info_pending_resolution_) {
+    CLOG(DEBUG) << "Process-info resolved. PID: " << pid() << " Exe: " + process_info->m_exe;
+    SetProcessInfoNoLock(*process_info);
+    process_info_pending_resolution_ = false;
+    process_info_condition_.notify_all();
+  }
+
+  return true;
+}
+
+void Process::ResolveFromProcfs(const std::string& host_proc) {
+  {
+    std::unique_lock<std::mutex> lock(process_info_mutex_);
+    if (!process_info_pending_resolution_) {
+      return;
+    }
+  }
+
+  ProcessScraper::ProcessInfo process_info;
+  bool scraped = !host_proc.empty() && ProcessScraper(host_proc).Scrape(pid_, process_info);
+
+  std::unique_lock<std::mutex> lock(process_info_mutex_);
+
+  if (!process_info_pending_resolution_) {
+    return;
+  }
+
+  if (scraped) {
+    CLOG(DEBUG) << "Process-info read from procfs. PID: " << pid() << " Exe: " + process_info.exe;
+    COUNTER_INC(CollectorStats::process_info_procfs_fallback);
+
+    container_id_ = std::move(process_info.container_id);
+    exe_ = std::move(process_info.exe);
+    key_ = ProcessKey::Intern(std::move(process_info.comm), std::move(process_info.exe_path), std::move(process_info.args));
+    process_info_available_ = true;
+  } else if (!host_proc.empty()) {
+    CLOG(WARNING) << "Process-info request failed. PID: " << pid();
+  }
+
   process_info_pending_resolution_ = false;
 
   process_info_condition_.notify_all();
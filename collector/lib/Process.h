@@ -1,6 +1,8 @@
 #ifndef COLLECTOR_PROCESS_H
 #define COLLECTOR_PROCESS_H
 
+#include <array>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
@@ -8,6 +10,7 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 // forward declarations
 class sinsp_threadinfo;
@@ -18,23 +21,88 @@ class SysdigService;
 }  // namespace collector
 
 namespace collector {
+
+/* The attributes identifying a process when it is advertised as the originator of an endpoint
+   (see storage::NetworkProcessUniqueKey).
+   Keys are interned: while a key is referenced, every process with the same attributes shares it,
+   so two keys are equal if and only if they are the same object. */
+struct ProcessKey {
+  std::string comm;
+  std::string exe_path;
+  std::string args;
+
+  static std::shared_ptr<const ProcessKey> Intern(std::string comm, std::string exe_path, std::string args);
+};
+
 /* A Process object store used to deduplicate process information.
    Processes are kept in the store as long as they are referenced from the outside.
-   When a process cannot be found in the store, it is fetched as a side-effect. */
+   When a process cannot be found in the store, it is fetched as a side-effect.
+   The store can be used concurrently from multiple threads. */
 class ProcessStore {
  public:
-  /* falco_instance is the source of process information */
-  ProcessStore(SysdigService* falco_instance);
+  /* How long FetchBatch waits for Falco to resolve the processes of a batch before
+     falling back to procfs. */
+  static constexpr std::chrono::milliseconds kBatchResolutionTimeout{100};
+  static constexpr size_t kNumShards = 16;
+  static constexpr size_t kDefaultMaxSize = 1 << 16;
+
+  /* Processes known to the store, split in shards with their own lock so that lookups, and
+     removals by processes being destroyed, rarely contend. */
+  class Cache {
+   public:
+    explicit Cache(size_t max_size = kDefaultMaxSize);
+
+    /* Returns the live process cached for pid, if any. */
+    std::shared_ptr<Process> Find(uint64_t pid);
+
+    /* Caches process, and returns it. If another live process has been cached for the same pid
+       in the meantime, that one is returned instead. When the shard is full, process is returned
+       without being cached. */
+    std::shared_ptr<Process> Insert(const std::shared_ptr<Process>& process);
+
+    /* Forgets pid, unless it is cached by a live process. */
+    void Erase(uint64_t pid);
+
+    size_t Size() const;
+
+   private:
+    struct Shard {
+      mutable std::mutex mutex;
+      std::unordered_map<uint64_t, std::weak_ptr<Process>> processes;
+    };
+
+    Shard& ShardFor(uint64_t pid) { return shards_[pid % kNumShards]; }
+
+    std::array<Shard, kNumShards> shards_;
+    size_t max_shard_size_;
+  };
+
+  typedef std::shared_ptr<Cache> MapRef;
+
+  /* falco_instance is the source of process information.
+     host_proc, when provided, is used to read the information of processes Falco cannot resolve.
+     max_size bounds the number of processes the store keeps track of. */
+  ProcessStore(SysdigService* falco_instance, std::string host_proc = "", size_t max_size = kDefaultMaxSize);
 
   /* Get a Process by PID.
      Returns a reference to the cached Process entry, which may have just been created
      if it wasn't already known. */
   const std::shared_ptr<IProcess> Fetch(uint64_t pid);
 
-  typedef std::shared_ptr<std::unordered_map<uint64_t, std::weak_ptr<Process>>> MapRef;
+  /* Get the Processes for a list of PIDs, in the same order.
+     All PIDs not yet known are resolved by Falco in a single pass of the event loop. Processes
+     which Falco does not know, or which are not resolved within kBatchResolutionTimeout, are read
+     from procfs, so the returned processes never wait on the event loop. */
+  std::vector<std::shared_ptr<IProcess>> FetchBatch(const std::vector<uint64_t>& pids);
+
+  size_t Size() const { return cache_->Size(); }
 
  private:
+  /* Returns the process cached for pid, or a new one pending resolution. created tells which. */
+  std::shared_ptr<Process> FindOrCreate(uint64_t pid, bool* created);
+
   SysdigService* falco_instance_;
+  std::string host_proc_;
   MapRef cache_;
 };
 
@@ -47,6 +115,10 @@ class IProcess {
   virtual std::string exe_path() const = 0;
   virtual std::string args() const = 0;
 
+  /* The interned key of the process, when the implementation provides one.
+     Processes with the same non-null key have the same comm, exe_path and args. */
+  virtual const ProcessKey* key() const { return nullptr; }
+
   virtual bool operator==(IProcess& other) {
     return pid() == other.pid();
   }
@@ -63,6 +135,7 @@ class Process : public IProcess {
   std::string exe() const override;
   std::string exe_path() const override;
   std::string args() const override;
+  const ProcessKey* key() const override;
 
   /* - when 'cache' is provided, this process will remove itself from it upon deletion.
    * - 'falco_instance' is used to request the process information from the system. */
@@ -70,6 +143,8 @@ class Process : public IProcess {
   ~Process();
 
  private:
+  friend class ProcessStore;
+
   static const std::string NOT_AVAILABLE;  // = "N/A"
 
   uint64_t pid_;
@@ -80,14 +155,27 @@ class Process : public IProcess {
   mutable std::mutex process_info_mutex_;
   mutable std::condition_variable process_info_condition_;
 
-  // Underlying thread info provided asynchronously by Falco via falco_callback_
-  mutable std::shared_ptr<sinsp_threadinfo> falco_threadinfo_;
+  // Process information, copied from the first source which resolved it.
+  bool process_info_available_ = false;
+  std::string container_id_;
+  std::string exe_;
+  std::shared_ptr<const ProcessKey> key_;
+
   // use a shared pointer here to handle deletion while the callback is pending
   std::shared_ptr<std::function<void(std::shared_ptr<sinsp_threadinfo>)>> falco_callback_;
 
   // entry-point when Falco resolved the requested process info
   void ProcessInfoResolved(std::shared_ptr<sinsp_threadinfo> process_info);
 
+  // Fill in the process information from the thread info provided by Falco, unless it has already been
+  // resolved. Returns false if there is no thread info.
+  bool ResolveFromThreadInfo(const sinsp_threadinfo* process_info);
+
+  void SetProcessInfoNoLock(const sinsp_threadinfo& process_info);
+
+  // Fill in the process information by reading it from the host procfs, unless it has already been resolved.
+  void ResolveFromProcfs(const std::string& host_proc);
+
   // block until process information is available, or timeout
   void WaitForProcessInfo() const;
 };
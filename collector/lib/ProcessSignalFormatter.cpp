@@ -1,12 +1,13 @@
 #include "ProcessSignalFormatter.h"
 
-#include <uuid/uuid.h>
+#include <algorithm>
 
 #include <google/protobuf/util/time_util.h>
 
 #include "internalapi/sensor/signal_iservice.pb.h"
 
 #include "CollectorStats.h"
+#include "EnrichmentDegrader.h"
 #include "EventMap.h"
 #include "Logging.h"
 #include "Utility.h"
@@ -35,16 +36,21 @@ static EventMap<ProcessSignalType> process_signals = {
     ProcessSignalType::UNKNOWN_PROCESS_TYPE,
 };
 
-std::string extract_proc_args(sinsp_threadinfo* tinfo) {
-  if (tinfo->m_args.empty()) return "";
-  std::ostringstream args;
-  for (auto it = tinfo->m_args.begin(); it != tinfo->m_args.end();) {
-    args << *it++;
-    if (it != tinfo->m_args.end()) args << " ";
+// Joins the arguments of the process into args, reusing its capacity, up to max_length bytes.
+void join_proc_args(const sinsp_threadinfo* tinfo, std::string* args, size_t max_length) {
+  args->clear();
+  for (size_t i = 0; i < tinfo->m_args.size() && args->size() < max_length; i++) {
+    if (i > 0) args->push_back(' ');
+    args->append(tinfo->m_args[i]);
+  }
+  if (args->size() > max_length) {
+    args->resize(max_length);
   }
-  return args.str();
 }
 
+// Limit max number of ancestors
+constexpr size_t kMaxLineageAncestors = 10;
+
 }  // namespace
 
 const SignalStreamMessage* ProcessSignalFormatter::ToProtoMessage(sinsp_evt* event) {
@@ -52,49 +58,51 @@ const SignalStreamMessage* ProcessSignalFormatter::ToProtoMessage(sinsp_evt* eve
     return nullptr;
   }
 
-  Reset();
+  // The exec changes the path reported for this process in the lineage of its descendants.
+  if (const sinsp_threadinfo* tinfo = event->get_thread_info()) {
+    InvalidateLineage(*tinfo);
+  }
 
   if (!ValidateProcessDetails(event)) {
     CLOG(INFO) << "Dropping process event: " << ProcessDetails(event);
     return nullptr;
   }
 
-  ProcessSignal* process_signal = CreateProcessSignal(event);
-  if (!process_signal) return nullptr;
+  if (!CreateProcessSignal(event)) return nullptr;
+
+  return &message_;
+}
 
-  Signal* signal = Allocate<Signal>();
-  signal->set_allocated_process_signal(process_signal);
+void ProcessSignalFormatter::InvalidateLineage(const sinsp_threadinfo& tinfo) {
+  lineage_cache_.Invalidate(tinfo.m_tid);
+  if (tinfo.m_pid != tinfo.m_tid) {
+    lineage_cache_.Invalidate(tinfo.m_pid);
+  }
+}
 
-  SignalStreamMessage* signal_stream_message = AllocateRoot();
-  signal_stream_message->clear_collector_register_request();
-  signal_stream_message->set_allocated_signal(signal);
-  return signal_stream_message;
+void ProcessSignalFormatter::SetLineageCaching(bool enabled) {
+  lineage_caching_ = enabled;
+  if (!enabled) {
+    lineage_cache_.Clear();
+  }
 }
 
 const SignalStreamMessage* ProcessSignalFormatter::ToProtoMessage(sinsp_threadinfo* tinfo) {
-  Reset();
   if (!ValidateProcessDetails(tinfo)) {
     CLOG(INFO) << "Dropping process event: " << tinfo;
     return nullptr;
   }
 
-  ProcessSignal* process_signal = CreateProcessSignal(tinfo);
-  if (!process_signal) return nullptr;
+  if (!CreateProcessSignal(tinfo)) return nullptr;
 
-  Signal* signal = Allocate<Signal>();
-  signal->set_allocated_process_signal(process_signal);
-
-  SignalStreamMessage* signal_stream_message = AllocateRoot();
-  signal_stream_message->clear_collector_register_request();
-  signal_stream_message->set_allocated_signal(signal);
-  return signal_stream_message;
+  return &message_;
 }
 
 ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_evt* event) {
-  auto signal = Allocate<ProcessSignal>();
+  ProcessSignal* signal = ReuseProcessSignal();
 
   // set id
-  signal->set_id(UUIDStr());
+  signal->mutable_id()->assign(UUIDStr(), kUUIDStringLength);
 
   const std::string* name = event_extractor_.get_comm(event);
   const std::string* exepath = event_extractor_.get_exepath(event);
@@ -114,7 +122,8 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_evt* event) {
   }
 
   // set process arguments
-  if (const char* args = event_extractor_.get_proc_args(event)) signal->set_args(args);
+  const sinsp_threadinfo* tinfo = event->get_thread_info();
+  if (tinfo && enrichment_tier_ < EnrichmentDegrader::kMinimal) join_proc_args(tinfo, signal->mutable_args(), MaxArgsLength());
 
   // set pid
   if (const int64_t* pid = event_extractor_.get_pid(event)) signal->set_pid(*pid);
@@ -124,9 +133,7 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_evt* event) {
   if (const uint32_t* gid = event_extractor_.get_gid(event)) signal->set_gid(*gid);
 
   // set time
-  auto timestamp = Allocate<Timestamp>();
-  *timestamp = TimeUtil::NanosecondsToTimestamp(event->get_ts());
-  signal->set_allocated_time(timestamp);
+  *signal->mutable_time() = TimeUtil::NanosecondsToTimestamp(event->get_ts());
 
   // set container_id
   if (const std::string* container_id = event_extractor_.get_container_id(event)) {
@@ -134,13 +141,9 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_evt* event) {
   }
 
   // set process lineage
-  std::vector<LineageInfo> lineage;
-  this->GetProcessLineage(event->get_thread_info(), lineage);
-  for (const auto& p : lineage) {
-    auto signal_lineage = signal->add_lineage_info();
-    signal_lineage->set_parent_exec_file_path(p.parent_exec_file_path());
-    signal_lineage->set_parent_uid(p.parent_uid());
-  }
+  if (enrichment_tier_ < EnrichmentDegrader::kMinimal) AddProcessLineage(signal, event->get_thread_info());
+
+  if (enrichment_tier_ > EnrichmentDegrader::kFull) COUNTER_INC(CollectorStats::process_signals_degraded);
 
   CLOG(DEBUG) << "Process (" << signal->container_id() << ": " << signal->pid() << "): "
               << signal->name()
@@ -151,10 +154,10 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_evt* event) {
 }
 
 ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_threadinfo* tinfo) {
-  auto signal = Allocate<ProcessSignal>();
+  ProcessSignal* signal = ReuseProcessSignal();
 
   // set id
-  signal->set_id(UUIDStr());
+  signal->mutable_id()->assign(UUIDStr(), kUUIDStringLength);
 
   const auto& name = tinfo->m_comm;
   const auto& exepath = tinfo->m_exepath;
@@ -177,7 +180,7 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_threadinfo* tin
   signal->set_scraped(true);
 
   // set process arguments
-  signal->set_args(extract_proc_args(tinfo));
+  if (enrichment_tier_ < EnrichmentDegrader::kMinimal) join_proc_args(tinfo, signal->mutable_args(), MaxArgsLength());
 
   // set pid
   signal->set_pid(tinfo->m_pid);
@@ -187,22 +190,15 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_threadinfo* tin
   signal->set_gid(tinfo->m_group.gid);
 
   // set time
-  auto timestamp = Allocate<Timestamp>();
-  *timestamp = TimeUtil::NanosecondsToTimestamp(tinfo->m_clone_ts);
-  signal->set_allocated_time(timestamp);
+  *signal->mutable_time() = TimeUtil::NanosecondsToTimestamp(tinfo->m_clone_ts);
 
   // set container_id
   signal->set_container_id(tinfo->m_container_id);
 
   // set process lineage
-  std::vector<LineageInfo> lineage;
-  GetProcessLineage(tinfo, lineage);
+  if (enrichment_tier_ < EnrichmentDegrader::kMinimal) AddProcessLineage(signal, tinfo);
 
-  for (const auto& p : lineage) {
-    auto signal_lineage = signal->add_lineage_info();
-    signal_lineage->set_parent_exec_file_path(p.parent_exec_file_path());
-    signal_lineage->set_parent_uid(p.parent_uid());
-  }
+  if (enrichment_tier_ > EnrichmentDegrader::kFull) COUNTER_INC(CollectorStats::process_signals_degraded);
 
   CLOG(DEBUG) << "Process (" << signal->container_id() << ": " << signal->pid() << "): "
               << signal->name()
@@ -212,6 +208,17 @@ ProcessSignal* ProcessSignalFormatter::CreateProcessSignal(sinsp_threadinfo* tin
   return signal;
 }
 
+ProcessSignal* ProcessSignalFormatter::ReuseProcessSignal() {
+  // Clearing the signal keeps the capacity of its strings and its lineage entries, so that building a
+  // signal does not allocate once they have grown enough. Only the timestamp, a sub-message, would be
+  // freed by Clear(), it is moved out of the way meanwhile.
+  ProcessSignal* signal = message_.mutable_signal()->mutable_process_signal();
+  Timestamp* time = signal->release_time();
+  signal->Clear();
+  signal->set_allocated_time(time);
+  return signal;
+}
+
 std::string ProcessSignalFormatter::ProcessDetails(sinsp_evt* event) {
   std::stringstream ss;
   const std::string* path = event_extractor_.get_exepath(event);
@@ -247,32 +254,81 @@ bool ProcessSignalFormatter::ValidateProcessDetails(sinsp_evt* event) {
   return ValidateProcessDetails(tinfo);
 }
 
-int ProcessSignalFormatter::GetTotalStringLength(const std::vector<LineageInfo>& lineage) {
-  int totalStringLength = 0;
-  for (LineageInfo l : lineage) totalStringLength += l.parent_exec_file_path().size();
-
-  return totalStringLength;
+size_t ProcessSignalFormatter::MaxArgsLength() const {
+  if (enrichment_tier_ >= EnrichmentDegrader::kTruncatedArgs) {
+    return EnrichmentDegrader::kTruncatedArgsLength;
+  }
+  return std::string::npos;
 }
 
-void ProcessSignalFormatter::CountLineage(const std::vector<LineageInfo>& lineage) {
-  int totalStringLength = GetTotalStringLength(lineage);
+void ProcessSignalFormatter::CountLineage(size_t size, size_t string_length) {
   COUNTER_INC(CollectorStats::process_lineage_counts);
-  COUNTER_ADD(CollectorStats::process_lineage_total, lineage.size());
-  COUNTER_ADD(CollectorStats::process_lineage_sqr_total, lineage.size() * lineage.size());
-  COUNTER_ADD(CollectorStats::process_lineage_string_total, totalStringLength);
+  COUNTER_ADD(CollectorStats::process_lineage_total, size);
+  COUNTER_ADD(CollectorStats::process_lineage_sqr_total, size * size);
+  COUNTER_ADD(CollectorStats::process_lineage_string_total, string_length);
 }
 
 void ProcessSignalFormatter::GetProcessLineage(sinsp_threadinfo* tinfo,
                                                std::vector<LineageInfo>& lineage) {
-  if (tinfo == NULL) return;
+  const LineageCache::Lineage* cached = GetLineage(tinfo, kMaxLineageAncestors);
+  if (cached == nullptr) return;
+
+  for (const auto& ancestor : cached->ancestors) {
+    LineageInfo info;
+    info.set_parent_uid(ancestor.uid);
+    info.set_parent_exec_file_path(ancestor.exec_file_path);
+    lineage.push_back(info);
+  }
+  CountLineage(cached->ancestors.size(), cached->string_length);
+}
+
+void ProcessSignalFormatter::AddProcessLineage(ProcessSignal* signal, sinsp_threadinfo* tinfo) {
+  size_t max_ancestors = enrichment_tier_ >= EnrichmentDegrader::kParentLineage ? 1 : kMaxLineageAncestors;
+  const LineageCache::Lineage* lineage = GetLineage(tinfo, max_ancestors);
+  if (lineage == nullptr) return;
+
+  size_t size = std::min(lineage->ancestors.size(), max_ancestors);
+  size_t string_length = 0;
+  for (size_t i = 0; i < size; i++) {
+    const auto& ancestor = lineage->ancestors[i];
+    auto signal_lineage = signal->add_lineage_info();
+    signal_lineage->set_parent_exec_file_path(ancestor.exec_file_path);
+    signal_lineage->set_parent_uid(ancestor.uid);
+    string_length += ancestor.exec_file_path.size();
+  }
+  CountLineage(size, string_length);
+}
+
+const LineageCache::Lineage* ProcessSignalFormatter::GetLineage(sinsp_threadinfo* tinfo, size_t max_ancestors) {
+  if (tinfo == NULL) return nullptr;
   sinsp_threadinfo* mt = NULL;
   if (tinfo->is_main_thread()) {
     mt = tinfo;
   } else {
     mt = tinfo->get_main_thread();
-    if (mt == NULL) return;
+    if (mt == NULL) return nullptr;
   }
-  sinsp_threadinfo::visitor_func_t visitor = [this, &lineage](sinsp_threadinfo* pt) {
+
+  // The lineage only depends on the ancestors, so it is shared by all the children of a parent.
+  sinsp_threadinfo* parent = mt->get_parent_thread();
+  if (parent == NULL) {
+    static const LineageCache::Lineage kNoLineage;
+    return &kNoLineage;
+  }
+
+  LineageCache::Key key{parent->m_tid, parent->m_clone_ts, parent->m_lastexec_ts};
+  if (lineage_caching_) {
+    if (const LineageCache::Lineage* cached = lineage_cache_.Find(key)) {
+      return cached;
+    }
+  }
+
+  // A partial lineage is not cached, it is only collected to spare the walk of all ancestors. No lineage is
+  // while caching is disabled.
+  bool cache = lineage_caching_ && max_ancestors >= kMaxLineageAncestors;
+  LineageCache::Lineage lineage;
+  std::vector<int64_t> visited{parent->m_tid};
+  sinsp_threadinfo::visitor_func_t visitor = [parent, max_ancestors, &lineage, &visited](sinsp_threadinfo* pt) {
     if (pt == NULL) return false;
     if (pt->m_pid == 0) return false;
 
@@ -297,21 +353,26 @@ void ProcessSignalFormatter::GetProcessLineage(sinsp_threadinfo* tinfo,
 
     if (pt->m_vpid == -1) return false;
 
+    if (pt != parent) visited.push_back(pt->m_tid);
+
     // Collapse parent child processes that have the same path
-    if (lineage.empty() || (lineage.back().parent_exec_file_path() != pt->m_exepath)) {
-      LineageInfo info;
-      info.set_parent_uid(pt->m_user.uid);
-      info.set_parent_exec_file_path(pt->m_exepath);
-      lineage.push_back(info);
+    auto& ancestors = lineage.ancestors;
+    if (ancestors.empty() || (ancestors.back().exec_file_path != pt->m_exepath)) {
+      ancestors.push_back({pt->m_exepath, pt->m_user.uid});
+      lineage.string_length += pt->m_exepath.size();
     }
 
-    // Limit max number of ancestors
-    if (lineage.size() >= 10) return false;
+    if (ancestors.size() >= max_ancestors) return false;
 
     return true;
   };
   mt->traverse_parent_state(visitor);
-  CountLineage(lineage);
+
+  if (!cache) {
+    uncached_lineage_ = std::move(lineage);
+    return &uncached_lineage_;
+  }
+  return lineage_cache_.Insert(key, std::move(lineage), std::move(visited));
 }
 
 }  // namespace collector
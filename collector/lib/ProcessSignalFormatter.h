@@ -7,6 +7,7 @@
 
 #include "CollectorStats.h"
 #include "EventNames.h"
+#include "LineageCache.h"
 #include "ProtoSignalFormatter.h"
 #include "SysdigEventExtractor.h"
 
@@ -27,6 +28,17 @@ class ProcessSignalFormatter : public ProtoSignalFormatter<sensor::SignalStreamM
 
   void GetProcessLineage(sinsp_threadinfo* tinfo, std::vector<LineageInfo>& lineage);
 
+  // Drops the cached lineages which include the thread, when it execs or exits.
+  void InvalidateLineage(int64_t tid) { lineage_cache_.Invalidate(tid); }
+  void InvalidateLineage(const sinsp_threadinfo& tinfo);
+
+  // Whether lineages are cached, which requires every event invalidating them to be handled. Disabling
+  // caching clears the cache.
+  void SetLineageCaching(bool enabled);
+
+  // One of the EnrichmentDegrader tiers, which tells which details are left out of the signals.
+  void SetEnrichmentTier(int tier) { enrichment_tier_ = tier; }
+
  private:
   Signal* CreateSignal(sinsp_evt* event);
   ProcessSignal* CreateProcessSignal(sinsp_evt* event);
@@ -36,11 +48,23 @@ class ProcessSignalFormatter : public ProtoSignalFormatter<sensor::SignalStreamM
 
   Signal* CreateSignal(sinsp_threadinfo* tinfo);
   ProcessSignal* CreateProcessSignal(sinsp_threadinfo* tinfo);
-  int GetTotalStringLength(const std::vector<LineageInfo>& lineage);
-  void CountLineage(const std::vector<LineageInfo>& lineage);
+  ProcessSignal* ReuseProcessSignal();
+  const LineageCache::Lineage* GetLineage(sinsp_threadinfo* tinfo, size_t max_ancestors);
+  void AddProcessLineage(ProcessSignal* signal, sinsp_threadinfo* tinfo);
+  void CountLineage(size_t size, size_t string_length);
+  size_t MaxArgsLength() const;
 
   const EventNames& event_names_;
   SysdigEventExtractor event_extractor_;
+  LineageCache lineage_cache_;
+  bool lineage_caching_ = true;
+  // The last lineage collected without being cached.
+  LineageCache::Lineage uncached_lineage_;
+  int enrichment_tier_ = 0;
+
+  // The message returned for every signal. Process signals are not allocated from the arena: resetting it
+  // would free the buffers of their strings, while this message keeps them from one signal to the next.
+  sensor::SignalStreamMessage message_;
 };
 
 }  // namespace collector
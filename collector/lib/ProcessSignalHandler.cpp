@@ -1,71 +1,225 @@
 #include "ProcessSignalHandler.h"
 
-#include <sstream>
+#include <algorithm>
+#include <limits>
+
+#include <google/protobuf/util/time_util.h>
 
 #include "storage/process_indicator.pb.h"
 
+#include "Logging.h"
 #include "RateLimit.h"
 
 namespace collector {
 
-std::string compute_process_key(const ::storage::ProcessSignal& s) {
-  std::stringstream ss;
-  ss << s.container_id() << " " << s.name() << " ";
-  if (s.args().length() <= 256) {
-    ss << s.args();
-  } else {
-    ss.write(s.args().c_str(), 256);
+Hash128 compute_process_key(const ::storage::ProcessSignal& s) {
+  StreamingHash128 hash;
+  hash.Add(s.container_id()).Add(s.name());
+  hash.Add(s.args().data(), std::min<size_t>(s.args().size(), 256));
+  hash.Add(s.exec_file_path());
+  return hash.Finish();
+}
+
+Hash128 compute_exec_key(sinsp_threadinfo& tinfo) {
+  StreamingHash128 hash;
+  hash.Add(tinfo.m_container_id).Add(tinfo.m_exepath);
+  // Execs by another user or from another parent are reported separately, with their own credentials and
+  // lineage.
+  uint32_t uid = tinfo.m_user.uid;
+  hash.Add(reinterpret_cast<const char*>(&uid), sizeof(uid));
+  sinsp_threadinfo* mt = tinfo.is_main_thread() ? &tinfo : tinfo.get_main_thread();
+  sinsp_threadinfo* parent = mt ? mt->get_parent_thread() : nullptr;
+  int64_t parent_pid = parent ? parent->m_pid : -1;
+  hash.Add(reinterpret_cast<const char*>(&parent_pid), sizeof(parent_pid));
+  if (parent) {
+    hash.Add(parent->m_exepath);
+  }
+  // Only a prefix of the arguments, like for rate limiting.
+  size_t remaining = 256;
+  for (const auto& arg : tinfo.m_args) {
+    if (remaining == 0) break;
+    size_t length = std::min(arg.size(), remaining);
+    hash.Add(arg.data(), length);
+    remaining -= length;
   }
-  ss << " " << s.exec_file_path();
-  return ss.str();
+  return hash.Finish();
+}
+
+void ProcessSignalHandler::EnablePipeline(size_t queue_capacity) {
+  pipeline_ = std::make_unique<SignalPipeline<SignalStreamMessage>>(
+      queue_capacity, kMaxBackpressure,
+      SignalPipeline<SignalStreamMessage>::Counters{
+          CollectorStats::process_pipeline_queue_depth,
+          CollectorStats::process_pipeline_queue_full,
+          CollectorStats::process_pipeline_dropped,
+      });
+}
+
+void ProcessSignalHandler::EnableExecCoalescing(std::chrono::nanoseconds window) {
+  coalescer_ = std::make_unique<ExecCoalescer>(window.count());
 }
 
 bool ProcessSignalHandler::Start() {
   client_->Start();
+  if (pipeline_) {
+    return pipeline_->Start([this](SignalStreamMessage& signal_msg) { SendFromPipeline(signal_msg); });
+  }
   return true;
 }
 
 bool ProcessSignalHandler::Stop() {
+  if (pipeline_) {
+    pipeline_->Stop();
+    stats_->nProcessSendFailures += pipeline_drops_.exchange(0, std::memory_order_relaxed);
+  }
+  if (coalescer_) {
+    // The windows still open are closed early rather than losing their execs. With the pipeline stopped, the
+    // summaries are sent from this thread.
+    SendExecSummaries(std::numeric_limits<uint64_t>::max());
+  }
   client_->Stop();
   rate_limiter_.ResetRateLimitCache();
   return true;
 }
 
 SignalHandler::Result ProcessSignalHandler::HandleSignal(sinsp_evt* evt) {
+  if (degrader_) {
+    UpdateEnrichmentTier();
+  }
+
+  if (needs_refresh_.exchange(false)) {
+    return NEEDS_REFRESH;
+  }
+
+  if (coalescer_) {
+    last_event_ts_ = evt->get_ts();
+    last_event_time_ = std::chrono::steady_clock::now();
+    SendExecSummaries(last_event_ts_);
+  }
+
+  switch (evt->get_type()) {
+    case PPME_PROCEXIT_E:
+    case PPME_PROCEXIT_1_E:
+      formatter_.InvalidateLineage(evt->get_tid());
+      return IGNORED;
+    case PPME_SYSCALL_SETUID_X:
+    case PPME_SYSCALL_SETRESUID_X:
+      // The uid reported for this process in the lineage of its descendants may have changed.
+      if (const sinsp_threadinfo* tinfo = evt->get_thread_info()) {
+        formatter_.InvalidateLineage(*tinfo);
+      }
+      return IGNORED;
+    default:
+      break;
+  }
+
+  sinsp_threadinfo* tinfo = coalescer_ ? evt->get_thread_info() : nullptr;
+  Hash128 exec_key;
+  if (tinfo) {
+    exec_key = compute_exec_key(*tinfo);
+    if (ExecCoalescer::Summary* summary = coalescer_->Coalesce(exec_key, evt->get_ts())) {
+      if (summary->count == 1) {
+        // Formatting the first coalesced exec is enough, the following ones have the same details.
+        if (const auto* signal_msg = formatter_.ToProtoMessage(evt)) {
+          summary->signal_msg = *signal_msg;
+        }
+      } else {
+        formatter_.InvalidateLineage(*tinfo);
+      }
+      return IGNORED;
+    }
+  }
+
   const auto* signal_msg = formatter_.ToProtoMessage(evt);
   if (!signal_msg) {
     ++(stats_->nProcessResolutionFailuresByEvt);
     return IGNORED;
   }
 
-  if (!rate_limiter_.Allow(compute_process_key(signal_msg->signal().process_signal()))) {
-    ++(stats_->nProcessRateLimitCount);
-    return IGNORED;
+  if (tinfo) {
+    coalescer_->Open(exec_key, evt->get_ts());
   }
+  return Dispatch(*signal_msg);
+}
 
-  auto result = client_->PushSignals(*signal_msg);
-  if (result == SignalHandler::PROCESSED) {
-    ++(stats_->nProcessSent);
-  } else if (result == SignalHandler::ERROR) {
-    ++(stats_->nProcessSendFailures);
+void ProcessSignalHandler::SendExecSummaries(uint64_t ts) {
+  ExecCoalescer::Summary summary;
+  while (coalescer_->NextSummary(ts, &summary)) {
+    if (!summary.signal_msg.has_signal()) continue;
+
+    auto* signal = summary.signal_msg.mutable_signal()->mutable_process_signal();
+    signal->set_id(UUIDStr());
+    *signal->mutable_time() = google::protobuf::util::TimeUtil::NanosecondsToTimestamp(summary.last_ts);
+    CLOG(DEBUG) << "Coalesced " << summary.count << " execs of " << signal->exec_file_path()
+                << " (" << signal->container_id() << ") between " << summary.first_ts << " and " << summary.last_ts;
+
+    Dispatch(summary.signal_msg);
   }
+}
 
-  return result;
+void ProcessSignalHandler::UpdateEnrichmentTier() {
+  int tier = degrader_->Tier();
+  formatter_.SetEnrichmentTier(tier);
+  if (tier == EnrichmentDegrader::kMinimal) {
+    minimal_signals_sent_ = true;
+  } else if (tier == EnrichmentDegrader::kFull && minimal_signals_sent_) {
+    // Signals cannot tell they lack details, so send the existing processes again in full.
+    CLOG(INFO) << "Process enrichment recovered, sending the existing processes again";
+    minimal_signals_sent_ = false;
+    needs_refresh_.store(true);
+  }
 }
 
 SignalHandler::Result ProcessSignalHandler::HandleExistingProcess(sinsp_threadinfo* tinfo) {
+  if (degrader_) {
+    UpdateEnrichmentTier();
+  }
+
   const auto* signal_msg = formatter_.ToProtoMessage(tinfo);
   if (!signal_msg) {
     ++(stats_->nProcessResolutionFailuresByTinfo);
     return IGNORED;
   }
 
-  if (!rate_limiter_.Allow(compute_process_key(signal_msg->signal().process_signal()))) {
+  return Dispatch(*signal_msg);
+}
+
+SignalHandler::Result ProcessSignalHandler::Flush() {
+  if (degrader_) {
+    UpdateEnrichmentTier();
+  }
+
+  if (coalescer_ && last_event_ts_ != 0) {
+    // Windows are timed by the events, estimate the time of the next one as if they kept coming.
+    auto elapsed = std::chrono::steady_clock::now() - last_event_time_;
+    SendExecSummaries(last_event_ts_ + std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+
+  // A reconnect seen by the pipeline worker, or a recovered enrichment tier, must not wait for the next process
+  // event on a quiet node.
+  if (needs_refresh_.exchange(false)) {
+    return NEEDS_REFRESH;
+  }
+  return PROCESSED;
+}
+
+SignalHandler::Result ProcessSignalHandler::Dispatch(const SignalStreamMessage& signal_msg) {
+  if (pipeline_ && pipeline_->Running()) {
+    // The formatter reuses its message for every event, hand a copy over to the worker.
+    if (!pipeline_->Push(SignalStreamMessage(signal_msg))) {
+      // The process stats are owned by the worker once the pipeline runs, it accounts for the drop.
+      pipeline_drops_.fetch_add(1, std::memory_order_relaxed);
+      return ERROR;
+    }
+    return PROCESSED;
+  }
+
+  if (!rate_limiter_.Allow(compute_process_key(signal_msg.signal().process_signal()))) {
     ++(stats_->nProcessRateLimitCount);
     return IGNORED;
   }
 
-  auto result = client_->PushSignals(*signal_msg);
+  auto result = client_->PushSignals(signal_msg);
   if (result == SignalHandler::PROCESSED) {
     ++(stats_->nProcessSent);
   } else if (result == SignalHandler::ERROR) {
@@ -75,8 +229,31 @@ SignalHandler::Result ProcessSignalHandler::HandleExistingProcess(sinsp_threadin
   return result;
 }
 
+void ProcessSignalHandler::SendFromPipeline(SignalStreamMessage& signal_msg) {
+  stats_->nProcessSendFailures += pipeline_drops_.exchange(0, std::memory_order_relaxed);
+
+  if (!rate_limiter_.Allow(compute_process_key(signal_msg.signal().process_signal()))) {
+    ++(stats_->nProcessRateLimitCount);
+    return;
+  }
+
+  auto result = client_->PushSignals(signal_msg);
+  if (result == SignalHandler::NEEDS_REFRESH) {
+    // The existing processes are sent by the event thread, on its next event or flush. This signal was not
+    // written yet, send it right away rather than losing it.
+    needs_refresh_.store(true);
+    result = client_->PushSignals(signal_msg);
+  }
+
+  if (result == SignalHandler::PROCESSED) {
+    ++(stats_->nProcessSent);
+  } else if (result == SignalHandler::ERROR) {
+    ++(stats_->nProcessSendFailures);
+  }
+}
+
 std::vector<std::string> ProcessSignalHandler::GetRelevantEvents() {
-  return {"execve<"};
+  return {"execve<", "procexit", "setuid<", "setresuid<"};
 }
 
 }  // namespace collector
@@ -1,15 +1,20 @@
 #ifndef __PROCESS_SIGNAL_HANDLER_H__
 #define __PROCESS_SIGNAL_HANDLER_H__
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 
 #include "libsinsp/sinsp.h"
 
 #include <grpcpp/channel.h>
 
+#include "EnrichmentDegrader.h"
+#include "ExecCoalescer.h"
 #include "ProcessSignalFormatter.h"
 #include "RateLimit.h"
 #include "SignalHandler.h"
+#include "SignalPipeline.h"
 #include "SysdigService.h"
 
 namespace collector {
@@ -25,12 +30,52 @@ class ProcessSignalHandler : public SignalHandler {
   Result HandleExistingProcess(sinsp_threadinfo* tinfo) override;
   std::string GetName() override { return "ProcessSignalHandler"; }
   std::vector<std::string> GetRelevantEvents() override;
+  Result Flush() override;
+
+  // Rate limit and send signals from a dedicated worker, fed through a queue of the given capacity,
+  // instead of from the event thread.
+  void EnablePipeline(size_t queue_capacity);
+
+  // Coalesce the identical execs (same container, executable, arguments, uid and parent) which follow an exec
+  // within the window, into a summary sent once the window has ended.
+  void EnableExecCoalescing(std::chrono::nanoseconds window);
+
+  // Leave details out of the signals, as decided by the degrader, while events are handled late.
+  void SetEnrichmentDegrader(const EnrichmentDegrader* degrader) { degrader_ = degrader; }
+
+  // Whether the setuid family of events is captured. Cached lineages rely on them to see the uid changes of
+  // ancestors, so lineages are collected anew for every signal while they are not.
+  void SetUidChangesCaptured(bool captured) { formatter_.SetLineageCaching(captured); }
 
  private:
+  using SignalStreamMessage = ISignalServiceClient::SignalStreamMessage;
+
+  // How long the event thread waits for room in a full queue before dropping a signal.
+  static constexpr std::chrono::milliseconds kMaxBackpressure{10};
+
+  Result Dispatch(const SignalStreamMessage& signal_msg);
+  void SendExecSummaries(uint64_t ts);
+  void SendFromPipeline(SignalStreamMessage& signal_msg);
+  void UpdateEnrichmentTier();
+
   ISignalServiceClient* client_;
   ProcessSignalFormatter formatter_;
   SysdigStats* stats_;
   RateLimitCache rate_limiter_;
+  std::unique_ptr<ExecCoalescer> coalescer_;
+  // The timestamp of the last event, and when it was handled, to close the windows of the coalescer on time
+  // while no more events come.
+  uint64_t last_event_ts_ = 0;
+  std::chrono::steady_clock::time_point last_event_time_;
+  const EnrichmentDegrader* degrader_ = nullptr;
+  // Whether signals were sent without lineage nor arguments since the last full refresh.
+  bool minimal_signals_sent_ = false;
+
+  std::unique_ptr<SignalPipeline<SignalStreamMessage>> pipeline_;
+  // Set by the pipeline worker when the client asks for the existing processes to be sent again.
+  std::atomic<bool> needs_refresh_{false};
+  // Payloads the event thread failed to push, added to the send failures by the pipeline worker.
+  std::atomic<uint64_t> pipeline_drops_{0};
 };
 
 }  // namespace collector
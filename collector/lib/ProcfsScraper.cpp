@@ -102,9 +102,10 @@ class SocketInfo {
   uint64_t pid_;
 };
 
-// GetSocketINodes returns a list of all socket inodes associated with open file descriptors of the process represented
-// by dirfd.
-bool GetSocketINodes(int dirfd, uint64_t pid, UnorderedSet<SocketInfo>* sock_inodes) {
+// GetSocketINodes reads the socket inodes associated with open file descriptors of the process represented by dirfd
+// into fd_table. If prev_fd_table is provided and the fd table of the process still has the same fingerprint, its
+// socket inodes are reused without resolving any fd, and *from_cache is set to true.
+bool GetSocketINodes(int dirfd, ProcessFDTable* prev_fd_table, ProcessFDTable* fd_table, bool* from_cache) {
   DirHandle fd_dir = FDHandle(openat(dirfd, "fd", O_RDONLY));
   if (!fd_dir.valid()) {
     COUNTER_INC(CollectorStats::procfs_could_not_open_fd_dir);
@@ -112,13 +113,37 @@ bool GetSocketINodes(int dirfd, uint64_t pid, UnorderedSet<SocketInfo>* sock_ino
     return false;
   }
 
+  thread_local std::vector<int> fds;
+  fds.clear();
+
+  FDTableFingerprint fingerprint;
   while (auto curr = fd_dir.read()) {
     if (!std::isdigit(curr->d_name[0])) continue;  // only look at fd entries, ignore '.' and '..'.
 
+    int fd = std::atoi(curr->d_name);
+    fds.push_back(fd);
+    fingerprint.Add(fd);
+  }
+
+  if (prev_fd_table && prev_fd_table->fingerprint == fingerprint) {
+    *fd_table = std::move(*prev_fd_table);
+    *from_cache = true;
+    return true;
+  }
+
+  fd_table->fingerprint = fingerprint;
+  fd_table->socket_inodes.clear();
+  *from_cache = false;
+
+  char fd_name[16];
+  for (int fd : fds) {
+    std::snprintf(fd_name, sizeof(fd_name), "%d", fd);
+
     ino_t inode;
-    if (!ReadINode(fd_dir.fd(), curr->d_name, "socket", &inode)) continue;  // ignore non-socket fds
+    COUNTER_INC(CollectorStats::procfs_fd_readlink_calls);
+    if (!ReadINode(fd_dir.fd(), fd_name, "socket", &inode)) continue;  // ignore non-socket fds
 
-    sock_inodes->emplace(inode, pid);
+    fd_table->socket_inodes.push_back(inode);
   }
 
   return true;
@@ -363,6 +388,13 @@ using SocketsByContainer = UnorderedMap<std::string, UnorderedMap<ino_t, Unorder
 void ResolveSocketInodes(const SocketsByContainer& sockets_by_container, const ConnsByNS& conns_by_ns,
                          std::shared_ptr<ProcessStore> process_store,
                          std::vector<Connection>* connections, std::vector<ContainerEndpoint>* listen_endpoints) {
+  struct PendingEndpoint {
+    const std::string* container_id;
+    const EndpointInfo* ep;
+  };
+  std::vector<PendingEndpoint> pending_endpoints;
+  std::vector<uint64_t> pids;
+
   for (const auto& container_sockets : sockets_by_container) {
     const auto& container_id = container_sockets.first;
     for (const auto& netns_sockets : container_sockets.second) {
@@ -377,24 +409,93 @@ void ResolveSocketInodes(const SocketsByContainer& sockets_by_container, const C
           if (const auto* ep = Lookup(ns_network_data->listen_endpoints, socket.inode())) {
             if (!IsRelevantEndpoint(ep->endpoint)) continue;
 
-            std::shared_ptr<IProcess> process;
-
-            if (process_store) {
-              process = process_store->Fetch(socket.pid());
-            }
-
-            listen_endpoints->emplace_back(container_id, ep->endpoint, ep->l4proto, process);
+            pending_endpoints.push_back({&container_id, ep});
+            pids.push_back(socket.pid());
           }
         }
       }
     }
   }
+
+  if (pending_endpoints.empty()) return;
+
+  // Resolve the originators of all listen endpoints with a single request, rather than one round-trip to the
+  // event thread per endpoint.
+  std::vector<std::shared_ptr<IProcess>> processes;
+  if (process_store) {
+    processes = process_store->FetchBatch(pids);
+  }
+
+  for (size_t i = 0; i < pending_endpoints.size(); i++) {
+    const auto& pending = pending_endpoints[i];
+    listen_endpoints->emplace_back(*pending.container_id, pending.ep->endpoint, pending.ep->l4proto,
+                                   i < processes.size() ? processes[i] : nullptr);
+  }
+}
+
+// LoadNetworkData makes sure conns_by_ns holds the connections of the network namespace netns_inode, reading them
+// through the proc entry dirfd if needed. Returns false if they could not be read.
+bool LoadNetworkData(int dirfd, ino_t netns_inode, bool read_listen_endpoints, ConnsByNS* conns_by_ns) {
+  auto emplace_res = conns_by_ns->emplace(netns_inode, NSNetworkData());
+  if (!emplace_res.second) {
+    return true;
+  }
+
+  auto& ns_network_data = emplace_res.first->second;
+  if (!GetConnections(dirfd, &ns_network_data.connections, read_listen_endpoints ? &ns_network_data.listen_endpoints : nullptr)) {
+    // If there was an error reading connections, that could be due to a number of reasons.
+    // We need to differentiate persistent errors (e.g., expected net/tcp6 file not found)
+    // from spurious/race condition errors caused by the process disappearing while reading
+    // the directory. To determine if the latter is the root cause, we reattempt to read the
+    // network namespace inode; if that succeeds, we assume that the process is still alive
+    // and any errors encountered are persistent.
+    uint64_t netns_inode2;
+    if (!GetNetworkNamespace(dirfd, &netns_inode2) || netns_inode2 != netns_inode) {
+      conns_by_ns->erase(emplace_res.first);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// A process whose socket inodes were taken from the previous scrape.
+struct CachedProcess {
+  uint64_t pid;
+  std::string container_id;
+};
+
+// HasUnknownINodes checks whether the network namespace data references a socket which is not owned by any of the
+// container processes in sockets_by_container_and_ns.
+bool HasUnknownINodes(ino_t netns_inode, const NSNetworkData& ns_network_data, const SocketsByContainer& sockets_by_container_and_ns) {
+  UnorderedSet<ino_t> known_inodes;
+  for (const auto& container_sockets : sockets_by_container_and_ns) {
+    const auto* ns_sockets = Lookup(container_sockets.second, netns_inode);
+    if (!ns_sockets) continue;
+    for (const auto& socket : *ns_sockets) {
+      known_inodes.insert(socket.inode());
+    }
+  }
+
+  for (const auto& conn : ns_network_data.connections) {
+    if (!Contains(known_inodes, conn.first)) return true;
+  }
+  for (const auto& ep : ns_network_data.listen_endpoints) {
+    if (!Contains(known_inodes, ep.first)) return true;
+  }
+
+  return false;
 }
 
 // ReadContainerConnections reads all container connection info from the given `/proc`-like directory. All connections
 // from non-container processes are ignored.
 // process_store, when provided, is used to to link the originator process of a ContainerEndpoint.
-bool ReadContainerConnections(const char* proc_path, std::shared_ptr<ProcessStore> process_store,
+// fd_tables holds the socket inodes of each process from the previous invocation, and is updated in place.
+// Processes whose fd table fingerprint did not change reuse them instead of resolving each of their fds. As the
+// fingerprint can miss a socket replacing another fd, the cached inodes are only trusted if every socket listed in
+// the connection tables of their network namespace is accounted for; otherwise all fds of these processes are
+// resolved.
+bool ReadContainerConnections(const char* proc_path, std::shared_ptr<ProcessStore> process_store, FDTableCache* fd_tables,
                               std::vector<Connection>* connections, std::vector<ContainerEndpoint>* listen_endpoints) {
   DirHandle procdir = opendir(proc_path);
   if (!procdir.valid()) {
@@ -405,6 +506,9 @@ bool ReadContainerConnections(const char* proc_path, std::shared_ptr<ProcessStor
 
   ConnsByNS conns_by_ns;
   SocketsByContainer sockets_by_container_and_ns;
+  FDTableCache new_fd_tables;
+  // netns -> processes whose socket inodes were taken from the previous scrape
+  UnorderedMap<ino_t, std::vector<CachedProcess>> cached_processes_by_ns;
 
   // Read all the information from proc.
   while (auto curr = procdir.read()) {
@@ -431,39 +535,72 @@ bool ReadContainerConnections(const char* proc_path, std::shared_ptr<ProcessStor
       continue;
     }
 
-    auto& container_ns_sockets = sockets_by_container_and_ns[*container_id][netns_inode];
-    bool no_sockets = container_ns_sockets.empty();
-
-    if (!GetSocketINodes(dirfd, pid, &container_ns_sockets)) {
+    ProcessFDTable& fd_table = new_fd_tables[pid];
+    bool from_cache;
+    if (!GetSocketINodes(dirfd, Lookup(*fd_tables, pid), &fd_table, &from_cache)) {
+      new_fd_tables.erase(pid);
       COUNTER_INC(CollectorStats::procfs_could_not_get_socket_inodes);
       CLOG_THROTTLED(ERROR, std::chrono::seconds(10)) << "Could not obtain socket inodes: " << StrError();
       continue;
     }
 
-    if (no_sockets && !container_ns_sockets.empty()) {
-      // These are the first sockets for this (container, netns) pair. Make sure we actually have the information about
-      // connections in this network namespace.
-      auto emplace_res = conns_by_ns.emplace(netns_inode, NSNetworkData());
-      if (emplace_res.second) {
-        auto& ns_network_data = emplace_res.first->second;
-
-        if (!GetConnections(dirfd, &ns_network_data.connections, listen_endpoints ? &ns_network_data.listen_endpoints : nullptr)) {
-          // If there was an error reading connections, that could be due to a number of reasons.
-          // We need to differentiate persistent errors (e.g., expected net/tcp6 file not found)
-          // from spurious/race condition errors caused by the process disappearing while reading
-          // the directory. To determine if the latter is the root cause, we reattempt to read the
-          // network namespace inode; if that succeeds, we assume that the process is still alive
-          // and any errors encountered are persistent.
-          uint64_t netns_inode2;
-          if (!GetNetworkNamespace(dirfd, &netns_inode2) || netns_inode2 != netns_inode) {
-            conns_by_ns.erase(emplace_res.first);
-            continue;
-          }
+    auto& container_ns_sockets = sockets_by_container_and_ns[*container_id][netns_inode];
+    for (ino_t inode : fd_table.socket_inodes) {
+      container_ns_sockets.emplace(inode, pid);
+    }
+
+    if (from_cache) {
+      COUNTER_INC(CollectorStats::procfs_fd_walks_skipped);
+      cached_processes_by_ns[netns_inode].push_back({static_cast<uint64_t>(pid), *container_id});
+    } else {
+      COUNTER_INC(CollectorStats::procfs_fd_walks_full);
+    }
+
+    // Make sure we actually have the information about connections in this network namespace, if it contains sockets
+    // or if we need it to validate cached socket inodes.
+    if (!container_ns_sockets.empty() || from_cache) {
+      LoadNetworkData(dirfd, netns_inode, listen_endpoints != nullptr, &conns_by_ns);
+    }
+  }
+
+  // Validate the socket inodes taken from the previous scrape.
+  for (const auto& ns_processes : cached_processes_by_ns) {
+    ino_t netns_inode = ns_processes.first;
+    const auto* ns_network_data = Lookup(conns_by_ns, netns_inode);
+    if (!ns_network_data || !HasUnknownINodes(netns_inode, *ns_network_data, sockets_by_container_and_ns)) {
+      continue;
+    }
+
+    COUNTER_INC(CollectorStats::procfs_fd_cache_fallbacks);
+    for (const auto& process : ns_processes.second) {
+      // The inodes taken from the previous scrape may be stale, they are replaced by those found now.
+      auto& container_ns_sockets = sockets_by_container_and_ns[process.container_id][netns_inode];
+      ProcessFDTable& fd_table = new_fd_tables[process.pid];
+      for (ino_t inode : fd_table.socket_inodes) {
+        auto it = container_ns_sockets.find(SocketInfo(inode, process.pid));
+        if (it != container_ns_sockets.end() && it->pid() == process.pid) {
+          container_ns_sockets.erase(it);
         }
       }
+
+      std::string pid_str = std::to_string(process.pid);
+      FDHandle dirfd = procdir.openat(pid_str.c_str(), O_RDONLY);
+      bool from_cache;
+      if (!dirfd.valid() || !GetSocketINodes(dirfd, nullptr, &fd_table, &from_cache)) {
+        // The process may have exited in the meantime.
+        new_fd_tables.erase(process.pid);
+        continue;
+      }
+      COUNTER_INC(CollectorStats::procfs_fd_walks_full);
+
+      for (ino_t inode : fd_table.socket_inodes) {
+        container_ns_sockets.emplace(inode, process.pid);
+      }
     }
   }
 
+  *fd_tables = std::move(new_fd_tables);
+
   ResolveSocketInodes(sockets_by_container_and_ns, conns_by_ns, process_store, connections, listen_endpoints);
   return true;
 }
@@ -536,7 +673,7 @@ std::optional<std::string_view> ExtractContainerID(std::string_view cgroup_line)
 }
 
 bool ConnScraper::Scrape(std::vector<Connection>* connections, std::vector<ContainerEndpoint>* listen_endpoints) {
-  return ReadContainerConnections(proc_path_.c_str(), process_store_, connections, listen_endpoints);
+  return ReadContainerConnections(proc_path_.c_str(), process_store_, &fd_tables_, connections, listen_endpoints);
 }
 
 bool ProcessScraper::Scrape(uint64_t pid, ProcessInfo& process_info) {
@@ -552,8 +689,13 @@ bool ProcessScraper::Scrape(uint64_t pid, ProcessInfo& process_info) {
     return false;
   }
 
-  return GetContainerID(dirfd) &&
-         ReadProcessExe(process_path, dirfd, process_info.comm, process_info.exe_path) &&
+  auto container_id = GetContainerID(dirfd);
+  if (!container_id) {
+    return false;
+  }
+  process_info.container_id = std::move(*container_id);
+
+  return ReadProcessExe(process_path, dirfd, process_info.comm, process_info.exe_path) &&
          ReadProcessCmdline(process_path, dirfd, process_info.exe, process_info.args);
 }
 
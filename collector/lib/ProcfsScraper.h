@@ -1,10 +1,14 @@
 #ifndef COLLECTOR_PROCFSSCRAPER_H
 #define COLLECTOR_PROCFSSCRAPER_H
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <vector>
 
+#include <sys/types.h>
+
+#include "Hash.h"
 #include "NetworkConnection.h"
 
 namespace collector {
@@ -16,6 +20,32 @@ class IConnScraper {
   virtual ~IConnScraper() {}
 };
 
+// FDTableFingerprint summarizes the fd table of a process: the number of open file descriptors and the highest fd
+// number. Both are obtained from the listing of `/proc/<pid>/fd`, without resolving any of its entries.
+struct FDTableFingerprint {
+  size_t num_fds = 0;
+  int max_fd = -1;
+
+  void Add(int fd) {
+    num_fds++;
+    max_fd = std::max(max_fd, fd);
+  }
+
+  bool operator==(const FDTableFingerprint& other) const {
+    return num_fds == other.num_fds && max_fd == other.max_fd;
+  }
+};
+
+// ProcessFDTable holds the socket inodes found among the open file descriptors of a process, together with the
+// fingerprint of its fd table at the time they were read.
+struct ProcessFDTable {
+  FDTableFingerprint fingerprint;
+  std::vector<ino_t> socket_inodes;
+};
+
+// pid -> fd table mapping
+using FDTableCache = UnorderedMap<uint64_t, ProcessFDTable>;
+
 // ConnScraper is a class that allows scraping a `/proc`-like directory structure for active network connections.
 class ConnScraper : public IConnScraper {
  public:
@@ -29,6 +59,9 @@ class ConnScraper : public IConnScraper {
  private:
   std::string proc_path_;
   std::shared_ptr<ProcessStore> process_store_;
+  // Socket inodes of every container process seen in the previous scrape. Used to avoid resolving each fd of
+  // processes whose fd table did not change.
+  FDTableCache fd_tables_;
 };
 
 class ProcessScraper {
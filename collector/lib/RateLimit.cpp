@@ -1,5 +1,7 @@
 #include "RateLimit.h"
 
+#include <algorithm>
+
 #include "CollectorStats.h"
 #include "Logging.h"
 #include "TimeUtil.h"
@@ -46,26 +48,89 @@ void Limiter::fill_bucket(TokenBucket* b) {
   b->tokens = burst_size_;
 }
 
+namespace {
+
+size_t SlotCount(size_t capacity) {
+  size_t slots = 2;
+  while (slots < 2 * capacity) {
+    slots <<= 1;
+  }
+  return slots;
+}
+
+}  // namespace
+
 // RateLimitCache Defaults: Limit duplicate events to rate of 10 every 30 min
 RateLimitCache::RateLimitCache()
-    : capacity_(4096), limiter_(new Limiter(10, 30 * 60)) {}
+    : RateLimitCache(4096, 10, 30 * 60) {}
 
 RateLimitCache::RateLimitCache(size_t capacity, int64_t burst_size, int64_t refill_time)
-    : capacity_(capacity), limiter_(new Limiter(burst_size, refill_time)) {}
+    : capacity_(std::max<size_t>(capacity, 1)),
+      limiter_(new Limiter(burst_size, refill_time)),
+      slots_(SlotCount(capacity_)),
+      mask_(slots_.size() - 1) {}
 
 void RateLimitCache::ResetRateLimitCache() {
   limiter_.reset();
 }
 
-bool RateLimitCache::Allow(std::string key) {
-  auto pair = cache_.emplace(std::make_pair(key, TokenBucket()));
-  if (pair.second && cache_.size() > capacity_) {
-    CLOG(INFO) << "Flushing rate limiting cache";
-    cache_.clear();
-    COUNTER_INC(CollectorStats::rate_limit_flushing_counts);
-    return true;
+size_t RateLimitCache::Find(const Hash128& key) const {
+  size_t slot = key.low & mask_;
+  while (slots_[slot].used && slots_[slot].key != key) {
+    slot = (slot + 1) & mask_;
+  }
+  return slot;
+}
+
+bool RateLimitCache::Allow(const Hash128& key) {
+  size_t slot = Find(key);
+  if (!slots_[slot].used) {
+    if (size_ >= capacity_) {
+      EvictOne();
+      // The eviction may have moved entries of the probe sequence.
+      slot = Find(key);
+    }
+    slots_[slot] = Entry{key, TokenBucket(), true, false};
+    size_++;
+  }
+
+  Entry& entry = slots_[slot];
+  entry.referenced = true;
+  return limiter_->Allow(&entry.bucket);
+}
+
+void RateLimitCache::EvictOne() {
+  for (;;) {
+    size_t slot = hand_;
+    hand_ = (hand_ + 1) & mask_;
+
+    Entry& entry = slots_[slot];
+    if (!entry.used) {
+      continue;
+    }
+    if (entry.referenced) {
+      entry.referenced = false;
+      continue;
+    }
+
+    Erase(slot);
+    COUNTER_INC(CollectorStats::rate_limit_evictions);
+    return;
+  }
+}
+
+void RateLimitCache::Erase(size_t slot) {
+  // Shift back the following entries of the cluster which would not be found anymore past the hole.
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask_; slots_[next].used; next = (next + 1) & mask_) {
+    size_t home = slots_[next].key.low & mask_;
+    if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+      slots_[hole] = slots_[next];
+      hole = next;
+    }
   }
-  return limiter_->Allow(&pair.first->second);
+  slots_[hole] = Entry();
+  size_--;
 }
 
 }  // namespace collector
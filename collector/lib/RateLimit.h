@@ -1,8 +1,11 @@
 #ifndef _RATE_LIMIT_H_
 #define _RATE_LIMIT_H_
 
-#include <unordered_map>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "Hash.h"
 #include "Utility.h"
 
 namespace collector {
@@ -28,17 +31,44 @@ class Limiter {
   int64_t refill_time_;  // amount of time between refill in microseconds
 };
 
+// RateLimitCache keeps a token bucket per key, in a fixed-size open-addressing table of 128-bit key hashes.
+//
+// When the table holds `capacity` keys, a new key evicts an existing one, chosen with the CLOCK algorithm: a
+// hand sweeps the table, sparing (once) the keys used since its last pass. The limits of the other keys are
+// kept, so an exec storm of distinct keys does not reset the rate limiting of the frequent ones.
 class RateLimitCache {
  public:
   RateLimitCache();
   RateLimitCache(size_t capacity, int64_t burst_size, int64_t refill_time);
   void ResetRateLimitCache();
-  bool Allow(std::string key);
+  bool Allow(const Hash128& key);
+  bool Allow(const std::string& key) { return Allow(StreamingHash128().Add(key).Finish()); }
+
+  bool Contains(const Hash128& key) const { return slots_[Find(key)].used; }
+  bool Contains(const std::string& key) const { return Contains(StreamingHash128().Add(key).Finish()); }
+  size_t Size() const { return size_; }
 
  private:
+  struct Entry {
+    Hash128 key;
+    TokenBucket bucket;
+    bool used = false;
+    bool referenced = false;
+  };
+
+  // The slot holding the key, or the empty slot where it would be inserted.
+  size_t Find(const Hash128& key) const;
+  void EvictOne();
+  void Erase(size_t slot);
+
   size_t capacity_;
   std::unique_ptr<Limiter> limiter_;
-  std::unordered_map<std::string, TokenBucket> cache_;
+  // Twice as many slots as keys, to keep probe sequences short.
+  std::vector<Entry> slots_;
+  size_t mask_;
+  size_t size_ = 0;
+  // The position of the CLOCK hand.
+  size_t hand_ = 0;
 };
 }  // namespace collector
 
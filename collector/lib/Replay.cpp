@@ -0,0 +1,62 @@
+#include "Replay.h"
+
+#include <thread>
+
+namespace collector {
+
+constexpr std::chrono::milliseconds ReplayPacer::kMinSleep;
+
+std::chrono::nanoseconds ReplayPacer::Delay(uint64_t event_ts_ns, Clock::time_point now) {
+  if (!started_) {
+    started_ = true;
+    first_event_ts_ = event_ts_ns;
+    start_ = now;
+    return std::chrono::nanoseconds(0);
+  }
+
+  // Events of a capture are ordered, but not strictly across CPUs.
+  if (event_ts_ns <= first_event_ts_) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  auto due = start_ + std::chrono::nanoseconds(event_ts_ns - first_event_ts_);
+  if (due <= now) {
+    return std::chrono::nanoseconds(0);
+  }
+  return due - now;
+}
+
+void ReplayPacer::Wait(uint64_t event_ts_ns) {
+  auto delay = Delay(event_ts_ns, Clock::now());
+  if (delay >= kMinSleep) {
+    std::this_thread::sleep_for(delay);
+  }
+}
+
+namespace {
+
+double PerSecond(uint64_t count, std::chrono::nanoseconds duration) {
+  auto seconds = std::chrono::duration<double>(duration).count();
+  return seconds > 0 ? count / seconds : 0;
+}
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const ReplayReport& report) {
+  os << "Replayed " << report.events << " events (" << report.filtered_events << " dispatched) in "
+     << std::chrono::duration<double>(report.duration).count() << "s: "
+     << PerSecond(report.events, report.duration) << " events/s";
+
+  for (const auto& handler : report.handlers) {
+    os << "\n  " << handler.name << ": ~" << handler.calls << " calls, ~" << handler.cpu_micros / 1000 << "ms CPU";
+    if (handler.calls > 0) {
+      os << " (" << handler.cpu_micros * 1000 / handler.calls << "ns/call)";
+    }
+  }
+
+  os << "\n  process signals: " << report.process_signals << " (" << PerSecond(report.process_signals, report.duration) << "/s)"
+     << "\n  network updates: " << report.network_updates << " (" << PerSecond(report.network_updates, report.duration) << "/s)";
+  return os;
+}
+
+}  // namespace collector
@@ -0,0 +1,52 @@
+#ifndef COLLECTOR_REPLAY_H
+#define COLLECTOR_REPLAY_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "EventStats.h"
+
+namespace collector {
+
+// ReplayPacer delivers the events of a recorded capture at the pace they were recorded at: the first
+// event is due immediately, every later one once as much time has elapsed since the first one as
+// separates their timestamps.
+class ReplayPacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Shorter delays are not worth sleeping for. Since events are due relative to the first one, the
+  // time is caught up with by the next sleep.
+  static constexpr std::chrono::milliseconds kMinSleep{1};
+
+  // Returns how long to wait, from now, before delivering an event recorded at event_ts_ns.
+  std::chrono::nanoseconds Delay(uint64_t event_ts_ns, Clock::time_point now);
+
+  // Blocks until the event recorded at event_ts_ns is due.
+  void Wait(uint64_t event_ts_ns);
+
+ private:
+  bool started_ = false;
+  uint64_t first_event_ts_ = 0;
+  Clock::time_point start_;
+};
+
+// The outcome of replaying a capture through the signal handlers.
+struct ReplayReport {
+  std::chrono::nanoseconds duration{0};
+  // Events read from the capture, and those of them which were dispatched to signal handlers.
+  uint64_t events = 0;
+  uint64_t filtered_events = 0;
+  std::vector<HandlerStats> handlers;
+  // Process signals, and connection and endpoint deltas, produced for Sensor.
+  uint64_t process_signals = 0;
+  uint64_t network_updates = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const ReplayReport& report);
+
+}  // namespace collector
+
+#endif  // COLLECTOR_REPLAY_H
@@ -0,0 +1,66 @@
+#include "ReplayBuffer.h"
+
+#include "CollectorStats.h"
+
+namespace collector {
+
+void ReplayBuffer::Push(SignalStreamMessage&& msg) {
+  size_t bytes = msg.ByteSizeLong();
+  if (bytes > max_bytes_) {
+    COUNTER_INC(CollectorStats::process_replay_dropped);
+    dropped_.store(true);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (bytes_ + bytes > max_bytes_) {
+    bytes_ -= entries_.front().bytes;
+    entries_.pop_front();
+    COUNTER_INC(CollectorStats::process_replay_dropped);
+    dropped_.store(true);
+  }
+
+  entries_.push_back({std::move(msg), bytes});
+  bytes_ += bytes;
+  size_.store(entries_.size(), std::memory_order_release);
+  COUNTER_SET(CollectorStats::process_replay_buffered, entries_.size());
+}
+
+void ReplayBuffer::PushFront(std::vector<SignalStreamMessage>&& msgs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = msgs.rbegin(); it != msgs.rend(); ++it) {
+    size_t bytes = it->ByteSizeLong();
+    if (bytes_ + bytes > max_bytes_) {
+      COUNTER_ADD(CollectorStats::process_replay_dropped, msgs.rend() - it);
+      dropped_.store(true);
+      break;
+    }
+
+    entries_.push_front({std::move(*it), bytes});
+    bytes_ += bytes;
+  }
+  msgs.clear();
+  size_.store(entries_.size(), std::memory_order_release);
+  COUNTER_SET(CollectorStats::process_replay_buffered, entries_.size());
+}
+
+bool ReplayBuffer::Pop(SignalStreamMessage* msg) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.empty()) {
+    return false;
+  }
+
+  *msg = std::move(entries_.front().msg);
+  bytes_ -= entries_.front().bytes;
+  entries_.pop_front();
+  size_.store(entries_.size(), std::memory_order_release);
+  COUNTER_SET(CollectorStats::process_replay_buffered, entries_.size());
+  return true;
+}
+
+size_t ReplayBuffer::Bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+}  // namespace collector
@@ -0,0 +1,65 @@
+#ifndef COLLECTOR_REPLAYBUFFER_H
+#define COLLECTOR_REPLAYBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "internalapi/sensor/signal_iservice.pb.h"
+
+namespace collector {
+
+// ReplayBuffer holds the signals produced while the stream to Sensor is down, to be sent in order once it is
+// established again.
+//
+// The buffer is bounded by the serialized size of the signals it holds: the oldest signals are dropped to
+// make room for new ones. Dropped signals are remembered until TakeDropped(), which tells the client whether
+// the buffer covered the whole outage.
+//
+// Thread-safe.
+class ReplayBuffer {
+ public:
+  using SignalStreamMessage = sensor::SignalStreamMessage;
+
+  explicit ReplayBuffer(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  // Appends the signal, dropping the oldest ones if needed. A signal larger than the whole budget is dropped.
+  void Push(SignalStreamMessage&& msg);
+
+  // Puts back signals older than those buffered, such as signals whose delivery is unknown when the stream
+  // failed, in order. The oldest of them are dropped if they do not fit.
+  void PushFront(std::vector<SignalStreamMessage>&& msgs);
+
+  // Takes the oldest signal. Returns false if the buffer is empty.
+  bool Pop(SignalStreamMessage* msg);
+
+  // Returns whether signals were dropped since the last call.
+  bool TakeDropped() { return dropped_.exchange(false); }
+
+  bool Empty() const { return size_.load(std::memory_order_acquire) == 0; }
+  size_t Size() const { return size_.load(std::memory_order_acquire); }
+  size_t Bytes() const;
+  size_t MaxBytes() const { return max_bytes_; }
+
+ private:
+  struct Entry {
+    SignalStreamMessage msg;
+    size_t bytes;
+  };
+
+  const size_t max_bytes_;
+
+  mutable std::mutex mutex_;
+  std::deque<Entry> entries_;
+  size_t bytes_ = 0;
+
+  // Mirrors the number of entries, so that checking for emptiness does not take the lock.
+  std::atomic<size_t> size_{0};
+  std::atomic<bool> dropped_{false};
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_REPLAYBUFFER_H
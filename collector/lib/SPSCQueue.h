@@ -0,0 +1,86 @@
+#ifndef COLLECTOR_SPSCQUEUE_H
+#define COLLECTOR_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace collector {
+
+// SPSCQueue is a bounded, lock-free queue for exactly one producer thread and one consumer thread.
+//
+// The producer owns the tail index and the consumer the head index. Each side keeps a cached copy of the
+// other side's index, and only reloads it when the queue looks full (resp. empty), so that in the common
+// case pushing and popping do not touch the cache line written by the other thread.
+template <typename T>
+class SPSCQueue {
+ public:
+  // The capacity is rounded up to the next power of two.
+  explicit SPSCQueue(size_t capacity) : slots_(RoundUpToPowerOfTwo(capacity)), mask_(slots_.size() - 1) {}
+
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  // Producer side. Returns false, leaving item untouched, if the queue is full.
+  bool TryPush(T&& item) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ >= slots_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ >= slots_.size()) {
+        return false;
+      }
+    }
+
+    slots_[tail & mask_] = std::move(item);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the queue is empty.
+  bool TryPop(T* item) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+
+    *item = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // The number of queued items. Only a snapshot when called concurrently with the producer or consumer.
+  size_t Size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  size_t Capacity() const { return slots_.size(); }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  std::vector<T> slots_;
+  const size_t mask_;
+
+  // Written by the producer.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+
+  // Written by the consumer.
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_SPSCQUEUE_H
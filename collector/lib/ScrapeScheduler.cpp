@@ -0,0 +1,68 @@
+#include "ScrapeScheduler.h"
+
+#include <algorithm>
+
+#include "CollectorStats.h"
+#include "Logging.h"
+
+namespace collector {
+
+constexpr double ScrapeScheduler::kHighChurnRatio;
+constexpr double ScrapeScheduler::kLowChurnRatio;
+constexpr double ScrapeScheduler::kHighCostRatio;
+constexpr double ScrapeScheduler::kLowCostRatio;
+
+ScrapeScheduler::ScrapeScheduler(std::chrono::milliseconds interval,
+                                 std::chrono::milliseconds min_interval,
+                                 std::chrono::milliseconds max_interval,
+                                 bool adaptive)
+    : interval_(interval), min_interval_(min_interval), max_interval_(max_interval), adaptive_(adaptive) {
+  if (adaptive_) {
+    max_interval_ = std::max(min_interval_, max_interval_);
+    interval_ = std::clamp(interval_, min_interval_, max_interval_);
+  }
+  COUNTER_SET(CollectorStats::net_scrape_interval_ms, interval_.count());
+}
+
+std::chrono::milliseconds ScrapeScheduler::OnScrape(std::chrono::microseconds scrape_duration, size_t scraped, size_t missed) {
+  COUNTER_ADD(CollectorStats::net_scrape_missed_conns, missed);
+
+  if (!adaptive_) {
+    return interval_;
+  }
+
+  if (!primed_) {
+    primed_ = true;
+    return interval_;
+  }
+
+  double churn = scraped > 0 ? static_cast<double>(missed) / scraped : 0.0;
+  double cost = static_cast<double>(scrape_duration.count()) / std::chrono::duration_cast<std::chrono::microseconds>(interval_).count();
+
+  auto previous = interval_;
+  if (churn >= kHighChurnRatio) {
+    interval_ = std::max(min_interval_, interval_ / 2);
+  } else if (churn <= kLowChurnRatio && cost >= kHighCostRatio) {
+    interval_ = std::min(max_interval_, interval_ * 3 / 2);
+  } else if (cost <= kLowCostRatio) {
+    interval_ = std::max(min_interval_, interval_ * 2 / 3);
+  }
+
+  if (interval_ < previous) {
+    COUNTER_INC(CollectorStats::net_scrape_interval_decreased);
+  } else if (interval_ > previous) {
+    COUNTER_INC(CollectorStats::net_scrape_interval_increased);
+  } else {
+    COUNTER_INC(CollectorStats::net_scrape_interval_unchanged);
+  }
+  COUNTER_SET(CollectorStats::net_scrape_interval_ms, interval_.count());
+
+  if (interval_ != previous) {
+    CLOG(DEBUG) << "Scrape interval changed from " << previous.count() << "ms to " << interval_.count()
+                << "ms (churn=" << churn << ", cost=" << cost << ")";
+  }
+
+  return interval_;
+}
+
+}  // namespace collector
@@ -0,0 +1,55 @@
+#ifndef COLLECTOR_SCRAPESCHEDULER_H
+#define COLLECTOR_SCRAPESCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace collector {
+
+// ScrapeScheduler decides how long to wait between two procfs connection scrapes.
+//
+// With adaptive scheduling disabled the interval is fixed. Otherwise, after every scrape the interval is
+// adjusted within [min, max] based on two signals:
+//  - churn: the fraction of scraped connections which were not already known (as active) from the event
+//    stream. A high value means the event path is missing changes, so we scrape more often.
+//  - cost: the fraction of the current interval spent reading procfs. When scrapes are expensive and the
+//    event stream covers nearly all changes, we scrape less often. When they are cheap, as on an idle node
+//    or once a busy period is over, we scrape more often again, for fresher data.
+// Every decision is reported through the net_scrape_interval_* counters.
+class ScrapeScheduler {
+ public:
+  // Fraction of scraped connections missed by the event stream above which the interval is shortened.
+  static constexpr double kHighChurnRatio = 0.05;
+  // Fraction of scraped connections missed by the event stream below which the interval may be stretched.
+  static constexpr double kLowChurnRatio = 0.01;
+  // Fraction of the interval spent scraping above which a scrape is considered expensive.
+  static constexpr double kHighCostRatio = 0.01;
+  // Fraction of the interval spent scraping below which a scrape is considered cheap.
+  static constexpr double kLowCostRatio = 0.001;
+
+  ScrapeScheduler(std::chrono::milliseconds interval,
+                  std::chrono::milliseconds min_interval,
+                  std::chrono::milliseconds max_interval,
+                  bool adaptive);
+
+  std::chrono::milliseconds Interval() const { return interval_; }
+
+  // Records the outcome of a scrape, and returns the interval to wait until the next one.
+  // scraped is the number of connections the scrape found, missed the number of those which were not
+  // already known to be active.
+  std::chrono::milliseconds OnScrape(std::chrono::microseconds scrape_duration, size_t scraped, size_t missed);
+
+ private:
+  std::chrono::milliseconds interval_;
+  std::chrono::milliseconds min_interval_;
+  std::chrono::milliseconds max_interval_;
+  bool adaptive_;
+
+  // The first scrape finds every connection established before collector started, so it is not
+  // representative of the event stream coverage.
+  bool primed_ = false;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_SCRAPESCHEDULER_H
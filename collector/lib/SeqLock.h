@@ -0,0 +1,74 @@
+#ifndef COLLECTOR_SEQLOCK_H
+#define COLLECTOR_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace collector {
+
+// SeqLock publishes a value written by a single thread to any number of reader threads, without
+// either side ever blocking. Readers retry when the value was modified while they were copying it,
+// so a reader always observes a value as it was passed to one Store call.
+//
+// The value is kept as an array of atomic words, so it must be trivially copyable.
+template <typename T>
+class SeqLock {
+ public:
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock values must be trivially copyable");
+
+  SeqLock() : SeqLock(T{}) {}
+
+  explicit SeqLock(const T& value) {
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &value, sizeof(T));
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  // Must only be called from a single thread.
+  void Store(const T& value) {
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &value, sizeof(T));
+
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  T Load() const {
+    uint64_t words[kWords];
+    uint64_t before, after;
+    do {
+      before = seq_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < kWords; i++) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = seq_.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+
+    T value;
+    std::memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  // Number of Store calls so far.
+  uint64_t Version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> seq_{0};
+  std::atomic<uint64_t> words_[kWords];
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_SEQLOCK_H
@@ -1,6 +1,7 @@
 #ifndef COLLECTOR_SIGNALHANDLER_H
 #define COLLECTOR_SIGNALHANDLER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -23,14 +24,26 @@ class SignalHandler {
     FINISHED,
   };
 
+  // A handler-specific classification of an event type (e.g., whether a network event adds or removes a
+  // connection). It is computed once per event type when the handler is registered, and passed along with
+  // every event of that type.
+  using EventTag = uint8_t;
+
   virtual std::string GetName() = 0;
   virtual bool Start() { return true; }
   virtual bool Stop() { return true; }
   virtual Result HandleSignal(sinsp_evt* evt) = 0;
+  virtual EventTag GetEventTag(uint16_t event_type) { return 0; }
+  virtual Result HandleTaggedSignal(sinsp_evt* evt, EventTag tag) {
+    return HandleSignal(evt);
+  }
   virtual Result HandleExistingProcess(sinsp_threadinfo* tinfo) {
     return IGNORED;
   }
   virtual std::vector<std::string> GetRelevantEvents() = 0;
+  // Called from the event thread about every second, whether events come or not, to send what the handler
+  // holds back. Returns NEEDS_REFRESH to have the existing processes sent without waiting for an event.
+  virtual Result Flush() { return PROCESSED; }
 };
 
 }  // namespace collector
@@ -0,0 +1,130 @@
+#ifndef COLLECTOR_SIGNALPIPELINE_H
+#define COLLECTOR_SIGNALPIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "CollectorStats.h"
+#include "SPSCQueue.h"
+#include "StoppableThread.h"
+
+namespace collector {
+
+// SignalPipeline moves the part of signal handling which does not need libsinsp state off the event thread.
+//
+// The event thread extracts a self-contained payload from each event and pushes it into a bounded lock-free
+// queue. A dedicated worker consumes the payloads in order, so ordering between the events of a handler is
+// preserved. When the worker falls behind and the queue is full, the event thread waits up to
+// max_backpressure for room before dropping the payload. An idle worker blocks until a payload is pushed.
+//
+// The depth of the queue, the number of times it was found full, and the number of dropped payloads are
+// published in the given counters.
+template <typename T>
+class SignalPipeline {
+ public:
+  struct Counters {
+    CollectorStats::CounterType queue_depth;
+    CollectorStats::CounterType queue_full;
+    CollectorStats::CounterType dropped;
+  };
+
+  using Consumer = std::function<void(T& payload)>;
+
+  SignalPipeline(size_t capacity, std::chrono::microseconds max_backpressure, Counters counters)
+      : queue_(capacity), max_backpressure_(max_backpressure), counters_(counters) {}
+
+  ~SignalPipeline() { Stop(); }
+
+  bool Start(Consumer consumer) {
+    consumer_ = std::move(consumer);
+    stopping_ = false;
+    return thread_.Start(&SignalPipeline::Run, this);
+  }
+
+  // Payloads still queued when stopping are discarded.
+  void Stop() {
+    if (thread_.running()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+      }
+      cond_.notify_one();
+      thread_.Stop();
+    }
+  }
+
+  // Must only be called from the event thread. Returns false if the payload was dropped.
+  bool Push(T&& payload) {
+    if (!queue_.TryPush(std::move(payload))) {
+      COUNTER_INC(counters_.queue_full);
+
+      auto deadline = std::chrono::steady_clock::now() + max_backpressure_;
+      while (!queue_.TryPush(std::move(payload))) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+          COUNTER_INC(counters_.dropped);
+          return false;
+        }
+        std::this_thread::yield();
+      }
+    }
+
+    // Pairs with the fence in WaitForPayload: either the worker sees the payload before sleeping, or it is
+    // seen sleeping here and woken up.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond_.notify_one();
+    }
+
+    COUNTER_SET(counters_.queue_depth, queue_.Size());
+    return true;
+  }
+
+  size_t Size() const { return queue_.Size(); }
+
+  bool Running() const { return thread_.running(); }
+
+ private:
+  // Returns false when stopping.
+  bool WaitForPayload() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cond_.wait(lock, [this] { return stopping_ || queue_.Size() > 0; });
+    sleeping_.store(false, std::memory_order_relaxed);
+    return !stopping_;
+  }
+
+  void Run() {
+    T payload;
+    while (!thread_.should_stop()) {
+      if (!queue_.TryPop(&payload)) {
+        COUNTER_SET(counters_.queue_depth, 0);
+        if (!WaitForPayload()) break;
+        continue;
+      }
+
+      consumer_(payload);
+    }
+  }
+
+  SPSCQueue<T> queue_;
+  std::chrono::microseconds max_backpressure_;
+  Counters counters_;
+  Consumer consumer_;
+  StoppableThread thread_;
+
+  // Guard the sleep of an idle worker, the queue itself is lock-free.
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> sleeping_{false};
+  bool stopping_ = false;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_SIGNALPIPELINE_H
@@ -0,0 +1,92 @@
+#include "SignalScheduler.h"
+
+#include <algorithm>
+
+#include "CollectorStats.h"
+
+namespace collector {
+
+constexpr std::chrono::milliseconds SignalScheduler::kWindow;
+
+SignalScheduler::SignalScheduler(const std::array<StreamConfig, NUM_STREAMS>& configs)
+    : next_refill_(Clock::now() + kWindow) {
+  for (size_t i = 0; i < NUM_STREAMS; i++) {
+    State& state = streams_[i];
+    state.config = configs[i];
+    // Rounded up, so that a rate too low for a byte per window still limits the stream.
+    state.budget_per_window = (configs[i].bytes_per_second * kWindow.count() + 999) / 1000;
+    state.tokens = state.budget_per_window;
+  }
+}
+
+void SignalScheduler::SetBusy(Stream stream, bool busy) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (streams_[stream].busy == busy) return;
+  streams_[stream].busy = busy;
+  if (!busy) {
+    cond_.notify_all();
+  }
+}
+
+bool SignalScheduler::HeldByPriority(Stream stream) const {
+  int priority = streams_[stream].config.priority;
+  return std::any_of(streams_.begin(), streams_.end(), [priority](const State& other) {
+    return other.busy && other.config.priority > priority;
+  });
+}
+
+void SignalScheduler::Refill(Clock::time_point now) {
+  if (now < next_refill_) return;
+
+  // Budgets do not accumulate over idle windows, but debts are paid off.
+  int64_t windows = (now - next_refill_) / kWindow + 1;
+  for (State& state : streams_) {
+    state.tokens = std::min(state.tokens + windows * state.budget_per_window, state.budget_per_window);
+  }
+  next_refill_ += windows * kWindow;
+  cond_.notify_all();
+}
+
+bool SignalScheduler::Acquire(Stream stream, size_t bytes, const std::function<bool()>& interrupted) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  State& state = streams_[stream];
+
+  auto start = Clock::now();
+  auto max_hold = start + kWindow;
+  bool held = false;
+  bool throttled = false;
+  for (auto now = start;; now = Clock::now()) {
+    Refill(now);
+
+    auto wake_up = next_refill_;
+    if (now < max_hold && HeldByPriority(stream)) {
+      held = true;
+      wake_up = std::min(wake_up, max_hold);
+    } else if (state.budget_per_window > 0 && state.tokens <= 0) {
+      throttled = true;
+    } else {
+      break;
+    }
+
+    if (interrupted()) return false;
+    cond_.wait_until(lock, wake_up);
+  }
+
+  if (state.budget_per_window > 0) {
+    state.tokens -= bytes;
+  }
+
+  if (held) {
+    COUNTER_INC(CollectorStats::scheduler_priority_holds);
+  }
+  if (throttled) {
+    COUNTER_INC(CollectorStats::scheduler_budget_holds);
+  }
+  if (held || throttled) {
+    COUNTER_ADD(CollectorStats::scheduler_hold_micros,
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+  }
+  return true;
+}
+
+}  // namespace collector
@@ -0,0 +1,72 @@
+#ifndef COLLECTOR_SIGNALSCHEDULER_H
+#define COLLECTOR_SIGNALSCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace collector {
+
+// SignalScheduler arbitrates the writes of the process signal and network streams, which share the
+// connection to Sensor, so that a large network delta does not hold back the process signals security
+// policies depend on.
+//
+// Each stream has a priority and a budget of bytes per second. Before writing, a stream acquires the size of
+// its message. It is held back while a stream of higher priority is busy, that is has messages waiting to be
+// written, for at most one window so that it is never starved. It is also held back while it has exceeded
+// its budget: the budget is granted every window, and a message larger than what is left is let through,
+// leaving a debt paid by the following windows.
+//
+// Thread-safe.
+class SignalScheduler {
+ public:
+  enum Stream {
+    PROCESS = 0,
+    NETWORK,
+    NUM_STREAMS,
+  };
+
+  struct StreamConfig {
+    // Streams with a higher priority are served first.
+    int priority = 0;
+    // 0 means unlimited.
+    uint64_t bytes_per_second = 0;
+  };
+
+  static constexpr std::chrono::milliseconds kWindow{100};
+
+  explicit SignalScheduler(const std::array<StreamConfig, NUM_STREAMS>& configs);
+
+  // Tells whether the stream has messages waiting to be written, which holds back streams of lower priority.
+  void SetBusy(Stream stream, bool busy);
+
+  // Blocks until the stream may write a message of the given size. Returns false if interrupted() became
+  // true meanwhile, which is checked at least once per window.
+  bool Acquire(Stream stream, size_t bytes, const std::function<bool()>& interrupted);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct State {
+    StreamConfig config;
+    int64_t budget_per_window = 0;
+    int64_t tokens = 0;
+    bool busy = false;
+  };
+
+  bool HeldByPriority(Stream stream) const;
+  void Refill(Clock::time_point now);
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::array<State, NUM_STREAMS> streams_;
+  Clock::time_point next_refill_;
+};
+
+}  // namespace collector
+
+#endif  // COLLECTOR_SIGNALSCHEDULER_H
@@ -2,17 +2,32 @@
 
 #include <fstream>
 
+#include "CollectorStats.h"
 #include "GRPCUtil.h"
 #include "Logging.h"
 #include "ProtoUtil.h"
+#include "TimeUtil.h"
 #include "Utility.h"
 
 namespace collector {
 
+constexpr size_t SignalServiceClient::kDefaultQueueSize;
+constexpr size_t SignalServiceClient::kDefaultReplayBufferBytes;
+constexpr size_t SignalServiceClient::kMaxBatchSize;
+constexpr std::chrono::milliseconds SignalServiceClient::kIdleWait;
+constexpr std::chrono::seconds SignalServiceClient::kStreamCheckInterval;
+constexpr int SignalServiceClient::kMaxDropOldestAttempts;
+
+SignalServiceClient::SignalServiceClient(std::shared_ptr<grpc::Channel> channel, size_t queue_size, OverflowPolicy overflow_policy,
+                                         size_t replay_buffer_bytes, std::shared_ptr<SignalScheduler> scheduler)
+    : channel_(std::move(channel)),
+      stream_active_(false),
+      queue_(queue_size),
+      overflow_policy_(overflow_policy),
+      replay_(replay_buffer_bytes),
+      scheduler_(std::move(scheduler)) {}
+
 bool SignalServiceClient::EstablishGRPCStreamSingle() {
-  std::mutex mtx;
-  std::unique_lock<std::mutex> lock(mtx);
-  stream_interrupted_.wait(lock, [this]() { return !stream_active_.load(std::memory_order_acquire) || thread_.should_stop(); });
   if (thread_.should_stop()) {
     return false;
   }
@@ -29,7 +44,7 @@ bool SignalServiceClient::EstablishGRPCStreamSingle() {
   // stream writer
   context_ = MakeUnique<grpc::ClientContext>();
   writer_ = DuplexClient::CreateWithReadsIgnored(&SignalService::Stub::AsyncPushSignals, channel_, context_.get());
-  if (!writer_->WaitUntilStarted(std::chrono::seconds(30))) {
+  if (!writer_->WaitUntilStarted(grpc_duplex_impl::ToDeadline(std::chrono::seconds(30)))) {
     CLOG(ERROR) << "Signal stream not ready after 30 seconds. Retrying ...";
     CLOG(ERROR) << "Error message: " << writer_->FinishNow().error_message();
     writer_.reset();
@@ -37,11 +52,153 @@ bool SignalServiceClient::EstablishGRPCStreamSingle() {
   }
   CLOG(INFO) << "Successfully established GRPC stream for signals.";
 
-  first_write_ = true;
+  // The existing processes are sent again, unless this is a reconnection and the replay buffer held all
+  // the signals of the outage.
+  bool dropped = replay_.TakeDropped();
+  bool replayed_all = connected_before_ && replay_.MaxBytes() > 0 && !dropped;
+  if (replayed_all) {
+    CLOG(INFO) << "Replaying " << replay_.Size() << " signals buffered while the stream was down.";
+  }
+  connected_before_ = true;
+  first_write_.store(!replayed_all);
   stream_active_.store(true, std::memory_order_release);
+
+  SendQueuedSignals();
+  SetBusy(false);
+
+  stream_active_.store(false, std::memory_order_release);
+  if (thread_.should_stop()) {
+    return false;
+  }
+  RequeueForReplay();
+
+  auto status = writer_->FinishNow();
+  if (!status.ok()) {
+    CLOG(ERROR) << "GRPC writes failed: " << status.error_message();
+  }
+  writer_.reset();
+  CLOG(ERROR) << "GRPC stream interrupted";
   return true;
 }
 
+void SignalServiceClient::SendQueuedSignals() {
+  QueuedSignal signal;
+  bool write_pending = false;
+  bool pending_flush = false;
+  int64_t pending_since = 0;
+  size_t batched = 0;
+  unflushed_.clear();
+
+  while (!thread_.should_stop()) {
+    if (write_pending) {
+      auto result = writer_->WaitUntilWritable(kIdleWait);
+      if (result.IsTimeout()) {
+        continue;
+      }
+      if (!result) {
+        return;
+      }
+      HISTOGRAM_RECORD(CollectorStats::process_signal_write, NowMicros() - pending_since);
+      write_pending = false;
+      if (pending_flush) {
+        unflushed_.clear();
+      }
+    }
+
+    // The replay buffer holds older signals than the queue. Signals may still be buffered for a short while
+    // after the stream is established, by producers which saw it down.
+    if (!replay_.Empty() && replay_.Pop(&signal.msg)) {
+      signal.enqueue_micros = NowMicros();
+      COUNTER_INC(CollectorStats::process_replay_sent);
+    } else if (!queue_.TryPop(&signal)) {
+      COUNTER_SET(CollectorStats::process_send_queue_depth, 0);
+      SetBusy(false);
+      if (!WaitForSignals()) {
+        return;
+      }
+      continue;
+    }
+
+    SetBusy(true);
+    if (scheduler_ && !scheduler_->Acquire(SignalScheduler::PROCESS, signal.msg.ByteSizeLong(),
+                                           [this] { return thread_.should_stop(); })) {
+      return;
+    }
+
+    // Signals already queued are written with a buffer hint, so GRPC sends them in a single flush, until
+    // the batch is complete.
+    grpc::WriteOptions options;
+    bool flush = false;
+    if (++batched < kMaxBatchSize && (queue_.Size() > 0 || !replay_.Empty())) {
+      options.set_buffer_hint();
+    } else {
+      COUNTER_INC(CollectorStats::process_send_batches);
+      COUNTER_SET(CollectorStats::process_send_queue_depth, queue_.Size());
+      batched = 0;
+      flush = true;
+    }
+
+    // Kept until the batch is flushed, to be replayed if the stream fails before.
+    unflushed_.push_back(std::move(signal.msg));
+    if (!writer_->WriteAsync(unflushed_.back(), options)) {
+      return;
+    }
+    COUNTER_INC(CollectorStats::process_send_writes);
+    write_pending = true;
+    pending_flush = flush;
+    pending_since = signal.enqueue_micros;
+  }
+}
+
+void SignalServiceClient::RequeueForReplay() {
+  if (replay_.MaxBytes() == 0) {
+    // The existing processes are sent again instead.
+    unflushed_.clear();
+    return;
+  }
+
+  // These are older than the signals producers buffered since they saw the stream down, so they are put
+  // back ahead of them at once.
+  QueuedSignal signal;
+  while (queue_.TryPop(&signal)) {
+    unflushed_.push_back(std::move(signal.msg));
+  }
+  replay_.PushFront(std::move(unflushed_));
+  unflushed_.clear();
+  COUNTER_SET(CollectorStats::process_send_queue_depth, 0);
+}
+
+bool SignalServiceClient::WaitForSignals() {
+  {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    sender_idle_.store(true, std::memory_order_relaxed);
+    // Pairs with the fence in WakeSender: either the signal is seen here, or the sender is seen idle there.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wake_cond_.wait_for(lock, kStreamCheckInterval, [this] {
+      return stopping_ || queue_.Size() > 0 || !replay_.Empty();
+    });
+    sender_idle_.store(false, std::memory_order_relaxed);
+  }
+
+  // Handles the completions of the stream without waiting, which tells whether it failed.
+  return writer_->Sleep(grpc_duplex_impl::ToDeadline(std::chrono::milliseconds(0)));
+}
+
+void SignalServiceClient::WakeSender() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sender_idle_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_cond_.notify_one();
+  }
+}
+
+void SignalServiceClient::SetBusy(bool busy) {
+  if (scheduler_ && busy != busy_) {
+    scheduler_->SetBusy(SignalScheduler::PROCESS, busy);
+    busy_ = busy;
+  }
+}
+
 void SignalServiceClient::EstablishGRPCStream() {
   while (EstablishGRPCStreamSingle())
     ;
@@ -49,49 +206,89 @@ void SignalServiceClient::EstablishGRPCStream() {
 }
 
 void SignalServiceClient::Start() {
+  stopping_ = false;
   thread_.Start([this] { EstablishGRPCStream(); });
 }
 
 void SignalServiceClient::Stop() {
-  stream_interrupted_.notify_one();
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_cond_.notify_one();
   thread_.Stop();
-  context_->TryCancel();
+  if (context_) {
+    context_->TryCancel();
+  }
+  writer_.reset();
   context_.reset();
 }
 
 SignalHandler::Result SignalServiceClient::PushSignals(const SignalStreamMessage& msg) {
   if (!stream_active_.load(std::memory_order_acquire)) {
-    CLOG_THROTTLED(ERROR, std::chrono::seconds(10))
-        << "GRPC stream is not established";
-    return SignalHandler::ERROR;
+    if (replay_.MaxBytes() == 0) {
+      CLOG_THROTTLED(ERROR, std::chrono::seconds(10))
+          << "GRPC stream is not established";
+      return SignalHandler::ERROR;
+    }
+
+    CLOG_THROTTLED(WARNING, std::chrono::seconds(10))
+        << "GRPC stream is not established, buffering signals for replay";
+    replay_.Push(SignalStreamMessage(msg));
+    // The stream may have been established meanwhile.
+    WakeSender();
+    return SignalHandler::PROCESSED;
   }
 
-  if (first_write_) {
-    first_write_ = false;
+  if (first_write_.exchange(false)) {
     return SignalHandler::NEEDS_REFRESH;
   }
 
-  if (!writer_->Write(msg)) {
-    auto status = writer_->FinishNow();
-    if (!status.ok()) {
-      CLOG(ERROR) << "GRPC writes failed: " << status.error_message();
-    }
-    writer_.reset();
+  QueuedSignal signal{msg, NowMicros()};
+  if (queue_.TryPush(std::move(signal))) {
+    WakeSender();
+    return SignalHandler::PROCESSED;
+  }
 
-    stream_active_.store(false, std::memory_order_release);
-    CLOG(ERROR) << "GRPC stream interrupted";
-    stream_interrupted_.notify_one();
+  if (overflow_policy_ == OverflowPolicy::DROP_NEWEST) {
+    COUNTER_INC(CollectorStats::process_send_queue_dropped);
+    CLOG_THROTTLED(WARNING, std::chrono::seconds(10)) << "Signal queue is full, dropping new signals";
     return SignalHandler::ERROR;
   }
 
-  return SignalHandler::PROCESSED;
+  // Make room by dropping the oldest queued signal. Other producers may take the room first, the new signal
+  // is only dropped if that keeps happening.
+  QueuedSignal oldest;
+  for (int attempt = 0; attempt < kMaxDropOldestAttempts; attempt++) {
+    if (queue_.TryPop(&oldest)) {
+      COUNTER_INC(CollectorStats::process_send_queue_dropped);
+    }
+    if (queue_.TryPush(std::move(signal))) {
+      WakeSender();
+      CLOG_THROTTLED(WARNING, std::chrono::seconds(10)) << "Signal queue is full, dropping the oldest signals";
+      return SignalHandler::PROCESSED;
+    }
+  }
+  COUNTER_INC(CollectorStats::process_send_queue_dropped);
+  return SignalHandler::ERROR;
+}
+
+bool SignalServiceClient::Ready() const {
+  return stream_active_.load(std::memory_order_acquire) || replay_.MaxBytes() > 0;
 }
 
 SignalHandler::Result StdoutSignalServiceClient::PushSignals(const SignalStreamMessage& msg) {
-  std::string output;
-  google::protobuf::util::MessageToJsonString(msg, &output, google::protobuf::util::JsonPrintOptions{});
-  CLOG(DEBUG) << "GRPC: " << output;
+  // The conversion to JSON costs more than building the signal, skip it unless it is logged.
+  if (CLOG_ENABLED(DEBUG)) {
+    std::string output;
+    google::protobuf::util::MessageToJsonString(msg, &output, google::protobuf::util::JsonPrintOptions{});
+    CLOG(DEBUG) << "GRPC: " << output;
+  }
   return SignalHandler::PROCESSED;
 }
 
+SignalHandler::Result FileSignalServiceClient::PushSignals(const SignalStreamMessage& msg) {
+  return sink_->Write(msg) ? SignalHandler::PROCESSED : SignalHandler::ERROR;
+}
+
 }  // namespace collector
@@ -4,17 +4,27 @@
 // SIGNAL_SERVICE_CLIENT.h
 // This class defines our GRPC client abstraction
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
+#include <vector>
 
 #include <grpc/grpc.h>
 #include <grpcpp/channel.h>
 #include <grpcpp/client_context.h>
 
+#include <gtest/gtest_prod.h>
+
 #include "api/v1/signal.pb.h"
 #include "internalapi/sensor/signal_iservice.grpc.pb.h"
 
+#include "DelimitedFileSink.h"
 #include "DuplexGRPC.h"
+#include "MPMCQueue.h"
+#include "ReplayBuffer.h"
 #include "SignalHandler.h"
+#include "SignalScheduler.h"
 #include "StoppableThread.h"
 
 namespace collector {
@@ -26,38 +36,115 @@ class ISignalServiceClient {
   virtual void Start() = 0;
   virtual void Stop() = 0;
   virtual SignalHandler::Result PushSignals(const SignalStreamMessage& msg) = 0;
+  // Whether pushed signals can be sent, now or once replayed. When not, PushSignals fails until the stream is
+  // established again, and then asks for the existing processes to be sent again.
+  virtual bool Ready() const { return true; }
 
   virtual ~ISignalServiceClient() {}
 };
 
+// SignalServiceClient sends signals to Sensor without blocking its callers on the network.
+//
+// Signals are pushed into a bounded queue, which any thread may push to, and written on the GRPC stream by a
+// dedicated sender thread. That thread also (re)establishes the stream. Signals queued while the stream is
+// being written are coalesced into batched writes. When the queue is full, the overflow policy decides
+// whether the new signal or the oldest queued one is dropped.
+//
+// While the stream is down, signals are kept in a replay buffer, bounded in bytes, which is sent first once
+// the stream is established again. It also gets back the signals of the batch being written when the stream
+// failed, as they may not have reached Sensor. If the buffer held every signal of the outage, the existing
+// processes are not sent again after reconnecting.
+//
+// With a scheduler, the writes are arbitrated with those of the network stream.
 class SignalServiceClient : public ISignalServiceClient {
  public:
   using SignalService = sensor::SignalService;
   using SignalStreamMessage = sensor::SignalStreamMessage;
 
-  explicit SignalServiceClient(std::shared_ptr<grpc::Channel> channel)
-      : channel_(std::move(channel)), stream_active_(false) {}
+  enum class OverflowPolicy {
+    DROP_NEWEST,
+    DROP_OLDEST,
+  };
+
+  static constexpr size_t kDefaultQueueSize = 4096;
+  static constexpr size_t kDefaultReplayBufferBytes = 16 * 1024 * 1024;
+
+  // A replay buffer of 0 bytes disables replaying, signals pushed while the stream is down are then dropped.
+  explicit SignalServiceClient(std::shared_ptr<grpc::Channel> channel,
+                               size_t queue_size = kDefaultQueueSize,
+                               OverflowPolicy overflow_policy = OverflowPolicy::DROP_NEWEST,
+                               size_t replay_buffer_bytes = kDefaultReplayBufferBytes,
+                               std::shared_ptr<SignalScheduler> scheduler = nullptr);
 
   void Start();
   void Stop();
 
+  // Queues the signal, or buffers it for replay if the stream is not established. Returns ERROR if the signal
+  // was dropped.
   SignalHandler::Result PushSignals(const SignalStreamMessage& msg);
+  bool Ready() const;
 
  private:
+  FRIEND_TEST(SignalServiceClientTest, TestRequeueKeepsOrder);
+  FRIEND_TEST(SignalServiceClientTest, TestReplaysAfterReconnect);
+  FRIEND_TEST(SignalServiceClientTest, TestRefreshesAfterReplayDrops);
+
+  struct QueuedSignal {
+    SignalStreamMessage msg;
+    int64_t enqueue_micros = 0;
+  };
+
+  // Maximum number of signals coalesced into a single flush.
+  static constexpr size_t kMaxBatchSize = 64;
+  // How long the sender waits for a write to complete before checking whether it should stop.
+  static constexpr std::chrono::milliseconds kIdleWait{10};
+  // How long an idle sender sleeps before checking whether the stream failed. It is woken up by new signals.
+  static constexpr std::chrono::seconds kStreamCheckInterval{1};
+  static constexpr int kMaxDropOldestAttempts = 4;
+
   void EstablishGRPCStream();
   bool EstablishGRPCStreamSingle();
+  // Writes replayed, then queued signals until the stream fails or the client is stopped.
+  void SendQueuedSignals();
+  // Moves the signals whose batch was not flushed, then those left in the queue, when the stream went down, to
+  // the replay buffer.
+  void RequeueForReplay();
+  // Tells the scheduler, if any, whether signals are waiting to be written.
+  void SetBusy(bool busy);
+  // Blocks the sender until signals are pushed, the client is stopped, or kStreamCheckInterval elapsed. Returns
+  // false if the stream failed meanwhile.
+  bool WaitForSignals();
+  // Wakes up the sender if it is waiting for signals.
+  void WakeSender();
 
   std::shared_ptr<grpc::Channel> channel_;
 
   StoppableThread thread_;
   std::atomic<bool> stream_active_;
-  std::condition_variable stream_interrupted_;
 
   // This needs to have the same lifetime as the class.
   std::unique_ptr<grpc::ClientContext> context_;
-  std::unique_ptr<IDuplexClientWriter<SignalStreamMessage>> writer_;
-
-  bool first_write_;
+  // Only used by the sender thread.
+  std::unique_ptr<DuplexClientWriter<SignalStreamMessage>> writer_;
+
+  std::atomic<bool> first_write_{false};
+  // Whether a stream was established before, only used by the sender thread.
+  bool connected_before_ = false;
+
+  MPMCQueue<QueuedSignal> queue_;
+  OverflowPolicy overflow_policy_;
+  ReplayBuffer replay_;
+
+  std::shared_ptr<SignalScheduler> scheduler_;
+  // Only used by the sender thread.
+  bool busy_ = false;
+  // The signals written since the last flushed batch, only used by the sender thread.
+  std::vector<SignalStreamMessage> unflushed_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cond_;
+  std::atomic<bool> sender_idle_{false};
+  bool stopping_ = false;
 };
 
 class StdoutSignalServiceClient : public ISignalServiceClient {
@@ -72,6 +159,20 @@ class StdoutSignalServiceClient : public ISignalServiceClient {
   SignalHandler::Result PushSignals(const SignalStreamMessage& msg);
 };
 
+// Writes the signals to a file, as size-delimited records, instead of sending them to Sensor.
+class FileSignalServiceClient : public ISignalServiceClient {
+ public:
+  explicit FileSignalServiceClient(std::unique_ptr<DelimitedFileSink> sink) : sink_(std::move(sink)) {}
+
+  void Start() {}
+  void Stop() { sink_->Flush(); }
+
+  SignalHandler::Result PushSignals(const SignalStreamMessage& msg);
+
+ private:
+  std::unique_ptr<DelimitedFileSink> sink_;
+};
+
 }  // namespace collector
 
 #endif  // __SIGNAL_SERVICE_CLIENT_H
@@ -1,10 +1,37 @@
 
 #include "SysdigEventExtractor.h"
 
+#include <cstring>
+
 #include "Logging.h"
 
 namespace collector {
 
+namespace {
+
+// The fd an event is about, looked up like the "fd.*" filter checks do: events which do not create, use or
+// destroy an fd have none, and when the parser did not attach one to the event, the last fd used by the
+// thread is taken.
+//
+// When no fd is found, the filter checks fall back to extract_from_null_fd, which only recovers the names
+// and types of the fds failed calls would have created from the event parameters. Ports are not among
+// them, so there is no such fallback here.
+auto* get_event_fd_info(sinsp_evt* event) {
+  decltype(event->get_fd_info()) fd_info = nullptr;
+  if (!(event->get_info_flags() & (EF_CREATES_FD | EF_USES_FD | EF_DESTROYS_FD))) return fd_info;
+
+  sinsp_threadinfo* tinfo = event->get_thread_info();
+  if (!tinfo) return fd_info;
+
+  fd_info = event->get_fd_info();
+  if (!fd_info && tinfo->m_lastevent_fd != -1) {
+    fd_info = tinfo->get_fd(tinfo->m_lastevent_fd);
+  }
+  return fd_info;
+}
+
+}  // namespace
+
 void SysdigEventExtractor::Init(sinsp* inspector) {
   for (auto* wrapper : wrappers_) {
     sinsp_filter_check* check = g_filterlist.new_filter_check_from_fldname(wrapper->event_name, inspector, true);
@@ -22,4 +49,75 @@ void SysdigEventExtractor::ClearWrappers() {
   wrappers_.clear();
 }
 
+const char* SysdigEventExtractor::get_proc_args(sinsp_evt* event) {
+  if (!event) return nullptr;
+  sinsp_threadinfo* tinfo = event->get_thread_info(true);
+  if (!tinfo) return nullptr;
+
+  // Only allocates when the arguments outgrow the longest ones joined so far on this thread.
+  thread_local std::string args;
+  args.clear();
+  for (size_t i = 0; i < tinfo->m_args.size(); i++) {
+    if (i > 0) args += ' ';
+    args += tinfo->m_args[i];
+  }
+  return args.c_str();
+}
+
+const int64_t* SysdigEventExtractor::get_event_rawres(sinsp_evt* event) {
+  if (!event || !PPME_IS_EXIT(event->get_type())) return nullptr;
+
+  // The return value is the first parameter of exit events, when they have one.
+  const ppm_event_info* info = event->get_info();
+  if (info->nparams == 0) return nullptr;
+  switch (info->params[0].type) {
+    case PT_ERRNO:
+    case PT_FD:
+    case PT_PID:
+      break;
+    default:
+      return nullptr;
+  }
+
+  const sinsp_evt_param* param = event->get_param(0);
+  if (!param || param->m_len != sizeof(rawres_)) return nullptr;
+
+  std::memcpy(&rawres_, param->m_val, sizeof(rawres_));
+  return &rawres_;
+}
+
+const uint16_t* SysdigEventExtractor::get_client_port(sinsp_evt* event) {
+  if (!event) return nullptr;
+  auto* fd_info = get_event_fd_info(event);
+  if (!fd_info) return nullptr;
+
+  switch (fd_info->m_type) {
+    case SCAP_FD_IPV4_SOCK:
+      return &fd_info->m_sockinfo.m_ipv4info.m_fields.m_sport;
+    case SCAP_FD_IPV6_SOCK:
+      return &fd_info->m_sockinfo.m_ipv6info.m_fields.m_sport;
+    default:
+      return nullptr;
+  }
+}
+
+const uint16_t* SysdigEventExtractor::get_server_port(sinsp_evt* event) {
+  if (!event) return nullptr;
+  auto* fd_info = get_event_fd_info(event);
+  if (!fd_info) return nullptr;
+
+  switch (fd_info->m_type) {
+    case SCAP_FD_IPV4_SOCK:
+      return &fd_info->m_sockinfo.m_ipv4info.m_fields.m_dport;
+    case SCAP_FD_IPV4_SERVSOCK:
+      return &fd_info->m_sockinfo.m_ipv4serverinfo.m_port;
+    case SCAP_FD_IPV6_SOCK:
+      return &fd_info->m_sockinfo.m_ipv6info.m_fields.m_dport;
+    case SCAP_FD_IPV6_SERVSOCK:
+      return &fd_info->m_sockinfo.m_ipv6serverinfo.m_port;
+    default:
+      return nullptr;
+  }
+}
+
 }  // namespace collector
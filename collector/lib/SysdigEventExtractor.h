@@ -99,14 +99,25 @@ class SysdigEventExtractor {
   TINFO_FIELD(pid);
   TINFO_FIELD_RAW(uid, user.uid, uint32_t);
   TINFO_FIELD_RAW(gid, group.gid, uint32_t);
-  FIELD_CSTR(proc_args, "proc.args");
 
-  // General event information
-  FIELD_RAW(event_rawres, "evt.rawres", int64_t);
+  // The following fields are read on every exec or network event. Rather than through the generic
+  // sinsp_filter_check machinery, they are read directly from the event parameters and the thread and
+  // fd information, with the same semantics as the sysdig field named in their description.
+ public:
+  // "proc.args": the arguments of the process, joined by spaces. The string is held in a buffer reused
+  // by the calling thread, so it is only valid until the next call on the same thread.
+  const char* get_proc_args(sinsp_evt* event);
+
+  // "evt.rawres": the return value of the syscall of an exit event.
+  const int64_t* get_event_rawres(sinsp_evt* event);
 
-  // File/network related
-  FIELD_RAW(client_port, "fd.cport", uint16_t);
-  FIELD_RAW(server_port, "fd.sport", uint16_t);
+  // "fd.cport" and "fd.sport": the client and server ports of the socket the event is about.
+  const uint16_t* get_client_port(sinsp_evt* event);
+  const uint16_t* get_server_port(sinsp_evt* event);
+
+ private:
+  // Event parameters may be unaligned, so the return value is copied here.
+  int64_t rawres_ = 0;
 
 #undef TINFO_FIELD
 #undef FIELD_RAW
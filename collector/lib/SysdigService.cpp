@@ -1,5 +1,6 @@
 #include "SysdigService.h"
 
+#include <algorithm>
 #include <cap-ng.h>
 #include <thread>
 
@@ -31,71 +32,128 @@ constexpr char SysdigService::kModulePath[];
 constexpr char SysdigService::kModuleName[];
 constexpr char SysdigService::kProbePath[];
 constexpr char SysdigService::kProbeName[];
+constexpr std::chrono::seconds SysdigService::kStatsPublishInterval;
+constexpr uint64_t SysdigService::kStatsCheckIterations;
 
 void SysdigService::Init(const CollectorConfig& config, std::shared_ptr<ConnectionTracker> conn_tracker) {
+  timing_sampler_ = EventTimingSampler(config.EventTimingSampleRate());
+  existing_processes_ = ExistingProcessCursor(config.ExistingProcessesBatchSize(), config.ExistingProcessesRate());
+
   // The self-check handlers should only operate during start up,
   // so they are added to the handler list first, so they have access
   // to self-check events before the network and process handlers have
   // a chance to process them and send them to Sensor.
-  AddSignalHandler(MakeUnique<SelfCheckProcessHandler>(inspector_.get()));
-  AddSignalHandler(MakeUnique<SelfCheckNetworkHandler>(inspector_.get()));
+  //
+  // A replayed capture contains no self-check events.
+  if (!replaying_) {
+    AddSignalHandler(MakeUnique<SelfCheckProcessHandler>(inspector_.get()));
+    AddSignalHandler(MakeUnique<SelfCheckNetworkHandler>(inspector_.get()));
+  }
+  size_t num_self_check_handlers = signal_handlers_.size();
 
   if (conn_tracker) {
     auto network_signal_handler_ = MakeUnique<NetworkSignalHandler>(inspector_.get(), conn_tracker, &userspace_stats_);
 
     network_signal_handler_->SetCollectConnectionStatus(config.CollectConnectionStatus());
+    if (config.PipelinedDispatch()) {
+      network_signal_handler_->EnablePipeline(config.PipelineQueueSize());
+    }
 
     AddSignalHandler(std::move(network_signal_handler_));
   }
 
+  std::unique_ptr<DelimitedFileSink> signal_file_sink;
+  if (!config.grpc_channel && !config.SignalFile().empty()) {
+    signal_file_sink = DelimitedFileSink::Open(config.SignalFile());
+  }
+
   if (config.grpc_channel) {
-    signal_client_.reset(new SignalServiceClient(std::move(config.grpc_channel)));
+    auto overflow_policy = config.SignalQueueDropOldest() ? SignalServiceClient::OverflowPolicy::DROP_OLDEST
+                                                          : SignalServiceClient::OverflowPolicy::DROP_NEWEST;
+    signal_client_.reset(new SignalServiceClient(std::move(config.grpc_channel), config.SignalQueueSize(), overflow_policy,
+                                                 config.SignalReplayBufferBytes(), signal_scheduler_));
+  } else if (signal_file_sink) {
+    signal_client_.reset(new FileSignalServiceClient(std::move(signal_file_sink)));
   } else {
     signal_client_.reset(new StdoutSignalServiceClient());
   }
-  AddSignalHandler(MakeUnique<ProcessSignalHandler>(inspector_.get(),
-                                                    signal_client_.get(),
-                                                    &userspace_stats_));
+  auto process_signal_handler = MakeUnique<ProcessSignalHandler>(inspector_.get(),
+                                                                 signal_client_.get(),
+                                                                 &userspace_stats_);
+  if (config.PipelinedDispatch()) {
+    process_signal_handler->EnablePipeline(config.PipelineQueueSize());
+  }
+  if (config.ExecCoalesceWindow() > 0) {
+    process_signal_handler->EnableExecCoalescing(std::chrono::seconds(config.ExecCoalesceWindow()));
+  }
+  // The lag of a replayed capture says nothing about the load of this host.
+  if (config.EnrichmentDegradation() && !replaying_) {
+    enrichment_degrader_ = MakeUnique<EnrichmentDegrader>();
+    process_signal_handler->SetEnrichmentDegrader(enrichment_degrader_.get());
+  }
+  process_signal_handler_ = process_signal_handler.get();
+  AddSignalHandler(std::move(process_signal_handler));
 
-  if (signal_handlers_.size() == 2) {
+  if (signal_handlers_.size() == num_self_check_handlers) {
     // self-check handlers do not count towards this check, because they
     // do not send signals to Sensor.
     CLOG(FATAL) << "Internal error: There are no signal handlers.";
   }
-}
 
-bool SysdigService::InitKernel(const CollectorConfig& config, const DriverCandidate& candidate) {
-  if (!inspector_) {
-    inspector_.reset(new sinsp());
-
-    // peeking into arguments has a big overhead, so we prevent it from happening
-    inspector_->set_snaplen(0);
-
-    auto log_level = (sinsp_logger::severity)logging::GetLogLevel();
-    inspector_->set_min_log_severity(log_level);
-    inspector_->disable_log_timestamps();
-    inspector_->set_log_callback(logging::InspectorLogCallback);
-
-    inspector_->set_import_users(config.ImportUsers());
-    inspector_->set_thread_timeout_s(30);
-    inspector_->set_thread_purge_interval_s(60);
-    inspector_->m_thread_manager->set_max_thread_table_size(config.GetSinspThreadCacheSize());
-
-    // Connection status tracking is used in NetworkSignalHandler,
-    // but only when trying to handle asynchronous connections
-    // as a special case.
-    if (config.CollectConnectionStatus()) {
-      inspector_->get_parser()->set_track_connection_status(true);
+  // Shedding works by changing the set of syscalls the kernel driver captures,
+  // which is meaningless for a replayed capture.
+  if (config.SyscallShedding() && !replaying_) {
+    load_shedder_ = MakeUnique<LoadShedder>();
+
+    auto configured_syscalls = config.Syscalls();
+    for (int level = 0; level <= LoadShedder::MaxLevel(); level++) {
+      std::vector<std::string> shed_syscalls;
+      for (const auto& syscall : LoadShedder::SyscallsShedAt(level)) {
+        if (std::find(configured_syscalls.begin(), configured_syscalls.end(), syscall) != configured_syscalls.end()) {
+          shed_syscalls.push_back(syscall);
+        }
+      }
+      shed_ppm_sc_.push_back(IKernelDriver::GetSyscallCodes(shed_syscalls));
     }
+  }
+}
+
+void SysdigService::CreateInspector(const CollectorConfig& config) {
+  inspector_.reset(new sinsp());
 
-    auto engine = std::make_shared<ContainerEngine>(inspector_->m_container_manager);
-    auto* container_engines = inspector_->m_container_manager.get_container_engines();
-    container_engines->push_back(engine);
+  // peeking into arguments has a big overhead, so we prevent it from happening
+  inspector_->set_snaplen(0);
 
-    inspector_->set_filter("container.id != 'host'");
+  auto log_level = (sinsp_logger::severity)logging::GetLogLevel();
+  inspector_->set_min_log_severity(log_level);
+  inspector_->disable_log_timestamps();
+  inspector_->set_log_callback(logging::InspectorLogCallback);
 
-    default_formatter_.reset(new sinsp_evt_formatter(inspector_.get(),
-                                                     DEFAULT_OUTPUT_STR));
+  inspector_->set_import_users(config.ImportUsers());
+  inspector_->set_thread_timeout_s(30);
+  inspector_->set_thread_purge_interval_s(60);
+  inspector_->m_thread_manager->set_max_thread_table_size(config.GetSinspThreadCacheSize());
+
+  // Connection status tracking is used in NetworkSignalHandler,
+  // but only when trying to handle asynchronous connections
+  // as a special case.
+  if (config.CollectConnectionStatus()) {
+    inspector_->get_parser()->set_track_connection_status(true);
+  }
+
+  auto engine = std::make_shared<ContainerEngine>(inspector_->m_container_manager);
+  auto* container_engines = inspector_->m_container_manager.get_container_engines();
+  container_engines->push_back(engine);
+
+  inspector_->set_filter("container.id != 'host'");
+
+  default_formatter_.reset(new sinsp_evt_formatter(inspector_.get(),
+                                                   DEFAULT_OUTPUT_STR));
+}
+
+bool SysdigService::InitKernel(const CollectorConfig& config, const DriverCandidate& candidate) {
+  if (!inspector_) {
+    CreateInspector(config);
   }
 
   std::unique_ptr<IKernelDriver> driver;
@@ -113,13 +171,42 @@ bool SysdigService::InitKernel(const CollectorConfig& config, const DriverCandid
   return true;
 }
 
+bool SysdigService::InitReplay(const CollectorConfig& config) {
+  if (!inspector_) {
+    CreateInspector(config);
+  }
+
+  try {
+    inspector_->open_savefile(config.ReplayFile());
+  } catch (const sinsp_exception& ex) {
+    CLOG(ERROR) << "Failed to open capture " << config.ReplayFile() << ": " << ex.what();
+    return false;
+  }
+
+  replaying_ = true;
+  if (config.ReplayRealtime()) {
+    replay_pacer_ = MakeUnique<ReplayPacer>();
+  }
+
+  return true;
+}
+
 sinsp_evt* SysdigService::GetNext() {
-  std::lock_guard<std::mutex> lock(libsinsp_mutex_);
   sinsp_evt* event;
 
-  auto parse_start = NowMicros();
+  timing_sampled_ = timing_sampler_.Sample();
+  int64_t parse_start = timing_sampled_ ? EventTimingSampler::NowNanos() : 0;
   auto res = inspector_->next(&event);
-  if (res != SCAP_SUCCESS) return nullptr;
+  if (res != SCAP_SUCCESS) {
+    if (res == SCAP_EOF) {
+      capture_ended_ = true;
+    }
+
+    // Most likely a timeout, the buffers are empty: a good time to refresh the stats
+    // of an otherwise idle system.
+    PublishKernelStatsIfDue();
+    return nullptr;
+  }
 
 #ifdef TRACE_SINSP_EVENTS
   // Do not allow to change sinsp events tracing at runtime, as the output
@@ -147,13 +234,16 @@ sinsp_evt* SysdigService::GetNext() {
     return nullptr;
   }
 
-  userspace_stats_.event_parse_micros[event->get_type()] += (NowMicros() - parse_start);
-  ++userspace_stats_.nUserspaceEvents[event->get_type()];
+  auto& counters = event_counters_[event->get_type()];
+  if (timing_sampled_) {
+    EventCounters::Add(counters.parse_micros, timing_sampler_.ScaledMicros(EventTimingSampler::NowNanos() - parse_start));
+  }
+  EventCounters::Add(counters.userspace, 1);
 
   if (!FilterEvent(event)) {
     return nullptr;
   }
-  ++userspace_stats_.nFilteredEvents[event->get_type()];
+  EventCounters::Add(counters.filtered, 1);
 
   return event;
 }
@@ -186,8 +276,6 @@ bool SysdigService::FilterEvent(const sinsp_threadinfo* tinfo) {
 }
 
 void SysdigService::Start() {
-  std::lock_guard<std::mutex> libsinsp_lock(libsinsp_mutex_);
-
   if (!inspector_) {
     throw CollectorException("Invalid state: SysdigService was not initialized");
   }
@@ -198,15 +286,17 @@ void SysdigService::Start() {
     }
   }
 
-  inspector_->start_capture();
+  if (!replaying_) {
+    inspector_->start_capture();
 
-  // trigger the self check process only once capture has started,
-  // to verify the driver is working correctly. SelfCheckHandlers will
-  // verify the live events.
-  std::thread self_checks_thread(self_checks::start_self_check_process);
-  self_checks_thread.detach();
+    // trigger the self check process only once capture has started,
+    // to verify the driver is working correctly. SelfCheckHandlers will
+    // verify the live events.
+    std::thread self_checks_thread(self_checks::start_self_check_process);
+    self_checks_thread.detach();
+  }
 
-  std::lock_guard<std::mutex> running_lock(running_mutex_);
+  PublishKernelStats();
   running_ = true;
 }
 
@@ -233,41 +323,87 @@ void SysdigService::Run(const std::atomic<ControlValue>& control) {
     throw CollectorException("Invalid state: SysdigService was not initialized");
   }
 
-  while (control.load(std::memory_order_relaxed) == ControlValue::RUN) {
+  while (control.load(std::memory_order_relaxed) == ControlValue::RUN && !capture_ended_) {
     ServePendingProcessRequests();
 
+    if (existing_processes_.Active()) {
+      SendExistingProcessesBatch();
+    }
+
+    if (++loop_iterations_ % kStatsCheckIterations == 0) {
+      PublishKernelStatsIfDue();
+    }
+
     sinsp_evt* evt = GetNext();
     if (!evt) continue;
 
-    auto process_start = NowMicros();
-    for (auto it = signal_handlers_.begin(); it != signal_handlers_.end(); it++) {
-      auto& signal_handler = *it;
-      if (!signal_handler.ShouldHandle(evt)) continue;
-      LogUnreasonableEventTime(process_start, evt);
-      auto result = signal_handler.handler->HandleSignal(evt);
-      if (result == SignalHandler::NEEDS_REFRESH) {
-        if (!SendExistingProcesses(signal_handler.handler.get())) {
-          continue;
-        }
-        result = signal_handler.handler->HandleSignal(evt);
-      } else if (result == SignalHandler::FINISHED) {
-        // This signal handler has finished processing events,
-        // so remove it from the signal handler list.
-        //
-        // We don't need to update the iterator post-deletion
-        // because we also stop iteration at this point.
-        signal_handlers_.erase(it);
-        break;
+    if (replay_pacer_) {
+      replay_pacer_->Wait(evt->get_ts());
+    }
+
+    // A handler may be removed while handling the event, whether there was one is decided beforehand.
+    bool dispatched = dispatch_table_[evt->get_type()].num_targets > 0;
+
+    int64_t process_start = 0;
+    if (timing_sampled_) {
+      process_start = EventTimingSampler::NowNanos();
+      // The timestamps of a replayed capture are those of its recording, their age is not a queueing lag.
+      if (dispatched && !replaying_) {
+        int64_t now = NowMicros();
+        int64_t lag_micros = now - evt->get_ts() / 1000;
+        LogUnreasonableEventTime(now, evt);
+        max_event_lag_micros_ = std::max<int64_t>(max_event_lag_micros_, lag_micros);
+        event_latencies_[evt->get_type()].queue.Record(lag_micros, timing_sampler_.Rate());
       }
     }
 
-    userspace_stats_.event_process_micros[evt->get_type()] += (NowMicros() - process_start);
+    DispatchEvent(evt);
+
+    if (timing_sampled_) {
+      int64_t process_nanos = EventTimingSampler::NowNanos() - process_start;
+      EventCounters::Add(event_counters_[evt->get_type()].process_micros, timing_sampler_.ScaledMicros(process_nanos));
+      if (dispatched) {
+        event_latencies_[evt->get_type()].handle.Record(process_nanos / 1000, timing_sampler_.Rate());
+      }
+    }
   }
 }
 
-bool SysdigService::SendExistingProcesses(SignalHandler* handler) {
-  std::lock_guard<std::mutex> lock(libsinsp_mutex_);
+void SysdigService::DispatchEvent(sinsp_evt* evt) {
+  const auto& dispatch = dispatch_table_[evt->get_type()];
+
+  // The handler stats only feed the replay report, live collection does not pay for the CPU clock reads.
+  bool time_handlers = timing_sampled_ && replaying_;
+  size_t i = 0;
+  while (i < dispatch.num_targets) {
+    const auto& target = dispatch.targets[i];
+    int64_t cpu_start = time_handlers ? EventTimingSampler::ThreadCpuNanos() : 0;
+    auto result = target.handler->HandleTaggedSignal(evt, target.tag);
+    if (time_handlers) {
+      target.stats->calls += timing_sampler_.Rate();
+      target.stats->cpu_micros += timing_sampler_.ScaledMicros(EventTimingSampler::ThreadCpuNanos() - cpu_start);
+    }
+
+    if (result == SignalHandler::NEEDS_REFRESH) {
+      // The existing processes are sent in batches between the next events,
+      // this one does not need to wait for them.
+      if (StartSendingExistingProcesses(target.handler)) {
+        target.handler->HandleTaggedSignal(evt, target.tag);
+      }
+    } else if (result == SignalHandler::FINISHED) {
+      // This signal handler has finished processing events,
+      // so remove it from the signal handler list.
+      //
+      // The dispatch table is rebuilt in place: the following
+      // handlers moved down by one, and still get the event.
+      RemoveSignalHandler(target.handler);
+      continue;
+    }
+    i++;
+  }
+}
 
+bool SysdigService::StartSendingExistingProcesses(SignalHandler* handler) {
   if (!inspector_) {
     throw CollectorException("Invalid state: SysdigService was not initialized");
   }
@@ -278,23 +414,55 @@ bool SysdigService::SendExistingProcesses(SignalHandler* handler) {
     return false;
   }
 
-  return threads->loop([&](sinsp_threadinfo& tinfo) {
+  std::vector<int64_t> tids;
+  threads->loop([&](sinsp_threadinfo& tinfo) {
     if (!tinfo.m_container_id.empty() && tinfo.is_main_thread()) {
-      auto result = handler->HandleExistingProcess(&tinfo);
-      if (result == SignalHandler::ERROR || result == SignalHandler::NEEDS_REFRESH) {
-        CLOG(WARNING) << "Failed to write existing process signal: " << &tinfo;
-        return false;
-      }
-      CLOG(DEBUG) << "Found existing process: " << &tinfo;
+      tids.push_back(tinfo.m_tid);
     }
     return true;
   });
+
+  CLOG(INFO) << "Sending " << tids.size() << " existing processes";
+  existing_processes_.Start(handler, std::move(tids), NowMicros());
+  return true;
+}
+
+void SysdigService::SendExistingProcessesBatch() {
+  SignalHandler* handler = existing_processes_.Handler();
+  existing_processes_.NextBatch(NowMicros(), &existing_processes_batch_);
+
+  for (int64_t tid : existing_processes_batch_) {
+    // The process may have exited since the snapshot was taken.
+    auto tinfo = inspector_->get_thread_ref(tid, false);
+    if (!tinfo) {
+      continue;
+    }
+
+    auto result = handler->HandleExistingProcess(tinfo.get());
+    if (result == SignalHandler::NEEDS_REFRESH) {
+      // The stream was established again, start over.
+      StartSendingExistingProcesses(handler);
+      return;
+    }
+    if (result == SignalHandler::ERROR) {
+      if (!signal_client_->Ready()) {
+        // Nothing gets through until the stream is established again, which starts over.
+        CLOG(WARNING) << "Stopped sending existing processes, the signal stream is down";
+        existing_processes_.Stop();
+        return;
+      }
+      // A full queue only drops this signal, the following ones may get through.
+      COUNTER_INC(CollectorStats::process_existing_dropped);
+      CLOG_THROTTLED(WARNING, std::chrono::seconds(10)) << "Failed to write existing process signal: " << tinfo.get();
+      continue;
+    }
+    CLOG(DEBUG) << "Found existing process: " << tinfo.get();
+  }
 }
 
 void SysdigService::CleanUp() {
-  std::lock_guard<std::mutex> libsinsp_lock(libsinsp_mutex_);
-  std::lock_guard<std::mutex> running_lock(running_mutex_);
   running_ = false;
+  existing_processes_.Stop();
   inspector_->close();
   inspector_.reset();
 
@@ -304,7 +472,9 @@ void SysdigService::CleanUp() {
     }
   }
 
+  process_signal_handler_ = nullptr;
   signal_handlers_.clear();
+  RebuildDispatchTable();
 
   // Cancel all pending process requests
   std::lock_guard<std::mutex> lock(process_requests_mutex_);
@@ -317,20 +487,91 @@ void SysdigService::CleanUp() {
 
     pending_process_requests_.pop_front();
   }
+
+  while (!pending_batch_requests_.empty()) {
+    auto& request = pending_batch_requests_.front();
+    auto callback = request.second.lock();
+
+    if (callback) (*callback)(std::vector<threadinfo_map_t::ptr_t>(request.first.size()));
+
+    pending_batch_requests_.pop_front();
+  }
+}
+
+void SysdigService::PublishKernelStats() {
+  scap_stats capture_stats;
+  inspector_->get_capture_stats(&capture_stats);
+
+  KernelStats kernel_stats;
+  kernel_stats.events = capture_stats.n_evts;
+  kernel_stats.drops = capture_stats.n_drops;
+  kernel_stats.preemptions = capture_stats.n_preemptions;
+  kernel_stats.thread_cache_size = inspector_->m_thread_manager->get_thread_count();
+
+  std::chrono::microseconds max_lag(max_event_lag_micros_);
+  max_event_lag_micros_ = 0;
+
+  if (load_shedder_) {
+    int level = load_shedder_->Level();
+    if (load_shedder_->Update(capture_stats.n_evts, capture_stats.n_drops, max_lag) != level) {
+      ApplySheddingLevel(load_shedder_->Level());
+    }
+    kernel_stats.shedding_level = load_shedder_->Level();
+  }
+
+  if (enrichment_degrader_) {
+    enrichment_degrader_->Update(max_lag);
+  }
+
+  kernel_stats_.Store(kernel_stats);
+
+  next_stats_publish_ = std::chrono::steady_clock::now() + kStatsPublishInterval;
+}
+
+void SysdigService::ApplySheddingLevel(int level) {
+  const auto& shed = shed_ppm_sc_[level];
+  for (ppm_sc_code ppm_sc : shed_ppm_sc_.back()) {
+    inspector_->mark_ppm_sc_of_interest(ppm_sc, shed.find(ppm_sc) == shed.end());
+  }
+  if (process_signal_handler_) {
+    process_signal_handler_->SetUidChangesCaptured(!LoadShedder::ShedsUidChanges(level));
+  }
+}
+
+void SysdigService::PublishKernelStatsIfDue() {
+  if (std::chrono::steady_clock::now() >= next_stats_publish_) {
+    PublishKernelStats();
+
+    // Also due every second, including on an idle system.
+    FlushSignalHandlers();
+  }
+}
+
+void SysdigService::FlushSignalHandlers() {
+  for (auto& signal_handler : signal_handlers_) {
+    if (signal_handler.handler->Flush() == SignalHandler::NEEDS_REFRESH) {
+      StartSendingExistingProcesses(signal_handler.handler.get());
+    }
+  }
 }
 
 bool SysdigService::GetStats(SysdigStats* stats) const {
-  std::lock_guard<std::mutex> libsinsp_lock(libsinsp_mutex_);
-  std::lock_guard<std::mutex> running_lock(running_mutex_);
-  if (!running_ || !inspector_) return false;
+  if (!running_) return false;
 
-  scap_stats kernel_stats;
-  inspector_->get_capture_stats(&kernel_stats);
+  KernelStats kernel_stats = kernel_stats_.Load();
   *stats = userspace_stats_;
-  stats->nEvents = kernel_stats.n_evts;
-  stats->nDrops = kernel_stats.n_drops;
-  stats->nPreemptions = kernel_stats.n_preemptions;
-  stats->nThreadCacheSize = inspector_->m_thread_manager->get_thread_count();
+  for (int i = 0; i < PPM_EVENT_MAX; i++) {
+    const auto& counters = event_counters_[i];
+    stats->nUserspaceEvents[i] = counters.userspace.load(std::memory_order_relaxed);
+    stats->nFilteredEvents[i] = counters.filtered.load(std::memory_order_relaxed);
+    stats->event_parse_micros[i] = counters.parse_micros.load(std::memory_order_relaxed);
+    stats->event_process_micros[i] = counters.process_micros.load(std::memory_order_relaxed);
+  }
+  stats->nEvents = kernel_stats.events;
+  stats->nDrops = kernel_stats.drops;
+  stats->nPreemptions = kernel_stats.preemptions;
+  stats->nThreadCacheSize = kernel_stats.thread_cache_size;
+  stats->nSyscallSheddingLevel = kernel_stats.shedding_level;
 
   return true;
 }
@@ -351,6 +592,48 @@ void SysdigService::AddSignalHandler(std::unique_ptr<SignalHandler> signal_handl
   }
 
   signal_handlers_.emplace_back(std::move(signal_handler), event_filter);
+  RebuildDispatchTable();
+}
+
+void SysdigService::RemoveSignalHandler(SignalHandler* signal_handler) {
+  auto it = std::find_if(signal_handlers_.begin(), signal_handlers_.end(),
+                         [signal_handler](const SignalHandlerEntry& entry) { return entry.handler.get() == signal_handler; });
+  if (it == signal_handlers_.end()) return;
+
+  if (existing_processes_.Handler() == signal_handler) {
+    existing_processes_.Stop();
+  }
+  signal_handlers_.erase(it);
+  RebuildDispatchTable();
+}
+
+std::vector<HandlerStats> SysdigService::GetHandlerStats() const {
+  std::vector<HandlerStats> stats;
+  stats.reserve(signal_handlers_.size());
+  for (const auto& signal_handler : signal_handlers_) {
+    stats.push_back(signal_handler.stats);
+  }
+  return stats;
+}
+
+void SysdigService::RebuildDispatchTable() {
+  for (size_t event_id = 0; event_id < dispatch_table_.size(); event_id++) {
+    auto& dispatch = dispatch_table_[event_id];
+    dispatch.num_targets = 0;
+
+    for (auto& signal_handler : signal_handlers_) {
+      if (!signal_handler.event_filter[event_id]) continue;
+
+      if (dispatch.num_targets == dispatch.targets.size()) {
+        CLOG(FATAL) << "Internal error: more than " << dispatch.targets.size() << " signal handlers for event " << event_id;
+      }
+
+      auto& target = dispatch.targets[dispatch.num_targets++];
+      target.handler = signal_handler.handler.get();
+      target.stats = &signal_handler.stats;
+      target.tag = signal_handler.handler->GetEventTag(event_id);
+    }
+  }
 }
 
 void SysdigService::GetProcessInformation(uint64_t pid, ProcessInfoCallbackRef callback) {
@@ -359,6 +642,12 @@ void SysdigService::GetProcessInformation(uint64_t pid, ProcessInfoCallbackRef c
   pending_process_requests_.emplace_back(pid, callback);
 }
 
+void SysdigService::GetProcessInformationBatch(std::vector<uint64_t> pids, ProcessInfoBatchCallbackRef callback) {
+  std::lock_guard<std::mutex> lock(process_requests_mutex_);
+
+  pending_batch_requests_.emplace_back(std::move(pids), callback);
+}
+
 void SysdigService::ServePendingProcessRequests() {
   std::lock_guard<std::mutex> lock(process_requests_mutex_);
 
@@ -373,6 +662,22 @@ void SysdigService::ServePendingProcessRequests() {
 
     pending_process_requests_.pop_front();
   }
+
+  while (!pending_batch_requests_.empty()) {
+    auto& request = pending_batch_requests_.front();
+    auto callback = request.second.lock();
+
+    if (callback) {
+      std::vector<threadinfo_map_t::ptr_t> process_infos;
+      process_infos.reserve(request.first.size());
+      for (uint64_t pid : request.first) {
+        process_infos.push_back(inspector_->get_thread_ref(pid, false));
+      }
+      (*callback)(process_infos);
+    }
+
+    pending_batch_requests_.pop_front();
+  }
 }
 
 }  // namespace collector
@@ -1,11 +1,15 @@
 #ifndef _SYSDIG_SERVICE_H_
 #define _SYSDIG_SERVICE_H_
 
+#include <array>
 #include <atomic>
 #include <bitset>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include <gtest/gtest_prod.h>
 
@@ -13,13 +17,22 @@
 
 #include "Control.h"
 #include "DriverCandidates.h"
+#include "EnrichmentDegrader.h"
+#include "EventStats.h"
+#include "ExistingProcessCursor.h"
+#include "LoadShedder.h"
+#include "Replay.h"
+#include "SeqLock.h"
 #include "SignalHandler.h"
+#include "SignalScheduler.h"
 #include "SignalServiceClient.h"
 #include "Sysdig.h"
 #include "threadinfo.h"
 
 namespace collector {
 
+class ProcessSignalHandler;
+
 class SysdigService : public Sysdig {
  public:
   static constexpr char kModulePath[] = "/module/collector.ko";
@@ -40,48 +53,152 @@ class SysdigService : public Sysdig {
 
   bool InitKernel(const CollectorConfig& config, const DriverCandidate& candidate) override;
 
+  // Reads events from the capture file configured for replay, instead of from a kernel driver.
+  bool InitReplay(const CollectorConfig& config);
+
+  // Arbitrates the writes of process signals with those of the network stream. Must be called before Init.
+  void SetSignalScheduler(std::shared_ptr<SignalScheduler> scheduler) { signal_scheduler_ = std::move(scheduler); }
+
+  // Whether the end of the replayed capture was reached.
+  bool CaptureEnded() const { return capture_ended_; }
+
+  // The work done by each signal handler on the event thread, only measured when replaying a capture. Must not be
+  // called while Run is running.
+  std::vector<HandlerStats> GetHandlerStats() const;
+
+  // The latency histograms of an event type. May be read from any thread.
+  const EventLatencies& GetEventLatencies(uint16_t event_type) const { return event_latencies_[event_type]; }
+
   typedef std::weak_ptr<std::function<void(threadinfo_map_t::ptr_t)>> ProcessInfoCallbackRef;
 
   void GetProcessInformation(uint64_t pid, ProcessInfoCallbackRef callback);
 
+  typedef std::weak_ptr<std::function<void(const std::vector<threadinfo_map_t::ptr_t>&)>> ProcessInfoBatchCallbackRef;
+
+  // Looks up all the given pids in the thread table at once, without querying the OS for unknown
+  // ones. The callback receives one entry per pid, null when the thread is not known.
+  void GetProcessInformationBatch(std::vector<uint64_t> pids, ProcessInfoBatchCallbackRef callback);
+
  private:
   FRIEND_TEST(SysdigServiceTest, FilterEvent);
+  FRIEND_TEST(SysdigServiceTest, ExistingProcessesSurviveDrops);
+  FRIEND_TEST(SysdigServiceTest, DispatchTable);
+  FRIEND_TEST(SysdigServiceTest, FinishedHandlerIsRemoved);
+  FRIEND_TEST(SysdigServiceTest, FlushStartsExistingProcesses);
 
   struct SignalHandlerEntry {
     std::unique_ptr<SignalHandler> handler;
     std::bitset<PPM_EVENT_MAX> event_filter;
+    HandlerStats stats;
 
     SignalHandlerEntry(std::unique_ptr<SignalHandler> handler, std::bitset<PPM_EVENT_MAX> event_filter)
-        : handler(std::move(handler)), event_filter(event_filter) {}
-
-    bool ShouldHandle(sinsp_evt* evt) const {
-      return event_filter[evt->get_type()];
+        : handler(std::move(handler)), event_filter(event_filter) {
+      stats.name = this->handler->GetName();
     }
   };
 
+  // The signal handlers relevant for an event type, in registration order, along with the tag each of
+  // them assigned to the event type.
+  struct EventDispatch {
+    static constexpr size_t kMaxTargets = 4;
+
+    struct Target {
+      SignalHandler* handler = nullptr;
+      SignalHandler::EventTag tag = 0;
+      HandlerStats* stats = nullptr;
+    };
+
+    size_t num_targets = 0;
+    std::array<Target, kMaxTargets> targets;
+  };
+
+  // The capture statistics only libsinsp can provide, as last published by the event thread.
+  struct KernelStats {
+    uint64_t events = 0;
+    uint64_t drops = 0;
+    uint64_t preemptions = 0;
+    uint64_t thread_cache_size = 0;
+    uint64_t shedding_level = 0;
+  };
+
+  // How often the event thread refreshes the published kernel stats.
+  static constexpr std::chrono::seconds kStatsPublishInterval{1};
+  // Number of loop iterations between two checks of whether the kernel stats are due.
+  static constexpr uint64_t kStatsCheckIterations = 1024;
+
+  void CreateInspector(const CollectorConfig& config);
   sinsp_evt* GetNext();
   static bool FilterEvent(sinsp_evt* event);
   static bool FilterEvent(const sinsp_threadinfo* tinfo);
 
-  bool SendExistingProcesses(SignalHandler* handler);
+  // Starts sending the existing processes to the handler, in batches between events.
+  bool StartSendingExistingProcesses(SignalHandler* handler);
+  void SendExistingProcessesBatch();
+
+  // Hands the event to the signal handlers relevant for its type.
+  void DispatchEvent(sinsp_evt* evt);
 
   void AddSignalHandler(std::unique_ptr<SignalHandler> signal_handler);
+  void RemoveSignalHandler(SignalHandler* signal_handler);
+  // Must be called whenever signal_handlers_ changes.
+  void RebuildDispatchTable();
+
+  // Must only be called from the event thread.
+  void PublishKernelStats();
+  // Publishes the stats, and flushes the signal handlers, once a second has elapsed since the last publication.
+  void PublishKernelStatsIfDue();
+  // Starts sending the existing processes for the handlers which ask for it.
+  void FlushSignalHandlers();
+  void ApplySheddingLevel(int level);
 
-  mutable std::mutex libsinsp_mutex_;
   std::unique_ptr<sinsp> inspector_;
   std::unique_ptr<sinsp_evt_formatter> default_formatter_;
   std::unique_ptr<ISignalServiceClient> signal_client_;
   std::vector<SignalHandlerEntry> signal_handlers_;
+  std::array<EventDispatch, PPM_EVENT_MAX> dispatch_table_;
   SysdigStats userspace_stats_;
+  // Per event type counters, only written by the event thread.
+  EventCounters event_counters_;
+  EventTimingSampler timing_sampler_;
+  // Per event type latencies, allocated separately given their size.
+  std::unique_ptr<EventLatencies[]> event_latencies_{new EventLatencies[PPM_EVENT_MAX]};
+  // Whether the timing of the current event is sampled.
+  bool timing_sampled_ = false;
+  ExistingProcessCursor existing_processes_;
+  std::vector<int64_t> existing_processes_batch_;
   std::bitset<PPM_EVENT_MAX> global_event_filter_;
 
-  mutable std::mutex running_mutex_;
-  bool running_ = false;
+  // libsinsp is only ever used from the event thread. Other threads read its statistics from this
+  // snapshot, so the event loop never takes a lock.
+  SeqLock<KernelStats> kernel_stats_;
+  std::chrono::steady_clock::time_point next_stats_publish_;
+  uint64_t loop_iterations_ = 0;
+
+  // Set when syscall shedding is enabled.
+  std::unique_ptr<LoadShedder> load_shedder_;
+  // The syscalls not captured at each shedding level.
+  std::vector<std::unordered_set<ppm_sc_code>> shed_ppm_sc_;
+  // Set when process enrichment degradation is enabled.
+  std::unique_ptr<EnrichmentDegrader> enrichment_degrader_;
+  // Owned by signal_handlers_, told when shedding stops capturing the uid changes of processes.
+  ProcessSignalHandler* process_signal_handler_ = nullptr;
+  std::shared_ptr<SignalScheduler> signal_scheduler_;
+  // Largest delay between the emission and the handling of a sampled event, since the last stats publication.
+  int64_t max_event_lag_micros_ = 0;
+
+  std::atomic<bool> running_{false};
+
+  // Set when replaying a capture file.
+  bool replaying_ = false;
+  std::unique_ptr<ReplayPacer> replay_pacer_;
+  bool capture_ended_ = false;
 
   void ServePendingProcessRequests();
   mutable std::mutex process_requests_mutex_;
   // [ ( pid, callback ), ( pid, callback ), ... ]
   std::list<std::pair<uint64_t, ProcessInfoCallbackRef>> pending_process_requests_;
+  // [ ( [pid, ...], callback ), ... ]
+  std::list<std::pair<std::vector<uint64_t>, ProcessInfoBatchCallbackRef>> pending_batch_requests_;
 };
 
 }  // namespace collector
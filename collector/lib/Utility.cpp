@@ -12,10 +12,10 @@ extern "C" {
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
-#include <uuid/uuid.h>
 }
 
 #include <fstream>
+#include <random>
 #include <regex>
 
 #include "HostInfo.h"
@@ -63,12 +63,65 @@ std::ostream& operator<<(std::ostream& os, const sinsp_threadinfo* t) {
   return os;
 }
 
+namespace {
+
+// Xoshiro256StarStar is a small and fast pseudo-random generator (https://prng.di.unimi.it/), good enough
+// to make UUID collisions as unlikely as with the random bits of the system generator it is seeded from.
+class Xoshiro256StarStar {
+ public:
+  Xoshiro256StarStar() {
+    std::random_device random;
+    for (auto& word : state_) {
+      word = (static_cast<uint64_t>(random()) << 32) | random();
+    }
+  }
+
+  uint64_t Next() {
+    uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+    uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = Rotl(state_[3], 45);
+    return result;
+  }
+
+ private:
+  static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t state_[4];
+};
+
+void FormatHex(uint64_t bits, int num_digits, char* out) {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  for (int i = num_digits - 1; i >= 0; i--) {
+    out[i] = kHexDigits[bits & 0xf];
+    bits >>= 4;
+  }
+}
+
+}  // namespace
+
 const char* UUIDStr() {
-  uuid_t uuid;
-  constexpr int kUuidStringLength = 36;  // uuid_unparse manpage says so.
-  thread_local char uuid_str[kUuidStringLength + 1];
-  uuid_generate_time_safe(uuid);
-  uuid_unparse_lower(uuid, uuid_str);
+  thread_local Xoshiro256StarStar generator;
+  thread_local char uuid_str[kUUIDStringLength + 1];
+
+  // A random (version 4, variant 1) UUID.
+  uint64_t high = (generator.Next() & ~uint64_t{0xf000}) | 0x4000;
+  uint64_t low = (generator.Next() & ~(uint64_t{0x3} << 62)) | (uint64_t{0x2} << 62);
+
+  FormatHex(high >> 32, 8, uuid_str);
+  uuid_str[8] = '-';
+  FormatHex(high >> 16, 4, uuid_str + 9);
+  uuid_str[13] = '-';
+  FormatHex(high, 4, uuid_str + 14);
+  uuid_str[18] = '-';
+  FormatHex(low >> 48, 4, uuid_str + 19);
+  uuid_str[23] = '-';
+  FormatHex(low, 12, uuid_str + 24);
+  uuid_str[kUUIDStringLength] = '\0';
 
   return uuid_str;
 }
@@ -79,7 +79,10 @@ std::string Str(Args&&... args) {
 
 std::ostream& operator<<(std::ostream& os, const sinsp_threadinfo* t);
 
-// UUIDStr returns UUID in string format.
+constexpr size_t kUUIDStringLength = 36;
+
+// UUIDStr returns a random UUID in string format, from a per-thread generator. The returned string is
+// valid until the next call on the same thread.
 const char* UUIDStr();
 
 namespace internal {
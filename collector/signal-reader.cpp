@@ -0,0 +1,64 @@
+// Prints the signals written by Collector to ROX_COLLECTOR_SIGNAL_FILE or ROX_COLLECTOR_NETWORK_FILE, one JSON
+// object per line.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <google/protobuf/util/json_util.h>
+
+#include "internalapi/sensor/network_connection_iservice.pb.h"
+#include "internalapi/sensor/signal_iservice.pb.h"
+
+namespace {
+
+template <typename M>
+int Print(int fd) {
+  google::protobuf::io::FileInputStream input(fd);
+  M msg;
+  std::string output;
+  bool clean_eof = false;
+  while (google::protobuf::util::ParseDelimitedFromZeroCopyStream(&msg, &input, &clean_eof)) {
+    output.clear();
+    google::protobuf::util::MessageToJsonString(msg, &output, google::protobuf::util::JsonPrintOptions{});
+    std::cout << output << '\n';
+  }
+  if (!clean_eof) {
+    std::cerr << "Truncated or corrupted record" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool network = false;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--network") == 0) {
+      network = true;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  if (path == nullptr) {
+    std::cerr << "Usage: " << argv[0] << " [--network] <file|->" << std::endl;
+    return 2;
+  }
+
+  int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+
+  return network ? Print<sensor::NetworkConnectionInfoMessage>(fd) : Print<sensor::SignalStreamMessage>(fd);
+}
@@ -0,0 +1,54 @@
+#include "CgroupContainerCache.h"
+#include "CollectorStats.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+const std::string kDockerCgroup = "/docker/951e643e3c241b225b6284ef2b79a37c13fc64cbf65b5d46bda95fcb98fe63a4";
+const std::string kCrioCgroup =
+    "/kubepods/besteffort/pod690705f9-df6e-11e9-8dc5-025000000001/crio-c9f3e84a1e2f3a0ab4ea5bba90f1ba6e7b5b3bbd6a3a8fc9da0e1e9d5f2d3c1a.scope";
+const std::string kHostCgroup = "/system.slice/sshd.service";
+
+TEST(CgroupContainerCacheTest, TestResolve) {
+  CgroupContainerCache cache;
+
+  EXPECT_EQ(cache.Resolve(kDockerCgroup), "951e643e3c24");
+  EXPECT_EQ(cache.Resolve(kCrioCgroup), "c9f3e84a1e2f");
+  EXPECT_EQ(cache.Resolve(kHostCgroup), "");
+  EXPECT_EQ(cache.Size(), 3);
+}
+
+TEST(CgroupContainerCacheTest, TestHitsAndMisses) {
+  CollectorStats::Reset();
+  CgroupContainerCache cache;
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(cache.Resolve(kDockerCgroup), "951e643e3c24");
+    EXPECT_EQ(cache.Resolve(kHostCgroup), "");
+  }
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::container_cgroup_cache_misses), 2);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::container_cgroup_cache_hits), 18);
+}
+
+TEST(CgroupContainerCacheTest, TestBounded) {
+  CollectorStats::Reset();
+  CgroupContainerCache cache(2);
+
+  cache.Resolve(kDockerCgroup);
+  cache.Resolve(kCrioCgroup);
+  EXPECT_EQ(cache.Size(), 2);
+
+  EXPECT_EQ(cache.Resolve(kHostCgroup), "");
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_EQ(cache.Resolve(kDockerCgroup), "951e643e3c24");
+
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::container_cgroup_cache_flushes), 1);
+}
+
+}  // namespace
+
+}  // namespace collector
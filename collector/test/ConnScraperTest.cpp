@@ -1,5 +1,17 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
 #include <string_view>
+#include <vector>
 
+#include "CollectorStats.h"
+#include "ProcfsScraper.h"
 #include "ProcfsScraper_internal.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -46,6 +58,220 @@ TEST(ConnScraperTest, TestExtractContainerID) {
   }
 }
 
+TEST(ConnScraperTest, TestFDTableFingerprint) {
+  FDTableFingerprint empty;
+  FDTableFingerprint a, b, c;
+
+  for (int fd : {0, 1, 2, 5}) {
+    a.Add(fd);
+  }
+  for (int fd : {5, 2, 1, 0}) {
+    b.Add(fd);
+  }
+  for (int fd : {0, 1, 2, 3, 5}) {
+    c.Add(fd);
+  }
+
+  EXPECT_EQ(a.num_fds, 4);
+  EXPECT_EQ(a.max_fd, 5);
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a == c);
+  EXPECT_FALSE(a == empty);
+}
+
+// Container ids as found in the cgroup file, and as reported by the scraper.
+constexpr char kContainerA[] = "951e643e3c241b225b6284ef2b79a37c13fc64cbf65b5d46bda95fcb98fe63a4";
+constexpr char kContainerB[] = "e73c55f3e7f5b6a9cfc32a89bf13e44d348bcc4fa7b079f804d61fb1532ddbe5";
+constexpr ino_t kNetNS = 4026531992;
+
+// A connection from 10.0.0.1:80 to 10.0.0.2, which uses the socket inode as remote port to tell connections apart.
+std::string TCPLine(ino_t inode) {
+  char line[256];
+  std::snprintf(line, sizeof(line),
+                "   0: 0100000A:0050 0200000A:%04X 01 00000000:00000000 00:00000000 00000000     0        0 %lu 1 0000000000000000 20 4 30 10 -1\n",
+                static_cast<unsigned int>(inode), static_cast<unsigned long>(inode));
+  return line;
+}
+
+// ConnScraperCacheTest scrapes a temporary `/proc`-like directory, so that fd tables can be changed between scrapes.
+class ConnScraperCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/ConnScraperTestXXXXXX";
+    ASSERT_NE(mkdtemp(path), nullptr);
+    proc_path_ = path;
+    scraper_ = std::make_unique<ConnScraper>(proc_path_);
+    CollectorStats::Reset();
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(proc_path_);
+  }
+
+  // AddProcess creates the proc entry of a container process in the given network namespace. fds maps each fd number
+  // to the socket inode it refers to, or to 0 for a regular file.
+  void AddProcess(int pid, const std::string& container_id, ino_t netns, const std::map<int, ino_t>& fds) {
+    std::string dir = PidDir(pid);
+    ASSERT_EQ(mkdir(dir.c_str(), 0755), 0);
+    ASSERT_EQ(mkdir((dir + "/ns").c_str(), 0755), 0);
+    ASSERT_EQ(mkdir((dir + "/fd").c_str(), 0755), 0);
+    ASSERT_EQ(mkdir((dir + "/net").c_str(), 0755), 0);
+    std::ofstream(dir + "/cgroup") << "5:pids:/docker/" << container_id << "\n";
+    ASSERT_EQ(symlink(("net:[" + std::to_string(netns) + "]").c_str(), (dir + "/ns/net").c_str()), 0);
+    for (const auto& fd : fds) {
+      SetFD(pid, fd.first, fd.second);
+    }
+    SetConnections(pid, {});
+  }
+
+  void RemoveProcess(int pid) {
+    std::filesystem::remove_all(PidDir(pid));
+  }
+
+  // SetFD points fd of the given process to a socket inode, or to a regular file if inode is 0.
+  void SetFD(int pid, int fd, ino_t inode) {
+    std::string link = PidDir(pid) + "/fd/" + std::to_string(fd);
+    std::string target = inode ? "socket:[" + std::to_string(inode) + "]" : "/dev/null";
+    unlink(link.c_str());
+    ASSERT_EQ(symlink(target.c_str(), link.c_str()), 0);
+  }
+
+  // SetConnections writes the established TCP connections of the network namespace of the given process.
+  void SetConnections(int pid, const std::vector<ino_t>& inodes) {
+    std::ofstream tcp(PidDir(pid) + "/net/tcp");
+    tcp << "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n";
+    for (ino_t inode : inodes) {
+      tcp << TCPLine(inode);
+    }
+    std::ofstream(PidDir(pid) + "/net/tcp6") << "  sl  local_address                         remote_address                        st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n";
+  }
+
+  // Scrape returns the scraped connections as a map from socket inode to the short id of their container. A
+  // connection attributed to several containers maps to all of them, separated by commas.
+  std::map<ino_t, std::string> Scrape() {
+    std::vector<Connection> conns;
+    std::vector<ContainerEndpoint> eps;
+    EXPECT_TRUE(scraper_->Scrape(&conns, &eps));
+
+    std::map<ino_t, std::string> containers_by_inode;
+    for (const auto& conn : conns) {
+      auto& containers = containers_by_inode[conn.remote().port()];
+      containers += (containers.empty() ? "" : ",") + conn.container();
+    }
+    return containers_by_inode;
+  }
+
+  static int64_t Counter(CollectorStats::CounterType index) {
+    return CollectorStats::GetOrCreate().GetCounter(index);
+  }
+
+  std::string PidDir(int pid) const {
+    return proc_path_ + "/" + std::to_string(pid);
+  }
+
+  std::string proc_path_;
+  std::unique_ptr<ConnScraper> scraper_;
+};
+
+TEST_F(ConnScraperCacheTest, ReusesSocketINodesOfUnchangedFDTables) {
+  AddProcess(100, kContainerA, kNetNS, {{0, 0}, {1, 0}, {3, 1001}});
+  SetConnections(100, {1001});
+
+  std::map<ino_t, std::string> expected = {{1001, "951e643e3c24"}};
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 0);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_readlink_calls), 3);
+
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_readlink_calls), 3);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 0);
+
+  // A new fd changes the fingerprint, and the fd table is resolved again.
+  SetFD(100, 4, 1002);
+  SetConnections(100, {1001, 1002});
+  expected[1002] = "951e643e3c24";
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 2);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_readlink_calls), 7);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 0);
+}
+
+TEST_F(ConnScraperCacheTest, FallsBackOnUnknownSocketINodes) {
+  AddProcess(100, kContainerA, kNetNS, {{0, 0}, {3, 1001}});
+  SetConnections(100, {1001});
+  Scrape();
+
+  // A socket replacing a regular file keeps the fingerprint, but its connection is not owned by any cached process.
+  SetFD(100, 0, 1002);
+  SetConnections(100, {1001, 1002});
+
+  std::map<ino_t, std::string> expected = {{1001, "951e643e3c24"}, {1002, "951e643e3c24"}};
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 2);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_readlink_calls), 4);
+
+  // The fd table resolved by the fallback is cached in turn.
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 2);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 2);
+}
+
+TEST_F(ConnScraperCacheTest, PrunesStaleSocketINodes) {
+  AddProcess(100, kContainerA, kNetNS, {{0, 0}, {3, 1001}});
+  SetConnections(100, {1001});
+  Scrape();
+
+  // The socket was handed over to a process of another container sharing the network namespace, and replaced by a
+  // new one with the same fd number.
+  SetFD(100, 3, 1002);
+  SetConnections(100, {1001, 1002});
+  AddProcess(200, kContainerB, kNetNS, {{0, 0}, {3, 1001}});
+  SetConnections(200, {1001, 1002});
+
+  std::map<ino_t, std::string> expected = {{1001, "e73c55f3e7f5"}, {1002, "951e643e3c24"}};
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 3);
+
+  // Processes which exited are dropped from the cache.
+  RemoveProcess(200);
+  SetConnections(100, {1002});
+  EXPECT_EQ(Scrape(), (std::map<ino_t, std::string>{{1002, "951e643e3c24"}}));
+  AddProcess(200, kContainerB, kNetNS, {{0, 0}, {3, 1001}});
+  SetConnections(100, {1001, 1002});
+  SetConnections(200, {1001, 1002});
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 3);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 4);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 1);
+}
+
+TEST_F(ConnScraperCacheTest, DetectsReusedPids) {
+  AddProcess(100, kContainerA, kNetNS, {{0, 0}, {3, 1001}});
+  SetConnections(100, {1001});
+  Scrape();
+
+  // The pid is reused by a process of another container, in another network namespace, whose fd table has the same
+  // fingerprint.
+  RemoveProcess(100);
+  AddProcess(100, kContainerB, kNetNS + 1, {{0, 0}, {3, 2001}});
+  SetConnections(100, {2001});
+
+  std::map<ino_t, std::string> expected = {{2001, "e73c55f3e7f5"}};
+  EXPECT_EQ(Scrape(), expected);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_skipped), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_cache_fallbacks), 1);
+  EXPECT_EQ(Counter(CollectorStats::procfs_fd_walks_full), 2);
+}
+
 }  // namespace
 
 }  // namespace collector
@@ -90,6 +90,28 @@ TEST(ConnTrackerTest, TestUpdate) {
   EXPECT_THAT(state, UnorderedElementsAre(std::make_pair(conn1, ConnStatus(time_micros2, true))));
 }
 
+TEST(ConnTrackerTest, TestUpdateCountsMissedConnections) {
+  Endpoint a(Address(192, 168, 0, 1), 80);
+  Endpoint b(Address(192, 168, 1, 10), 9999);
+  Endpoint c(Address(192, 168, 1, 11), 9999);
+
+  Connection conn1("xyz", a, b, L4Proto::TCP, true);
+  Connection conn2("xyz", a, c, L4Proto::TCP, true);
+
+  ConnectionTracker tracker;
+  tracker.AddConnection(conn1, 1000);
+
+  // conn2 was never reported by the event stream
+  EXPECT_EQ(tracker.Update({conn1, conn2}, {}, 1005), 1);
+
+  // both connections are active after the scrape
+  EXPECT_EQ(tracker.Update({conn1, conn2}, {}, 1010), 0);
+
+  // conn1 was reported closed, but is still found by the scrape
+  tracker.RemoveConnection(conn1, 1015);
+  EXPECT_EQ(tracker.Update({conn1, conn2}, {}, 1020), 1);
+}
+
 TEST(ConnTrackerTest, TestUpdateIgnoredL4ProtoPortPairs) {
   Endpoint a(Address(192, 168, 0, 1), 80);
   Endpoint b(Address(192, 168, 1, 10), 9999);
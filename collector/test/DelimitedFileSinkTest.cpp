@@ -0,0 +1,148 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include "internalapi/sensor/signal_iservice.pb.h"
+
+#include "CollectorStats.h"
+#include "DelimitedFileSink.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using SignalStreamMessage = sensor::SignalStreamMessage;
+
+SignalStreamMessage MakeSignal(const std::string& id, size_t args_length = 0) {
+  SignalStreamMessage msg;
+  auto* signal = msg.mutable_signal()->mutable_process_signal();
+  signal->set_id(id);
+  signal->set_args(std::string(args_length, 'a'));
+  return msg;
+}
+
+class DelimitedFileSinkTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/DelimitedFileSinkTestXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    path_ = path;
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+  }
+
+  std::vector<SignalStreamMessage> ReadAll() {
+    std::vector<SignalStreamMessage> msgs;
+    FDHandle fd(open(path_.c_str(), O_RDONLY));
+    EXPECT_TRUE(fd.valid());
+    google::protobuf::io::FileInputStream input(fd.get());
+    SignalStreamMessage msg;
+    bool clean_eof = false;
+    while (google::protobuf::util::ParseDelimitedFromZeroCopyStream(&msg, &input, &clean_eof)) {
+      msgs.push_back(msg);
+    }
+    EXPECT_TRUE(clean_eof);
+    return msgs;
+  }
+
+  std::string path_;
+};
+
+TEST_F(DelimitedFileSinkTest, TestRoundTrip) {
+  CollectorStats::Reset();
+  auto sink = DelimitedFileSink::Open(path_);
+  ASSERT_NE(sink, nullptr);
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(sink->Write(MakeSignal(std::to_string(i), i)));
+  }
+  // Buffered until flushed.
+  EXPECT_TRUE(ReadAll().empty());
+  ASSERT_TRUE(sink->Flush());
+
+  auto msgs = ReadAll();
+  ASSERT_EQ(msgs.size(), 100);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(msgs[i].signal().process_signal().id(), std::to_string(i));
+    EXPECT_EQ(msgs[i].signal().process_signal().args().size(), i);
+  }
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::file_sink_records), 100);
+}
+
+TEST_F(DelimitedFileSinkTest, TestRecordsLargerThanBuffer) {
+  {
+    auto sink = DelimitedFileSink::Open(path_, 64);
+    ASSERT_NE(sink, nullptr);
+    ASSERT_TRUE(sink->Write(MakeSignal("small")));
+    ASSERT_TRUE(sink->Write(MakeSignal("large", 1000)));
+    ASSERT_TRUE(sink->Write(MakeSignal("small again")));
+    // Flushed on destruction.
+  }
+
+  auto msgs = ReadAll();
+  ASSERT_EQ(msgs.size(), 3);
+  EXPECT_EQ(msgs[0].signal().process_signal().id(), "small");
+  EXPECT_EQ(msgs[1].signal().process_signal().args().size(), 1000);
+  EXPECT_EQ(msgs[2].signal().process_signal().id(), "small again");
+}
+
+TEST_F(DelimitedFileSinkTest, TestAppends) {
+  DelimitedFileSink::Open(path_)->Write(MakeSignal("first"));
+  DelimitedFileSink::Open(path_)->Write(MakeSignal("second"));
+
+  auto msgs = ReadAll();
+  ASSERT_EQ(msgs.size(), 2);
+  EXPECT_EQ(msgs[1].signal().process_signal().id(), "second");
+}
+
+TEST_F(DelimitedFileSinkTest, TestFlushedWhenIdle) {
+  auto sink = DelimitedFileSink::Open(path_);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_TRUE(sink->Write(MakeSignal("idle")));
+  EXPECT_TRUE(ReadAll().empty());
+
+  // No more writes, the record is flushed by the background thread.
+  std::this_thread::sleep_for(DelimitedFileSink::kFlushInterval + std::chrono::milliseconds(500));
+  auto msgs = ReadAll();
+  ASSERT_EQ(msgs.size(), 1);
+  EXPECT_EQ(msgs[0].signal().process_signal().id(), "idle");
+}
+
+TEST_F(DelimitedFileSinkTest, TestReaderGone) {
+  CollectorStats::Reset();
+  // As in collector.
+  signal(SIGPIPE, SIG_IGN);
+  unlink(path_.c_str());
+  ASSERT_EQ(mkfifo(path_.c_str(), 0600), 0);
+
+  FDHandle reader(open(path_.c_str(), O_RDONLY | O_NONBLOCK));
+  ASSERT_TRUE(reader.valid());
+  auto sink = DelimitedFileSink::Open(path_);
+  ASSERT_NE(sink, nullptr);
+  reader.close();
+
+  ASSERT_TRUE(sink->Write(MakeSignal("lost")));
+  EXPECT_FALSE(sink->Flush());
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::file_sink_errors), 1);
+}
+
+TEST(DelimitedFileSinkOpenTest, TestOpenFailure) {
+  EXPECT_EQ(DelimitedFileSink::Open("/nonexistent/signals.bin"), nullptr);
+}
+
+}  // namespace
+
+}  // namespace collector
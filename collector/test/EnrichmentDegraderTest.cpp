@@ -0,0 +1,72 @@
+#include "CollectorStats.h"
+#include "EnrichmentDegrader.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+int Feed(EnrichmentDegrader& degrader, int windows, std::chrono::microseconds lag) {
+  int tier = degrader.Tier();
+  for (int i = 0; i < windows; i++) {
+    tier = degrader.Update(lag);
+  }
+  return tier;
+}
+
+TEST(EnrichmentDegraderTest, TestEscalatesOnSustainedLag) {
+  CollectorStats::Reset();
+  EnrichmentDegrader degrader;
+
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kSustainedWindows - 1, 2s), EnrichmentDegrader::kFull);
+  EXPECT_EQ(Feed(degrader, 1, 2s), EnrichmentDegrader::kParentLineage);
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kSustainedWindows, 2s), EnrichmentDegrader::kTruncatedArgs);
+  EXPECT_EQ(Feed(degrader, 10 * EnrichmentDegrader::kSustainedWindows, 2s), EnrichmentDegrader::kMinimal);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::enrichment_tier), EnrichmentDegrader::kMinimal);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::enrichment_escalations), 3);
+}
+
+TEST(EnrichmentDegraderTest, TestIgnoresIsolatedLag) {
+  EnrichmentDegrader degrader;
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kSustainedWindows - 1, 2s), EnrichmentDegrader::kFull);
+    EXPECT_EQ(Feed(degrader, 1, 0us), EnrichmentDegrader::kFull);
+  }
+}
+
+TEST(EnrichmentDegraderTest, TestRecoversOneTierAtATime) {
+  CollectorStats::Reset();
+  EnrichmentDegrader degrader;
+  Feed(degrader, 3 * EnrichmentDegrader::kSustainedWindows, 2s);
+  ASSERT_EQ(degrader.Tier(), EnrichmentDegrader::kMinimal);
+
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kRecoveryWindows - 1, 0us), EnrichmentDegrader::kMinimal);
+  EXPECT_EQ(Feed(degrader, 1, 0us), EnrichmentDegrader::kTruncatedArgs);
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kRecoveryWindows, 0us), EnrichmentDegrader::kParentLineage);
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kRecoveryWindows, 0us), EnrichmentDegrader::kFull);
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kRecoveryWindows, 0us), EnrichmentDegrader::kFull);
+
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::enrichment_recoveries), 3);
+}
+
+TEST(EnrichmentDegraderTest, TestModerateLagHoldsTier) {
+  EnrichmentDegrader degrader;
+  Feed(degrader, EnrichmentDegrader::kSustainedWindows, 2s);
+  ASSERT_EQ(degrader.Tier(), EnrichmentDegrader::kParentLineage);
+
+  // Between the thresholds, neither lagging nor calm.
+  EXPECT_EQ(Feed(degrader, 5 * EnrichmentDegrader::kRecoveryWindows, 500ms), EnrichmentDegrader::kParentLineage);
+  // Calm windows must be consecutive.
+  Feed(degrader, EnrichmentDegrader::kRecoveryWindows - 1, 0us);
+  Feed(degrader, 1, 500ms);
+  EXPECT_EQ(Feed(degrader, EnrichmentDegrader::kRecoveryWindows - 1, 0us), EnrichmentDegrader::kParentLineage);
+}
+
+}  // namespace
+
+}  // namespace collector
@@ -0,0 +1,47 @@
+#include "EventStats.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+TEST(EventStatsTest, TestSamplerRate) {
+  EXPECT_EQ(EventTimingSampler(0).Rate(), 1);
+  EXPECT_EQ(EventTimingSampler(1).Rate(), 1);
+  EXPECT_EQ(EventTimingSampler(48).Rate(), 64);
+  EXPECT_EQ(EventTimingSampler(64).Rate(), 64);
+}
+
+TEST(EventStatsTest, TestSamplerSamplesOneInRate) {
+  EventTimingSampler every_event(1);
+  EventTimingSampler sampler(16);
+
+  int sampled = 0;
+  for (int i = 0; i < 1600; i++) {
+    EXPECT_TRUE(every_event.Sample());
+    if (sampler.Sample()) sampled++;
+  }
+  EXPECT_EQ(sampled, 100);
+}
+
+TEST(EventStatsTest, TestScaledMicros) {
+  EXPECT_EQ(EventTimingSampler(1).ScaledMicros(2500), 2);
+  EXPECT_EQ(EventTimingSampler(64).ScaledMicros(2500), 160);
+}
+
+TEST(EventStatsTest, TestCounters) {
+  EventCounters counters;
+  EventCounters::Add(counters[3].userspace, 1);
+  EventCounters::Add(counters[3].userspace, 1);
+  EventCounters::Add(counters[3].process_micros, 42);
+
+  EXPECT_EQ(counters[3].userspace.load(), 2);
+  EXPECT_EQ(counters[3].process_micros.load(), 42);
+  EXPECT_EQ(counters[3].filtered.load(), 0);
+  EXPECT_EQ(counters[4].userspace.load(), 0);
+  EXPECT_EQ(sizeof(EventCounters::Counters), 32);
+}
+
+}  // namespace
+
+}  // namespace collector
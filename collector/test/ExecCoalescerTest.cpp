@@ -0,0 +1,90 @@
+#include "CollectorStats.h"
+#include "ExecCoalescer.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+constexpr uint64_t kWindow = 1000;
+
+const Hash128 kKey{1, 2};
+const Hash128 kOtherKey{3, 4};
+
+TEST(ExecCoalescerTest, TestFirstExecNotCoalesced) {
+  ExecCoalescer coalescer(kWindow);
+
+  EXPECT_EQ(coalescer.Coalesce(kKey, 100), nullptr);
+  coalescer.Open(kKey, 100);
+  EXPECT_EQ(coalescer.Size(), 1);
+
+  ExecCoalescer::Summary summary;
+  EXPECT_FALSE(coalescer.NextSummary(100, &summary));
+}
+
+TEST(ExecCoalescerTest, TestSummary) {
+  CollectorStats::Reset();
+  ExecCoalescer coalescer(kWindow);
+
+  coalescer.Open(kKey, 100);
+  for (uint64_t ts = 200; ts < 1100; ts += 100) {
+    ExecCoalescer::Summary* summary = coalescer.Coalesce(kKey, ts);
+    ASSERT_NE(summary, nullptr);
+    if (summary->count == 1) {
+      summary->signal_msg.mutable_signal()->mutable_process_signal()->set_exec_file_path("/bin/true");
+    }
+  }
+
+  ExecCoalescer::Summary summary;
+  EXPECT_FALSE(coalescer.NextSummary(1099, &summary));
+
+  // The window has ended, the next exec is sent and opens a new window.
+  EXPECT_EQ(coalescer.Coalesce(kKey, 1100), nullptr);
+  ASSERT_TRUE(coalescer.NextSummary(1100, &summary));
+  EXPECT_EQ(summary.count, 9);
+  EXPECT_EQ(summary.first_ts, 100);
+  EXPECT_EQ(summary.last_ts, 1000);
+  EXPECT_EQ(summary.signal_msg.signal().process_signal().exec_file_path(), "/bin/true");
+  EXPECT_FALSE(coalescer.NextSummary(1100, &summary));
+
+  EXPECT_EQ(coalescer.Size(), 0);
+  coalescer.Open(kKey, 1100);
+  EXPECT_NE(coalescer.Coalesce(kKey, 1200), nullptr);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_exec_coalesced), 10);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_exec_summaries), 1);
+}
+
+TEST(ExecCoalescerTest, TestKeysAreIndependent) {
+  ExecCoalescer coalescer(kWindow);
+
+  coalescer.Open(kKey, 100);
+  EXPECT_EQ(coalescer.Coalesce(kOtherKey, 200), nullptr);
+  coalescer.Open(kOtherKey, 200);
+  EXPECT_NE(coalescer.Coalesce(kOtherKey, 300), nullptr);
+
+  // The window of the first key ends first, without a summary as nothing was coalesced.
+  ExecCoalescer::Summary summary;
+  EXPECT_FALSE(coalescer.NextSummary(1100, &summary));
+  EXPECT_EQ(coalescer.Size(), 1);
+
+  ASSERT_TRUE(coalescer.NextSummary(1200, &summary));
+  EXPECT_EQ(summary.count, 1);
+  EXPECT_EQ(summary.first_ts, 200);
+  EXPECT_EQ(summary.last_ts, 300);
+}
+
+TEST(ExecCoalescerTest, TestBounded) {
+  ExecCoalescer coalescer(kWindow, 1);
+
+  coalescer.Open(kKey, 100);
+  coalescer.Open(kOtherKey, 100);
+  EXPECT_EQ(coalescer.Size(), 1);
+  EXPECT_NE(coalescer.Coalesce(kKey, 200), nullptr);
+  EXPECT_EQ(coalescer.Coalesce(kOtherKey, 200), nullptr);
+}
+
+}  // namespace
+
+}  // namespace collector
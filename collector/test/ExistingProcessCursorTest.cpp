@@ -0,0 +1,84 @@
+#include "CollectorStats.h"
+#include "ExistingProcessCursor.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+SignalHandler* const kHandler = reinterpret_cast<SignalHandler*>(0x1);
+
+TEST(ExistingProcessCursorTest, TestBatches) {
+  ExistingProcessCursor cursor(2);
+  std::vector<int64_t> batch;
+
+  EXPECT_FALSE(cursor.Active());
+  cursor.NextBatch(0, &batch);
+  EXPECT_TRUE(batch.empty());
+
+  cursor.Start(kHandler, {1, 2, 3, 4, 5}, 0);
+  EXPECT_TRUE(cursor.Active());
+  EXPECT_EQ(cursor.Handler(), kHandler);
+  EXPECT_EQ(cursor.Remaining(), 5);
+
+  cursor.NextBatch(0, &batch);
+  EXPECT_EQ(batch, std::vector<int64_t>({1, 2}));
+  cursor.NextBatch(0, &batch);
+  EXPECT_EQ(batch, std::vector<int64_t>({3, 4}));
+  EXPECT_TRUE(cursor.Active());
+  cursor.NextBatch(0, &batch);
+  EXPECT_EQ(batch, std::vector<int64_t>({5}));
+
+  EXPECT_FALSE(cursor.Active());
+  EXPECT_EQ(cursor.Remaining(), 0);
+}
+
+TEST(ExistingProcessCursorTest, TestRate) {
+  CollectorStats::Reset();
+  // 10 processes per second, 4 at most at once.
+  ExistingProcessCursor cursor(4, 10);
+  std::vector<int64_t> batch;
+
+  cursor.Start(kHandler, {1, 2, 3, 4, 5, 6, 7, 8}, 1000000);
+
+  cursor.NextBatch(1000000, &batch);
+  EXPECT_EQ(batch.size(), 4);
+  cursor.NextBatch(1000000, &batch);
+  EXPECT_TRUE(batch.empty());
+
+  // 100ms later, one more process may be sent.
+  cursor.NextBatch(1100000, &batch);
+  EXPECT_EQ(batch, std::vector<int64_t>({5}));
+  cursor.NextBatch(1150000, &batch);
+  EXPECT_TRUE(batch.empty());
+
+  // Time not used to send is not lost, but batches stay bounded.
+  cursor.NextBatch(2000000, &batch);
+  EXPECT_EQ(batch, std::vector<int64_t>({6, 7, 8}));
+  EXPECT_FALSE(cursor.Active());
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_existing_resent), 8);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_existing_remaining), 0);
+}
+
+TEST(ExistingProcessCursorTest, TestRestart) {
+  ExistingProcessCursor cursor(2);
+  std::vector<int64_t> batch;
+
+  cursor.Start(kHandler, {1, 2, 3}, 0);
+  cursor.NextBatch(0, &batch);
+
+  cursor.Start(kHandler, {7, 8, 9}, 0);
+  cursor.NextBatch(0, &batch);
+  EXPECT_EQ(batch, std::vector<int64_t>({7, 8}));
+
+  cursor.Stop();
+  EXPECT_FALSE(cursor.Active());
+  cursor.NextBatch(0, &batch);
+  EXPECT_TRUE(batch.empty());
+}
+
+}  // namespace
+
+}  // namespace collector
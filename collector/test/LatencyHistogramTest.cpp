@@ -0,0 +1,69 @@
+#include "CollectorStats.h"
+#include "LatencyHistogram.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+TEST(LatencyHistogramTest, TestBuckets) {
+  EXPECT_EQ(LatencyHistogram::BucketOf(-5), 0);
+  EXPECT_EQ(LatencyHistogram::BucketOf(0), 0);
+  EXPECT_EQ(LatencyHistogram::BucketOf(1), 0);
+  EXPECT_EQ(LatencyHistogram::BucketOf(2), 1);
+  EXPECT_EQ(LatencyHistogram::BucketOf(3), 2);
+  EXPECT_EQ(LatencyHistogram::BucketOf(4), 2);
+  EXPECT_EQ(LatencyHistogram::BucketOf(5), 3);
+  EXPECT_EQ(LatencyHistogram::BucketOf(1 << 24), 24);
+  EXPECT_EQ(LatencyHistogram::BucketOf((1 << 24) + 1), LatencyHistogram::kNumBounds);
+  EXPECT_EQ(LatencyHistogram::BucketOf(INT64_MAX), LatencyHistogram::kNumBounds);
+
+  auto bounds = LatencyHistogram::Bounds();
+  ASSERT_EQ(bounds.size(), LatencyHistogram::kNumBounds);
+  EXPECT_EQ(bounds.front(), 1);
+  EXPECT_EQ(bounds.back(), 1 << 24);
+  // Every duration falls in the first bucket whose bound is not lower.
+  for (int64_t micros : {1, 2, 3, 1000, 1024, 1025, 999999}) {
+    size_t bucket = LatencyHistogram::BucketOf(micros);
+    EXPECT_LE(micros, bounds[bucket]);
+    if (bucket > 0) {
+      EXPECT_GT(micros, bounds[bucket - 1]);
+    }
+  }
+}
+
+TEST(LatencyHistogramTest, TestRecord) {
+  LatencyHistogram histogram;
+  histogram.Record(3);
+  histogram.Record(100, 64);
+  histogram.Record(-1);
+
+  LatencyHistogram::Snapshot snapshot;
+  histogram.Read(&snapshot);
+  EXPECT_EQ(snapshot.counts[0], 1);
+  EXPECT_EQ(snapshot.counts[2], 1);
+  EXPECT_EQ(snapshot.counts[7], 64);
+  EXPECT_EQ(snapshot.sum_micros, 3 + 100 * 64);
+
+  histogram.Reset();
+  histogram.Read(&snapshot);
+  EXPECT_EQ(snapshot.counts[7], 0);
+  EXPECT_EQ(snapshot.sum_micros, 0);
+}
+
+TEST(LatencyHistogramTest, TestCollectorStats) {
+  CollectorStats::Reset();
+  HISTOGRAM_RECORD(CollectorStats::process_signal_write, 10);
+
+  LatencyHistogram::Snapshot snapshot;
+  CollectorStats::GetOrCreate().GetHistogram(CollectorStats::process_signal_write).Read(&snapshot);
+  EXPECT_EQ(snapshot.counts[4], 1);
+
+  CollectorStats::Reset();
+  CollectorStats::GetOrCreate().GetHistogram(CollectorStats::process_signal_write).Read(&snapshot);
+  EXPECT_EQ(snapshot.counts[4], 0);
+}
+
+}  // namespace
+
+}  // namespace collector
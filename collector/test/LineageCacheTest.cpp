@@ -0,0 +1,121 @@
+#include "CollectorStats.h"
+#include "LineageCache.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+LineageCache::Lineage MakeLineage(std::vector<std::string> paths) {
+  LineageCache::Lineage lineage;
+  for (auto& path : paths) {
+    lineage.string_length += path.size();
+    lineage.ancestors.push_back({std::move(path), 0});
+  }
+  return lineage;
+}
+
+TEST(LineageCacheTest, TestFind) {
+  CollectorStats::Reset();
+  LineageCache cache;
+  LineageCache::Key parent{10, 100, 200};
+
+  EXPECT_EQ(cache.Find(parent), nullptr);
+  cache.Insert(parent, MakeLineage({"/bin/sh", "/usr/bin/init"}), {10, 1});
+
+  const auto* lineage = cache.Find(parent);
+  ASSERT_NE(lineage, nullptr);
+  ASSERT_EQ(lineage->ancestors.size(), 2);
+  EXPECT_EQ(lineage->ancestors[0].exec_file_path, "/bin/sh");
+  EXPECT_EQ(lineage->ancestors[1].exec_file_path, "/usr/bin/init");
+  EXPECT_EQ(lineage->string_length, 20);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_lineage_cache_misses), 1);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_lineage_cache_hits), 1);
+}
+
+TEST(LineageCacheTest, TestStaleParent) {
+  LineageCache cache;
+  cache.Insert({10, 100, 200}, MakeLineage({"/bin/sh"}), {10});
+
+  // The thread ID was reused, or the parent exec'd without the cache being told.
+  EXPECT_EQ(cache.Find({10, 101, 200}), nullptr);
+  EXPECT_EQ(cache.Find({10, 100, 201}), nullptr);
+
+  cache.Insert({10, 100, 201}, MakeLineage({"/bin/bash"}), {10});
+  EXPECT_EQ(cache.Size(), 1);
+  ASSERT_NE(cache.Find({10, 100, 201}), nullptr);
+  EXPECT_EQ(cache.Find({10, 100, 201})->ancestors[0].exec_file_path, "/bin/bash");
+}
+
+TEST(LineageCacheTest, TestInvalidate) {
+  LineageCache cache;
+  // 30 is a child of 20, itself a child of 10.
+  cache.Insert({10, 0, 0}, MakeLineage({"/usr/bin/init"}), {10});
+  cache.Insert({20, 0, 0}, MakeLineage({"/bin/sh", "/usr/bin/init"}), {20, 10});
+  cache.Insert({30, 0, 0}, MakeLineage({"/bin/sleep", "/bin/sh", "/usr/bin/init"}), {30, 20, 10});
+  EXPECT_EQ(cache.Size(), 3);
+
+  cache.Invalidate(20);
+  EXPECT_NE(cache.Find({10, 0, 0}), nullptr);
+  EXPECT_EQ(cache.Find({20, 0, 0}), nullptr);
+  EXPECT_EQ(cache.Find({30, 0, 0}), nullptr);
+  EXPECT_EQ(cache.Size(), 1);
+
+  cache.Invalidate(42);
+  EXPECT_EQ(cache.Size(), 1);
+
+  cache.Invalidate(10);
+  EXPECT_EQ(cache.Size(), 0);
+}
+
+TEST(LineageCacheTest, TestInvalidateAfterReplace) {
+  LineageCache cache;
+  cache.Insert({20, 0, 0}, MakeLineage({"/bin/sh", "/usr/bin/init"}), {20, 10});
+  // The parent of 20 exited, 20 was reparented to 1.
+  cache.Insert({20, 0, 0}, MakeLineage({"/bin/sh"}), {20, 1});
+
+  cache.Invalidate(10);
+  EXPECT_NE(cache.Find({20, 0, 0}), nullptr);
+
+  cache.Invalidate(1);
+  EXPECT_EQ(cache.Find({20, 0, 0}), nullptr);
+}
+
+TEST(LineageCacheTest, TestClear) {
+  LineageCache cache;
+  cache.Insert({10, 0, 0}, MakeLineage({"/bin/sh"}), {10, 1});
+  cache.Clear();
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.Find({10, 0, 0}), nullptr);
+
+  // Nothing is left to invalidate.
+  cache.Insert({20, 0, 0}, MakeLineage({"/bin/sh"}), {20, 1});
+  cache.Invalidate(10);
+  EXPECT_EQ(cache.Size(), 1);
+}
+
+TEST(LineageCacheTest, TestBounded) {
+  CollectorStats::Reset();
+  LineageCache cache(2);
+
+  cache.Insert({1, 0, 0}, MakeLineage({"/a"}), {1});
+  cache.Insert({2, 0, 0}, MakeLineage({"/b"}), {2});
+  EXPECT_EQ(cache.Size(), 2);
+
+  cache.Insert({3, 0, 0}, MakeLineage({"/c"}), {3});
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_NE(cache.Find({3, 0, 0}), nullptr);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_lineage_cache_flushes), 1);
+
+  // Entries dropped by the flush are not invalidated again.
+  cache.Invalidate(1);
+  EXPECT_EQ(cache.Size(), 1);
+}
+
+}  // namespace
+
+}  // namespace collector
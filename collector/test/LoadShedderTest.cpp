@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "CollectorStats.h"
+#include "LoadShedder.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Feeds windows of 1000 events with the given number of drops, starting from the given cumulative counts.
+int Feed(LoadShedder& shedder, uint64_t* events, uint64_t* drops, int windows, uint64_t window_drops,
+         std::chrono::microseconds lag = 0us) {
+  int level = shedder.Level();
+  for (int i = 0; i < windows; i++) {
+    *events += 1000;
+    *drops += window_drops;
+    level = shedder.Update(*events, *drops, lag);
+  }
+  return level;
+}
+
+TEST(LoadShedderTest, TestSyscallsShedAt) {
+  EXPECT_TRUE(LoadShedder::SyscallsShedAt(0).empty());
+  EXPECT_EQ(LoadShedder::SyscallsShedAt(1), std::vector<std::string>({"chdir", "fchdir"}));
+
+  auto all = LoadShedder::SyscallsShedAt(LoadShedder::MaxLevel());
+  EXPECT_EQ(all, LoadShedder::SyscallsShedAt(LoadShedder::MaxLevel() + 1));
+  for (const char* kept : {"connect", "accept", "close", "execve"}) {
+    EXPECT_EQ(std::find(all.begin(), all.end(), kept), all.end()) << kept;
+  }
+}
+
+TEST(LoadShedderTest, TestShedsUidChanges) {
+  EXPECT_FALSE(LoadShedder::ShedsUidChanges(0));
+  EXPECT_FALSE(LoadShedder::ShedsUidChanges(1));
+  EXPECT_TRUE(LoadShedder::ShedsUidChanges(LoadShedder::MaxLevel()));
+}
+
+TEST(LoadShedderTest, TestEscalatesOnSustainedDrops) {
+  CollectorStats::Reset();
+  LoadShedder shedder;
+  uint64_t events = 0, drops = 0;
+  shedder.Update(events, drops, 0us);
+
+  // A single bad window is not enough.
+  EXPECT_EQ(Feed(shedder, &events, &drops, 1, 100), 0);
+  EXPECT_EQ(Feed(shedder, &events, &drops, 1, 0), 0);
+
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kSustainedWindows, 100), 1);
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kSustainedWindows, 100), 2);
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kSustainedWindows, 100), LoadShedder::MaxLevel());
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::syscall_shedding_level), LoadShedder::MaxLevel());
+  EXPECT_EQ(stats.GetCounter(CollectorStats::syscall_shedding_escalations), LoadShedder::MaxLevel());
+}
+
+TEST(LoadShedderTest, TestEscalatesOnLag) {
+  LoadShedder shedder;
+  uint64_t events = 0, drops = 0;
+  shedder.Update(events, drops, 0us);
+
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kSustainedWindows, 0, LoadShedder::kMaxLag), 1);
+}
+
+TEST(LoadShedderTest, TestRecoversWhenCalm) {
+  CollectorStats::Reset();
+  LoadShedder shedder;
+  uint64_t events = 0, drops = 0;
+  shedder.Update(events, drops, 0us);
+
+  EXPECT_EQ(Feed(shedder, &events, &drops, 2 * LoadShedder::kSustainedWindows, 100), 2);
+
+  // Moderate drops neither escalate nor let the load be considered gone.
+  EXPECT_EQ(Feed(shedder, &events, &drops, 2 * LoadShedder::kRecoveryWindows, 5), 2);
+
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kRecoveryWindows - 1, 0), 2);
+  EXPECT_EQ(Feed(shedder, &events, &drops, 1, 0), 1);
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kRecoveryWindows, 0), 0);
+  EXPECT_EQ(Feed(shedder, &events, &drops, LoadShedder::kRecoveryWindows, 0), 0);
+
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::syscall_shedding_recoveries), 2);
+}
+
+TEST(LoadShedderTest, TestCountersReset) {
+  LoadShedder shedder;
+  shedder.Update(1000000, 1000, 0us);
+
+  // The capture was reopened, the counts restarted.
+  EXPECT_EQ(shedder.Update(10, 0, 0us), 0);
+  EXPECT_EQ(shedder.Update(1010, 100, 0us), 0);
+}
+
+}  // namespace
+
+}  // namespace collector
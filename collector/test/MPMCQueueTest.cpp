@@ -0,0 +1,115 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "MPMCQueue.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+TEST(MPMCQueueTest, TestCapacity) {
+  MPMCQueue<int> queue(5);
+  EXPECT_EQ(queue.Capacity(), 8);
+
+  for (int i = 0; i < 8; i++) {
+    EXPECT_TRUE(queue.TryPush(int(i)));
+  }
+  EXPECT_FALSE(queue.TryPush(8));
+  EXPECT_EQ(queue.Size(), 8);
+
+  int item;
+  ASSERT_TRUE(queue.TryPop(&item));
+  EXPECT_EQ(item, 0);
+  EXPECT_TRUE(queue.TryPush(8));
+
+  for (int i = 1; i <= 8; i++) {
+    ASSERT_TRUE(queue.TryPop(&item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_FALSE(queue.TryPop(&item));
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST(MPMCQueueTest, TestConcurrentProducers) {
+  constexpr int kProducers = 4;
+  constexpr int kItemsPerProducer = 50000;
+  MPMCQueue<int> queue(64);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kItemsPerProducer; i++) {
+        while (!queue.TryPush(p * kItemsPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Items of each producer are received in the order they were pushed, and none is lost.
+  std::vector<int> next(kProducers, 0);
+  int item;
+  for (int received = 0; received < kProducers * kItemsPerProducer;) {
+    if (!queue.TryPop(&item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    int p = item / kItemsPerProducer;
+    ASSERT_EQ(item % kItemsPerProducer, next[p]);
+    next[p]++;
+    received++;
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST(MPMCQueueTest, TestDropOldest) {
+  // Producers making room by popping, as the drop-oldest overflow policy does, never lose track of items:
+  // every item is either popped by the consumer or discarded by a producer.
+  constexpr int kProducers = 4;
+  constexpr int kItemsPerProducer = 20000;
+  MPMCQueue<int> queue(16);
+  std::atomic<int> discarded{0};
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&] {
+      int oldest;
+      for (int i = 0; i < kItemsPerProducer; i++) {
+        while (!queue.TryPush(int(i))) {
+          if (queue.TryPop(&oldest)) {
+            discarded++;
+          }
+        }
+      }
+    });
+  }
+
+  int consumed = 0;
+  std::thread consumer([&] {
+    int item;
+    while (!done || queue.Size() > 0) {
+      if (queue.TryPop(&item)) {
+        consumed++;
+      }
+    }
+  });
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  done = true;
+  consumer.join();
+
+  EXPECT_EQ(consumed + discarded, kProducers * kItemsPerProducer);
+}
+
+}  // namespace
+
+}  // namespace collector
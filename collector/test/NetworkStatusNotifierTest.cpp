@@ -72,6 +72,10 @@ class MockCollectorConfig : public collector::CollectorConfig {
   void DisableAfterglow() {
     enable_afterglow_ = false;
   }
+
+  void SetNetworkMessageMaxEntries(int max_entries) {
+    network_message_max_entries_ = max_entries;
+  }
 };
 
 class MockConnScraper : public IConnScraper {
@@ -83,6 +87,7 @@ class MockDuplexClientWriter : public IDuplexClientWriter<sensor::NetworkConnect
  public:
   MOCK_METHOD(grpc_duplex_impl::Result, Write, (const sensor::NetworkConnectionInfoMessage& obj, const gpr_timespec& deadline), (override));
   MOCK_METHOD(grpc_duplex_impl::Result, WriteAsync, (const sensor::NetworkConnectionInfoMessage& obj), (override));
+  MOCK_METHOD(grpc_duplex_impl::Result, WaitUntilWritable, (const gpr_timespec& deadline), (override));
   MOCK_METHOD(grpc_duplex_impl::Result, WaitUntilStarted, (const gpr_timespec& deadline), (override));
   MOCK_METHOD(bool, Sleep, (const gpr_timespec& deadline), (override));
   MOCK_METHOD(grpc_duplex_impl::Result, WritesDoneAsync, (), (override));
@@ -334,6 +339,74 @@ TEST(NetworkStatusNotifier, UpdateIPnoAfterglow) {
   net_status_notifier->Stop();
 }
 
+/* A delta larger than the maximum number of entries per message is split into several messages. All but the last
+   one are written asynchronously, each one after the previous write completed. */
+TEST(NetworkStatusNotifier, ChunkedDelta) {
+  bool running = true;
+  MockCollectorConfig config;
+  config.SetNetworkMessageMaxEntries(2);
+  std::shared_ptr<MockConnScraper> conn_scraper = std::make_shared<MockConnScraper>();
+  auto conn_tracker = std::make_shared<ConnectionTracker>();
+  auto comm = std::make_shared<MockNetworkConnectionInfoServiceComm>();
+  Semaphore sem(0);
+
+  std::vector<Connection> conns;
+  for (int i = 0; i < 5; i++) {
+    conns.emplace_back("containerId", Endpoint(Address(10, 0, 1, 32), 1024 + i), Endpoint(Address(10, 0, 2, 4), 80), L4Proto::TCP, true);
+  }
+  std::vector<size_t> message_sizes;
+  std::unordered_map<Connection, bool, Hasher> sent;
+
+  EXPECT_CALL(*comm, WaitForConnectionReady).WillRepeatedly(Return(true));
+  EXPECT_CALL(*comm, TryCancel).Times(1).WillOnce([&running] { running = false; });
+
+  EXPECT_CALL(*comm, PushNetworkConnectionInfoOpenStream)
+      .Times(1)
+      .WillOnce([&](std::function<void(const sensor::NetworkFlowsControlMessage*)> receive_func) -> std::unique_ptr<IDuplexClientWriter<sensor::NetworkConnectionInfoMessage>> {
+        auto duplex_writer = MakeUnique<MockDuplexClientWriter>();
+        auto record = [&](const sensor::NetworkConnectionInfoMessage& msg) {
+          message_sizes.push_back(msg.info().updated_connections_size());
+          auto updated = NetworkConnectionInfoMessageParser(msg).get_updated_connections();
+          sent.insert(updated.begin(), updated.end());
+        };
+
+        EXPECT_CALL(*duplex_writer, WriteAsync).Times(2).WillRepeatedly([record](const sensor::NetworkConnectionInfoMessage& msg) -> Result {
+          record(msg);
+          return Result(Status::OK);
+        });
+        EXPECT_CALL(*duplex_writer, WaitUntilWritable).Times(2).WillRepeatedly(Return(Result(Status::OK)));
+        EXPECT_CALL(*duplex_writer, Write).WillOnce([record, &sem](const sensor::NetworkConnectionInfoMessage& msg, const gpr_timespec& deadline) -> Result {
+          record(msg);
+          sem.release();
+          return Result(Status::OK);
+        });
+        EXPECT_CALL(*duplex_writer, Sleep).WillRepeatedly(ReturnPointee(&running));
+        EXPECT_CALL(*duplex_writer, WaitUntilStarted).WillRepeatedly(Return(Result(Status::OK)));
+
+        return duplex_writer;
+      });
+
+  // The same connections on every scrape, only the first one reports a delta.
+  EXPECT_CALL(*conn_scraper, Scrape).WillRepeatedly([&conns](std::vector<Connection>* connections, std::vector<ContainerEndpoint>* listen_endpoints) -> bool {
+    connections->insert(connections->end(), conns.begin(), conns.end());
+    return true;
+  });
+
+  auto net_status_notifier = MakeUnique<NetworkStatusNotifier>(conn_scraper,
+                                                               conn_tracker,
+                                                               comm,
+                                                               config);
+
+  net_status_notifier->Start();
+
+  EXPECT_TRUE(sem.try_acquire_for(std::chrono::seconds(5)));
+
+  net_status_notifier->Stop();
+
+  EXPECT_THAT(message_sizes, ::testing::ElementsAre(2, 2, 1));
+  EXPECT_EQ(sent.size(), conns.size());
+}
+
 }  // namespace
 
 }  // namespace collector
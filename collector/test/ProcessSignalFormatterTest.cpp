@@ -4,6 +4,7 @@
 // clang-format on
 
 #include "CollectorStats.h"
+#include "EnrichmentDegrader.h"
 #include "ProcessSignalFormatter.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -613,6 +614,173 @@ TEST(ProcessSignalFormatterTest, Rox3377ProcessLineageWithNoVPidTest) {
   CollectorStats::Reset();
 }
 
+TEST(ProcessSignalFormatterTest, SiblingsShareLineageTest) {
+  std::unique_ptr<sinsp> inspector(new sinsp());
+  CollectorStats& collector_stats = CollectorStats::GetOrCreate();
+
+  ProcessSignalFormatter processSignalFormatter(inspector.get());
+
+  auto* tinfo = new sinsp_threadinfo(inspector.get());
+  tinfo->m_pid = 3;
+  tinfo->m_tid = 3;
+  tinfo->m_ptid = -1;
+  tinfo->m_vpid = 1;
+  tinfo->m_user.uid = 42;
+  tinfo->m_exepath = "asdf";
+  auto* tinfo2 = new sinsp_threadinfo(inspector.get());
+  tinfo2->m_pid = 4;
+  tinfo2->m_tid = 4;
+  tinfo2->m_ptid = 3;
+  tinfo2->m_vpid = 2;
+  tinfo2->m_user.uid = 7;
+  tinfo2->m_exepath = "qwerty";
+  auto* tinfo3 = new sinsp_threadinfo(inspector.get());
+  tinfo3->m_pid = 5;
+  tinfo3->m_tid = 5;
+  tinfo3->m_ptid = 3;
+  tinfo3->m_vpid = 3;
+  tinfo3->m_user.uid = 8;
+  tinfo3->m_exepath = "uiop";
+  inspector->add_thread(tinfo);
+  inspector->add_thread(tinfo2);
+  inspector->add_thread(tinfo3);
+
+  std::vector<ProcessSignalFormatter::LineageInfo> lineage;
+  processSignalFormatter.GetProcessLineage(tinfo2, lineage);
+  std::vector<ProcessSignalFormatter::LineageInfo> lineage2;
+  processSignalFormatter.GetProcessLineage(tinfo3, lineage2);
+
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_misses), 1);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_hits), 1);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_counts), 2);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_string_total), 8);
+
+  ASSERT_EQ(lineage2.size(), 1);
+  EXPECT_EQ(lineage2[0].parent_uid(), tinfo->m_user.uid);
+  EXPECT_EQ(lineage2[0].parent_exec_file_path(), tinfo->m_exepath);
+
+  // The parent execs a new program.
+  tinfo->m_exepath = "zxcv";
+  processSignalFormatter.InvalidateLineage(tinfo->m_tid);
+
+  std::vector<ProcessSignalFormatter::LineageInfo> lineage3;
+  processSignalFormatter.GetProcessLineage(tinfo3, lineage3);
+
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_misses), 2);
+  ASSERT_EQ(lineage3.size(), 1);
+  EXPECT_EQ(lineage3[0].parent_exec_file_path(), "zxcv");
+
+  CollectorStats::Reset();
+}
+
+TEST(ProcessSignalFormatterTest, LineageCachingDisabledTest) {
+  std::unique_ptr<sinsp> inspector(new sinsp());
+  CollectorStats& collector_stats = CollectorStats::GetOrCreate();
+
+  ProcessSignalFormatter processSignalFormatter(inspector.get());
+
+  auto* tinfo = new sinsp_threadinfo(inspector.get());
+  tinfo->m_pid = 3;
+  tinfo->m_tid = 3;
+  tinfo->m_ptid = -1;
+  tinfo->m_vpid = 1;
+  tinfo->m_user.uid = 42;
+  tinfo->m_exepath = "asdf";
+  auto* tinfo2 = new sinsp_threadinfo(inspector.get());
+  tinfo2->m_pid = 4;
+  tinfo2->m_tid = 4;
+  tinfo2->m_ptid = 3;
+  tinfo2->m_vpid = 2;
+  tinfo2->m_user.uid = 7;
+  tinfo2->m_exepath = "qwerty";
+  inspector->add_thread(tinfo);
+  inspector->add_thread(tinfo2);
+
+  std::vector<ProcessSignalFormatter::LineageInfo> lineage;
+  processSignalFormatter.GetProcessLineage(tinfo2, lineage);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_misses), 1);
+
+  // The uid changes of the parent are no longer seen, the cached lineage is dropped and not used.
+  processSignalFormatter.SetLineageCaching(false);
+  tinfo->m_user.uid = 0;
+
+  std::vector<ProcessSignalFormatter::LineageInfo> lineage2;
+  processSignalFormatter.GetProcessLineage(tinfo2, lineage2);
+  ASSERT_EQ(lineage2.size(), 1);
+  EXPECT_EQ(lineage2[0].parent_uid(), 0);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_hits), 0);
+
+  // Once enabled again, lineages are cached anew.
+  processSignalFormatter.SetLineageCaching(true);
+  std::vector<ProcessSignalFormatter::LineageInfo> lineage3;
+  processSignalFormatter.GetProcessLineage(tinfo2, lineage3);
+  processSignalFormatter.GetProcessLineage(tinfo2, lineage3);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_misses), 2);
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_lineage_cache_hits), 1);
+
+  CollectorStats::Reset();
+}
+
+TEST(ProcessSignalFormatterTest, EnrichmentTiersTest) {
+  std::unique_ptr<sinsp> inspector(new sinsp());
+  CollectorStats& collector_stats = CollectorStats::GetOrCreate();
+
+  ProcessSignalFormatter processSignalFormatter(inspector.get());
+
+  auto* tinfo = new sinsp_threadinfo(inspector.get());
+  tinfo->m_pid = 3;
+  tinfo->m_tid = 3;
+  tinfo->m_ptid = -1;
+  tinfo->m_vpid = 1;
+  tinfo->m_exepath = "qwerty";
+  auto* tinfo2 = new sinsp_threadinfo(inspector.get());
+  tinfo2->m_pid = 4;
+  tinfo2->m_tid = 4;
+  tinfo2->m_ptid = 3;
+  tinfo2->m_vpid = 2;
+  tinfo2->m_exepath = "asdf";
+  auto* tinfo3 = new sinsp_threadinfo(inspector.get());
+  tinfo3->m_pid = 5;
+  tinfo3->m_tid = 5;
+  tinfo3->m_ptid = 4;
+  tinfo3->m_vpid = 3;
+  tinfo3->m_user.uid = 42;
+  tinfo3->m_exepath = "uiop";
+  tinfo3->m_args = {std::string(200, 'a'), std::string(200, 'b')};
+  inspector->add_thread(tinfo);
+  inspector->add_thread(tinfo2);
+  inspector->add_thread(tinfo3);
+
+  const auto* signal_msg = processSignalFormatter.ToProtoMessage(tinfo3);
+  ASSERT_NE(signal_msg, nullptr);
+  const auto& signal = signal_msg->signal().process_signal();
+  EXPECT_EQ(signal.lineage_info_size(), 2);
+  EXPECT_EQ(signal.args().size(), 401);
+  EXPECT_EQ(signal.uid(), 42);
+
+  processSignalFormatter.SetEnrichmentTier(EnrichmentDegrader::kParentLineage);
+  signal_msg = processSignalFormatter.ToProtoMessage(tinfo3);
+  ASSERT_EQ(signal.lineage_info_size(), 1);
+  EXPECT_EQ(signal.lineage_info(0).parent_exec_file_path(), "asdf");
+  EXPECT_EQ(signal.args().size(), 401);
+
+  processSignalFormatter.SetEnrichmentTier(EnrichmentDegrader::kTruncatedArgs);
+  signal_msg = processSignalFormatter.ToProtoMessage(tinfo3);
+  EXPECT_EQ(signal.lineage_info_size(), 1);
+  EXPECT_EQ(signal.args().size(), EnrichmentDegrader::kTruncatedArgsLength);
+
+  processSignalFormatter.SetEnrichmentTier(EnrichmentDegrader::kMinimal);
+  signal_msg = processSignalFormatter.ToProtoMessage(tinfo3);
+  EXPECT_EQ(signal.lineage_info_size(), 0);
+  EXPECT_TRUE(signal.args().empty());
+  EXPECT_EQ(signal.uid(), 42);
+  EXPECT_EQ(signal.exec_file_path(), "uiop");
+
+  EXPECT_EQ(collector_stats.GetCounter(CollectorStats::process_signals_degraded), 3);
+
+  CollectorStats::Reset();
+}
+
 }  // namespace
 
 }  // namespace collector
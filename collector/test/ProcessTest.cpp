@@ -0,0 +1,117 @@
+#include <thread>
+#include <vector>
+
+#include "Process.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+TEST(ProcessTest, TestKeyInterning) {
+  auto key1 = ProcessKey::Intern("comm", "/bin/exe", "--arg");
+  auto key2 = ProcessKey::Intern("comm", "/bin/exe", "--arg");
+  auto key3 = ProcessKey::Intern("comm", "/bin/exe", "--other-arg");
+
+  EXPECT_EQ(key1, key2);
+  EXPECT_NE(key1, key3);
+  EXPECT_EQ(key1->comm, "comm");
+  EXPECT_EQ(key1->exe_path, "/bin/exe");
+  EXPECT_EQ(key1->args, "--arg");
+
+  key1.reset();
+  key2.reset();
+
+  auto key4 = ProcessKey::Intern("comm", "/bin/exe", "--arg");
+  EXPECT_EQ(key4->args, "--arg");
+  EXPECT_NE(key4, key3);
+}
+
+TEST(ProcessTest, TestUnresolvedProcessesShareKey) {
+  ProcessStore store(nullptr);
+
+  auto process1 = store.Fetch(1);
+  auto process2 = store.Fetch(2);
+
+  EXPECT_EQ(process1->comm(), "N/A");
+  EXPECT_EQ(process1->exe_path(), "N/A");
+  EXPECT_EQ(process1->args(), "N/A");
+  ASSERT_NE(process1->key(), nullptr);
+  EXPECT_EQ(process1->key(), process2->key());
+}
+
+TEST(ProcessTest, TestStoreDeduplicates) {
+  ProcessStore store(nullptr);
+
+  auto process1 = store.Fetch(1);
+  auto process2 = store.Fetch(1);
+  auto process3 = store.Fetch(2);
+
+  EXPECT_EQ(process1, process2);
+  EXPECT_NE(process1, process3);
+  EXPECT_EQ(store.Size(), 2);
+
+  auto batch = store.FetchBatch({2, 3, 1, 3});
+  ASSERT_EQ(batch.size(), 4);
+  EXPECT_EQ(batch[0], process3);
+  EXPECT_EQ(batch[1], batch[3]);
+  EXPECT_EQ(batch[2], process1);
+  EXPECT_EQ(store.Size(), 3);
+
+  batch.clear();
+  EXPECT_EQ(store.Size(), 2);
+
+  process1.reset();
+  process2.reset();
+  process3.reset();
+  EXPECT_EQ(store.Size(), 0);
+}
+
+TEST(ProcessTest, TestStoreCapacity) {
+  // One process per shard
+  ProcessStore store(nullptr, "", ProcessStore::kNumShards);
+
+  auto process1 = store.Fetch(1);
+  auto process2 = store.Fetch(1 + ProcessStore::kNumShards);
+  auto process3 = store.Fetch(1 + ProcessStore::kNumShards);
+
+  EXPECT_EQ(store.Size(), 1);
+  EXPECT_EQ(process1, store.Fetch(1));
+  // Not cached, as its shard is full
+  EXPECT_NE(process2, process3);
+
+  process1.reset();
+  auto process4 = store.Fetch(1 + ProcessStore::kNumShards);
+  EXPECT_EQ(process4, store.Fetch(1 + ProcessStore::kNumShards));
+  EXPECT_EQ(store.Size(), 1);
+}
+
+TEST(ProcessTest, TestStoreConcurrentAccess) {
+  ProcessStore store(nullptr);
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&store] {
+      for (int i = 0; i < 1000; i++) {
+        std::vector<std::shared_ptr<IProcess>> processes;
+        for (uint64_t pid = 0; pid < 64; pid++) {
+          processes.push_back(store.Fetch(pid));
+        }
+        for (uint64_t pid = 0; pid < 64; pid++) {
+          ASSERT_EQ(processes[pid]->pid(), pid);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(store.Size(), 0);
+}
+
+}  // namespace
+
+}  // namespace collector
@@ -1,5 +1,7 @@
 #include <chrono>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "RateLimit.h"
 #include "gmock/gmock.h"
@@ -53,19 +55,72 @@ TEST(RateLimitTest, EvictionTest) {
   EXPECT_EQ(r.Allow("A"), false);
   EXPECT_EQ(r.Allow("B"), false);
 
+  // A new key evicts a single key, instead of flushing the whole cache.
   EXPECT_EQ(r.Allow("C"), true);
+  EXPECT_EQ(r.Size(), 2);
+  EXPECT_TRUE(r.Contains("C"));
+  ASSERT_NE(r.Contains("A"), r.Contains("B"));
 
-  EXPECT_EQ(r.Allow("A"), true);
-  EXPECT_EQ(r.Allow("A"), true);
-  EXPECT_EQ(r.Allow("B"), true);
-  EXPECT_EQ(r.Allow("B"), true);
+  // The key which was kept is still rate limited.
+  EXPECT_EQ(r.Allow(r.Contains("A") ? "A" : "B"), false);
+}
 
-  EXPECT_EQ(r.Allow("D"), true);
+TEST(RateLimitTest, ClockEvictionTest) {
+  RateLimitCache r(4, 1, 5);
+  std::vector<std::string> keys = {"K1", "K2", "K3", "K4"};
+  for (const auto& key : keys) {
+    r.Allow(key);
+  }
 
-  EXPECT_EQ(r.Allow("A"), true);
-  EXPECT_EQ(r.Allow("A"), true);
-  EXPECT_EQ(r.Allow("B"), true);
-  EXPECT_EQ(r.Allow("B"), true);
+  // All keys were used since the hand last passed: the first sweep spares them all, and evicts one on the
+  // second pass.
+  r.Allow("K5");
+  std::vector<std::string> survivors;
+  for (const auto& key : keys) {
+    if (r.Contains(key)) {
+      survivors.push_back(key);
+    }
+  }
+  ASSERT_EQ(survivors.size(), 3);
+
+  // Only the survivor which is not used again is evicted next.
+  EXPECT_EQ(r.Allow(survivors[0]), false);
+  EXPECT_EQ(r.Allow(survivors[1]), false);
+  r.Allow("K6");
+  EXPECT_TRUE(r.Contains(survivors[0]));
+  EXPECT_TRUE(r.Contains(survivors[1]));
+  EXPECT_FALSE(r.Contains(survivors[2]));
+  EXPECT_TRUE(r.Contains("K5"));
+  EXPECT_TRUE(r.Contains("K6"));
+}
+
+TEST(RateLimitTest, ManyKeysTest) {
+  RateLimitCache r(64, 1, 5);
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_EQ(r.Allow(std::to_string(i)), true);
+    // The most recent key is still limited after the evictions.
+    EXPECT_EQ(r.Allow(std::to_string(i)), false);
+  }
+  EXPECT_EQ(r.Size(), 64);
+}
+
+TEST(RateLimitTest, StreamingHashTest) {
+  auto hash = [](std::initializer_list<std::string> fields) {
+    StreamingHash128 h;
+    for (const auto& field : fields) {
+      h.Add(field);
+    }
+    return h.Finish();
+  };
+
+  EXPECT_EQ(hash({"container", "nginx", "-g daemon off;"}), hash({"container", "nginx", "-g daemon off;"}));
+  EXPECT_NE(hash({"ab", "c"}), hash({"a", "bc"}));
+  EXPECT_NE(hash({"a"}), hash({std::string("a\0", 2)}));
+  EXPECT_NE(hash({""}), hash({"", ""}));
+
+  std::string long_field(100, 'x');
+  EXPECT_NE(hash({long_field}), hash({long_field.substr(0, 99)}));
+  EXPECT_NE(hash({long_field.substr(0, 16), ""}), hash({"", long_field.substr(0, 16)}));
 }
 
 }  // namespace
@@ -0,0 +1,136 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CollectorStats.h"
+#include "ReplayBuffer.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using SignalStreamMessage = ReplayBuffer::SignalStreamMessage;
+
+SignalStreamMessage MakeSignal(const std::string& id) {
+  SignalStreamMessage msg;
+  msg.mutable_signal()->mutable_process_signal()->set_id(id);
+  return msg;
+}
+
+const std::string& IdOf(const SignalStreamMessage& msg) {
+  return msg.signal().process_signal().id();
+}
+
+TEST(ReplayBufferTest, TestInOrder) {
+  ReplayBuffer buffer(1024);
+  EXPECT_TRUE(buffer.Empty());
+
+  for (int i = 0; i < 10; i++) {
+    buffer.Push(MakeSignal(std::to_string(i)));
+  }
+  EXPECT_EQ(buffer.Size(), 10);
+  EXPECT_FALSE(buffer.TakeDropped());
+
+  SignalStreamMessage msg;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(buffer.Pop(&msg));
+    EXPECT_EQ(IdOf(msg), std::to_string(i));
+  }
+  EXPECT_FALSE(buffer.Pop(&msg));
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(buffer.Bytes(), 0);
+}
+
+TEST(ReplayBufferTest, TestDropsOldest) {
+  CollectorStats::Reset();
+  size_t signal_bytes = MakeSignal("00").ByteSizeLong();
+  ReplayBuffer buffer(3 * signal_bytes);
+
+  for (int i = 10; i < 15; i++) {
+    buffer.Push(MakeSignal(std::to_string(i)));
+  }
+  EXPECT_EQ(buffer.Size(), 3);
+  EXPECT_EQ(buffer.Bytes(), 3 * signal_bytes);
+  EXPECT_TRUE(buffer.TakeDropped());
+  EXPECT_FALSE(buffer.TakeDropped());
+
+  SignalStreamMessage msg;
+  ASSERT_TRUE(buffer.Pop(&msg));
+  EXPECT_EQ(IdOf(msg), "12");
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_replay_dropped), 2);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_replay_buffered), 2);
+}
+
+TEST(ReplayBufferTest, TestTooLarge) {
+  ReplayBuffer buffer(8);
+
+  buffer.Push(MakeSignal("a signal which does not fit"));
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_TRUE(buffer.TakeDropped());
+
+  ReplayBuffer disabled(0);
+  disabled.Push(MakeSignal("0"));
+  EXPECT_TRUE(disabled.Empty());
+}
+
+TEST(ReplayBufferTest, TestPushFront) {
+  CollectorStats::Reset();
+  size_t signal_bytes = MakeSignal("00").ByteSizeLong();
+  ReplayBuffer buffer(4 * signal_bytes);
+
+  buffer.Push(MakeSignal("13"));
+  buffer.Push(MakeSignal("14"));
+  std::vector<SignalStreamMessage> unflushed;
+  for (int i = 10; i < 13; i++) {
+    unflushed.push_back(MakeSignal(std::to_string(i)));
+  }
+
+  // The oldest signal put back does not fit.
+  buffer.PushFront(std::move(unflushed));
+  EXPECT_EQ(buffer.Size(), 4);
+  EXPECT_TRUE(buffer.TakeDropped());
+
+  SignalStreamMessage msg;
+  for (int i = 11; i < 15; i++) {
+    ASSERT_TRUE(buffer.Pop(&msg));
+    EXPECT_EQ(IdOf(msg), std::to_string(i));
+  }
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::process_replay_dropped), 1);
+}
+
+TEST(ReplayBufferTest, TestConcurrentProducers) {
+  ReplayBuffer buffer(1 << 20);
+  constexpr int kProducers = 4;
+  constexpr int kSignalsPerProducer = 1000;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&buffer, p] {
+      for (int i = 0; i < kSignalsPerProducer; i++) {
+        buffer.Push(MakeSignal(std::to_string(p)));
+      }
+    });
+  }
+
+  int popped = 0;
+  SignalStreamMessage msg;
+  while (popped < kProducers * kSignalsPerProducer) {
+    if (buffer.Pop(&msg)) {
+      popped++;
+    }
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_FALSE(buffer.TakeDropped());
+}
+
+}  // namespace
+
+}  // namespace collector
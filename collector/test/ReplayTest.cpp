@@ -0,0 +1,62 @@
+#include <sstream>
+
+#include "Replay.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(ReplayTest, TestPacerFirstEventIsDueImmediately) {
+  ReplayPacer pacer;
+  ReplayPacer::Clock::time_point now;
+
+  EXPECT_EQ(pacer.Delay(5000000000, now), 0ns);
+}
+
+TEST(ReplayTest, TestPacerFollowsRecordedTimestamps) {
+  ReplayPacer pacer;
+  ReplayPacer::Clock::time_point start;
+
+  pacer.Delay(1000000000, start);
+
+  EXPECT_EQ(pacer.Delay(1000000000 + 3000000, start), 3ms);
+  EXPECT_EQ(pacer.Delay(1000000000 + 3000000, start + 1ms), 2ms);
+  // Late events are due immediately, the delay is not carried over.
+  EXPECT_EQ(pacer.Delay(1000000000 + 3000000, start + 5ms), 0ns);
+  EXPECT_EQ(pacer.Delay(1000000000 + 10000000, start + 5ms), 5ms);
+}
+
+TEST(ReplayTest, TestPacerOutOfOrderEvents) {
+  ReplayPacer pacer;
+  ReplayPacer::Clock::time_point start;
+
+  pacer.Delay(1000000000, start);
+
+  EXPECT_EQ(pacer.Delay(999000000, start), 0ns);
+}
+
+TEST(ReplayTest, TestReport) {
+  ReplayReport report;
+  report.duration = 2s;
+  report.events = 1000;
+  report.filtered_events = 600;
+  report.handlers.push_back({"ProcessSignalHandler", 500, 1000});
+  report.process_signals = 10;
+  report.network_updates = 4;
+
+  std::stringstream ss;
+  ss << report;
+
+  EXPECT_EQ(ss.str(),
+            "Replayed 1000 events (600 dispatched) in 2s: 500 events/s\n"
+            "  ProcessSignalHandler: ~500 calls, ~1ms CPU (2000ns/call)\n"
+            "  process signals: 10 (5/s)\n"
+            "  network updates: 4 (2/s)");
+}
+
+}  // namespace
+
+}  // namespace collector
@@ -0,0 +1,101 @@
+#include <chrono>
+
+#include "CollectorStats.h"
+#include "ScrapeScheduler.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(ScrapeSchedulerTest, FixedInterval) {
+  ScrapeScheduler scheduler(30s, 10s, 120s, false);
+
+  EXPECT_EQ(scheduler.Interval(), 30s);
+  EXPECT_EQ(scheduler.OnScrape(10s, 100, 100), 30s);
+  EXPECT_EQ(scheduler.OnScrape(10s, 100, 0), 30s);
+}
+
+TEST(ScrapeSchedulerTest, IntervalIsClamped) {
+  ScrapeScheduler low(5s, 10s, 120s, true);
+  EXPECT_EQ(low.Interval(), 10s);
+
+  ScrapeScheduler high(300s, 10s, 120s, true);
+  EXPECT_EQ(high.Interval(), 120s);
+}
+
+TEST(ScrapeSchedulerTest, FirstScrapeIsIgnored) {
+  ScrapeScheduler scheduler(30s, 10s, 120s, true);
+
+  // Everything is missed on the first scrape
+  EXPECT_EQ(scheduler.OnScrape(10ms, 100, 100), 30s);
+}
+
+TEST(ScrapeSchedulerTest, HighChurnShortensInterval) {
+  ScrapeScheduler scheduler(30s, 10s, 120s, true);
+  scheduler.OnScrape(10ms, 100, 100);
+
+  auto decreased = CollectorStats::GetOrCreate().GetCounter(CollectorStats::net_scrape_interval_decreased);
+
+  EXPECT_EQ(scheduler.OnScrape(10ms, 100, 20), 15s);
+  EXPECT_EQ(scheduler.OnScrape(10ms, 100, 20), 10s);
+  EXPECT_EQ(scheduler.OnScrape(10ms, 100, 20), 10s);
+
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::net_scrape_interval_decreased), decreased + 2);
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::net_scrape_interval_ms), 10000);
+}
+
+TEST(ScrapeSchedulerTest, ExpensiveScrapeWithLowChurnStretchesInterval) {
+  ScrapeScheduler scheduler(30s, 10s, 60s, true);
+  scheduler.OnScrape(10ms, 100, 100);
+
+  // 1s out of 30s is expensive
+  EXPECT_EQ(scheduler.OnScrape(1s, 1000, 1), 45s);
+  EXPECT_EQ(scheduler.OnScrape(1s, 1000, 1), 60s);
+  EXPECT_EQ(scheduler.OnScrape(1s, 1000, 1), 60s);
+}
+
+TEST(ScrapeSchedulerTest, ModerateScrapeWithLowChurnKeepsInterval) {
+  ScrapeScheduler scheduler(30s, 10s, 120s, true);
+  scheduler.OnScrape(10ms, 100, 100);
+
+  // 100ms out of 30s is neither cheap nor expensive
+  EXPECT_EQ(scheduler.OnScrape(100ms, 1000, 1), 30s);
+  EXPECT_EQ(scheduler.OnScrape(100ms, 0, 0), 30s);
+}
+
+TEST(ScrapeSchedulerTest, CheapScrapeShortensInterval) {
+  ScrapeScheduler scheduler(60s, 10s, 120s, true);
+  scheduler.OnScrape(10ms, 100, 100);
+
+  auto decreased = CollectorStats::GetOrCreate().GetCounter(CollectorStats::net_scrape_interval_decreased);
+
+  // An idle node, 10ms out of 60s is cheap
+  EXPECT_EQ(scheduler.OnScrape(10ms, 0, 0), 40s);
+  EXPECT_EQ(scheduler.OnScrape(10ms, 0, 0), 26666ms);
+  for (int i = 0; i < 10; i++) {
+    scheduler.OnScrape(10ms, 0, 0);
+  }
+  EXPECT_EQ(scheduler.Interval(), 10s);
+
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::net_scrape_interval_decreased), decreased + 5);
+}
+
+TEST(ScrapeSchedulerTest, StretchedIntervalComesBackWhenCheap) {
+  ScrapeScheduler scheduler(30s, 10s, 120s, true);
+  scheduler.OnScrape(10ms, 100, 100);
+
+  // A busy period makes scrapes expensive
+  EXPECT_EQ(scheduler.OnScrape(1s, 1000, 1), 45s);
+  EXPECT_EQ(scheduler.OnScrape(1s, 1000, 1), 67500ms);
+
+  // Once it is over, scrapes are cheap again
+  EXPECT_EQ(scheduler.OnScrape(10ms, 100, 0), 45s);
+  EXPECT_EQ(scheduler.OnScrape(10ms, 100, 0), 30s);
+}
+
+}  // namespace
+
+}  // namespace collector
@@ -0,0 +1,59 @@
+#include <atomic>
+#include <thread>
+
+#include "SeqLock.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+struct Snapshot {
+  uint64_t a = 0;
+  uint64_t b = 0;
+  uint32_t c = 0;
+};
+
+TEST(SeqLockTest, TestStoreLoad) {
+  SeqLock<Snapshot> lock;
+  EXPECT_EQ(lock.Version(), 0);
+  EXPECT_EQ(lock.Load().a, 0);
+
+  lock.Store({1, 2, 3});
+  auto value = lock.Load();
+  EXPECT_EQ(value.a, 1);
+  EXPECT_EQ(value.b, 2);
+  EXPECT_EQ(value.c, 3);
+  EXPECT_EQ(lock.Version(), 1);
+}
+
+TEST(SeqLockTest, TestReadersNeverSeeTornValues) {
+  constexpr uint64_t kStores = 100000;
+  SeqLock<Snapshot> lock;
+  std::atomic<bool> done = false;
+
+  std::thread writer([&] {
+    for (uint64_t i = 1; i <= kStores; i++) {
+      lock.Store({i, i * 2, static_cast<uint32_t>(i * 3)});
+    }
+    done = true;
+  });
+
+  uint64_t last = 0;
+  uint64_t inconsistent = 0;
+  while (!done) {
+    auto value = lock.Load();
+    if (value.b != value.a * 2 || value.c != static_cast<uint32_t>(value.a * 3) || value.a < last) {
+      inconsistent++;
+    }
+    last = value.a;
+  }
+  writer.join();
+
+  EXPECT_EQ(inconsistent, 0);
+  EXPECT_EQ(lock.Load().a, kStores);
+}
+
+}  // namespace
+
+}  // namespace collector
@@ -0,0 +1,159 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CollectorStats.h"
+#include "SPSCQueue.h"
+#include "SignalPipeline.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+const SignalPipeline<int>::Counters kCounters{
+    CollectorStats::process_pipeline_queue_depth,
+    CollectorStats::process_pipeline_queue_full,
+    CollectorStats::process_pipeline_dropped,
+};
+
+TEST(SPSCQueueTest, TestCapacity) {
+  SPSCQueue<int> queue(5);
+  EXPECT_EQ(queue.Capacity(), 8);
+
+  for (int i = 0; i < 8; i++) {
+    EXPECT_TRUE(queue.TryPush(int(i)));
+  }
+  EXPECT_FALSE(queue.TryPush(8));
+  EXPECT_EQ(queue.Size(), 8);
+
+  int item;
+  ASSERT_TRUE(queue.TryPop(&item));
+  EXPECT_EQ(item, 0);
+  EXPECT_TRUE(queue.TryPush(8));
+
+  for (int i = 1; i <= 8; i++) {
+    ASSERT_TRUE(queue.TryPop(&item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_FALSE(queue.TryPop(&item));
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST(SPSCQueueTest, TestConcurrentOrdering) {
+  constexpr int kItems = 100000;
+  SPSCQueue<int> queue(64);
+
+  std::thread producer([&queue] {
+    for (int i = 0; i < kItems; i++) {
+      while (!queue.TryPush(int(i))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  int item;
+  while (expected < kItems) {
+    if (queue.TryPop(&item)) {
+      ASSERT_EQ(item, expected);
+      expected++;
+    }
+  }
+
+  producer.join();
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST(SignalPipelineTest, TestConsumesInOrder) {
+  CollectorStats::Reset();
+  SignalPipeline<int> pipeline(16, 1s, kCounters);
+
+  std::mutex mutex;
+  std::vector<int> consumed;
+  ASSERT_TRUE(pipeline.Start([&](int& payload) {
+    std::lock_guard<std::mutex> lock(mutex);
+    consumed.push_back(payload);
+  }));
+
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(pipeline.Push(int(i)));
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (consumed.size() == 1000) break;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  pipeline.Stop();
+
+  ASSERT_EQ(consumed.size(), 1000);
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(consumed[i], i);
+  }
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::process_pipeline_dropped), 0);
+}
+
+TEST(SignalPipelineTest, TestDropsWhenFull) {
+  CollectorStats::Reset();
+  SignalPipeline<int> pipeline(2, 1ms, kCounters);
+
+  std::atomic<bool> release = false;
+  ASSERT_TRUE(pipeline.Start([&](int&) {
+    while (!release) {
+      std::this_thread::sleep_for(100us);
+    }
+  }));
+
+  // One payload is held by the blocked worker, two fill up the queue.
+  int pushed = 0;
+  while (pipeline.Push(int(pushed))) {
+    pushed++;
+  }
+  release = true;
+
+  EXPECT_GE(pushed, 2);
+  EXPECT_LE(pushed, 3);
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::process_pipeline_dropped), 1);
+  EXPECT_GE(stats.GetCounter(CollectorStats::process_pipeline_queue_full), 1);
+
+  pipeline.Stop();
+}
+
+}  // namespace
+
+TEST(SignalPipelineTest, TestWakesUpIdleWorker) {
+  SignalPipeline<int> pipeline(16, 1s, kCounters);
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  int consumed = 0;
+  ASSERT_TRUE(pipeline.Start([&](int&) {
+    std::lock_guard<std::mutex> lock(mutex);
+    consumed++;
+    cond.notify_one();
+  }));
+
+  // Let the worker go to sleep between payloads.
+  for (int i = 1; i <= 10; i++) {
+    std::this_thread::sleep_for(5ms);
+    ASSERT_TRUE(pipeline.Push(int(i)));
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cond.wait_for(lock, 1s, [&] { return consumed == i; }));
+  }
+
+  // Stopping wakes up the idle worker.
+  auto start = std::chrono::steady_clock::now();
+  pipeline.Stop();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+}  // namespace collector
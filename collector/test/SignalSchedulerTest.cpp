@@ -0,0 +1,136 @@
+#include <atomic>
+#include <thread>
+
+#include "CollectorStats.h"
+#include "SignalScheduler.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+bool NeverInterrupted() { return false; }
+
+std::array<SignalScheduler::StreamConfig, SignalScheduler::NUM_STREAMS> Streams(uint64_t process_bytes_per_second,
+                                                                                uint64_t network_bytes_per_second) {
+  std::array<SignalScheduler::StreamConfig, SignalScheduler::NUM_STREAMS> streams;
+  streams[SignalScheduler::PROCESS] = {1, process_bytes_per_second};
+  streams[SignalScheduler::NETWORK] = {0, network_bytes_per_second};
+  return streams;
+}
+
+TEST(SignalSchedulerTest, TestUnlimitedByDefault) {
+  CollectorStats::Reset();
+  SignalScheduler scheduler(Streams(0, 0));
+
+  auto start = Clock::now();
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 1 << 20, NeverInterrupted));
+    EXPECT_TRUE(scheduler.Acquire(SignalScheduler::PROCESS, 1 << 20, NeverInterrupted));
+  }
+  EXPECT_LT(Clock::now() - start, SignalScheduler::kWindow);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::scheduler_priority_holds), 0);
+  EXPECT_EQ(stats.GetCounter(CollectorStats::scheduler_budget_holds), 0);
+}
+
+TEST(SignalSchedulerTest, TestHigherPriorityGoesFirst) {
+  SignalScheduler scheduler(Streams(0, 0));
+
+  // The higher priority stream is never held back by a busy lower priority one.
+  scheduler.SetBusy(SignalScheduler::NETWORK, true);
+  auto start = Clock::now();
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::PROCESS, 100, NeverInterrupted));
+  EXPECT_LT(Clock::now() - start, SignalScheduler::kWindow / 2);
+  scheduler.SetBusy(SignalScheduler::NETWORK, false);
+
+  // The lower priority stream waits until the higher priority one is done.
+  scheduler.SetBusy(SignalScheduler::PROCESS, true);
+  std::atomic<bool> acquired{false};
+  std::thread network([&] {
+    scheduler.Acquire(SignalScheduler::NETWORK, 100, NeverInterrupted);
+    acquired = true;
+  });
+  std::this_thread::sleep_for(SignalScheduler::kWindow / 4);
+  EXPECT_FALSE(acquired);
+  scheduler.SetBusy(SignalScheduler::PROCESS, false);
+  network.join();
+  EXPECT_TRUE(acquired);
+}
+
+TEST(SignalSchedulerTest, TestLowerPriorityIsNotStarved) {
+  CollectorStats::Reset();
+  SignalScheduler scheduler(Streams(0, 0));
+  scheduler.SetBusy(SignalScheduler::PROCESS, true);
+
+  auto start = Clock::now();
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 100, NeverInterrupted));
+  auto elapsed = Clock::now() - start;
+  EXPECT_GE(elapsed, SignalScheduler::kWindow);
+  EXPECT_LT(elapsed, 3 * SignalScheduler::kWindow);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::scheduler_priority_holds), 1);
+  EXPECT_GE(stats.GetCounter(CollectorStats::scheduler_hold_micros), 100000);
+}
+
+TEST(SignalSchedulerTest, TestBudgetThrottles) {
+  CollectorStats::Reset();
+  // 1000 bytes per window.
+  SignalScheduler scheduler(Streams(0, 10000));
+
+  // The budget of the first window is exceeded by the second message, the debt delays the third one by two
+  // windows.
+  auto start = Clock::now();
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 800, NeverInterrupted));
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 1500, NeverInterrupted));
+  EXPECT_LT(Clock::now() - start, SignalScheduler::kWindow / 2);
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 100, NeverInterrupted));
+  EXPECT_GE(Clock::now() - start, 2 * SignalScheduler::kWindow - 10ms);
+
+  // The other stream has its own budget.
+  start = Clock::now();
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::PROCESS, 1 << 20, NeverInterrupted));
+  EXPECT_LT(Clock::now() - start, SignalScheduler::kWindow / 2);
+
+  auto& stats = CollectorStats::GetOrCreate();
+  EXPECT_EQ(stats.GetCounter(CollectorStats::scheduler_budget_holds), 1);
+}
+
+TEST(SignalSchedulerTest, TestLowBudgetStillThrottles) {
+  CollectorStats::Reset();
+  // Less than a byte per window.
+  SignalScheduler scheduler(Streams(0, 5));
+
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 100, NeverInterrupted));
+  auto start = Clock::now();
+  std::atomic<bool> stop{false};
+  std::thread network([&] {
+    EXPECT_FALSE(scheduler.Acquire(SignalScheduler::NETWORK, 100, [&] { return stop.load(); }));
+  });
+  std::this_thread::sleep_for(SignalScheduler::kWindow * 2);
+  stop = true;
+  network.join();
+  EXPECT_GE(Clock::now() - start, SignalScheduler::kWindow * 2);
+}
+
+TEST(SignalSchedulerTest, TestInterrupted) {
+  SignalScheduler scheduler(Streams(0, 10000));
+  EXPECT_TRUE(scheduler.Acquire(SignalScheduler::NETWORK, 1 << 20, NeverInterrupted));
+
+  std::atomic<bool> stop{false};
+  std::thread network([&] {
+    EXPECT_FALSE(scheduler.Acquire(SignalScheduler::NETWORK, 100, [&] { return stop.load(); }));
+  });
+  std::this_thread::sleep_for(SignalScheduler::kWindow / 2);
+  stop = true;
+  network.join();
+}
+
+}  // namespace
+
+}  // namespace collector
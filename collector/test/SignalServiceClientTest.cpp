@@ -0,0 +1,171 @@
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CollectorStats.h"
+#include "SignalServiceClient.h"
+#include "gtest/gtest.h"
+
+#include "../benchmark/MockSensor.h"
+
+namespace collector {
+
+namespace {
+
+using benchmark::MockSensor;
+using SignalStreamMessage = SignalServiceClient::SignalStreamMessage;
+
+constexpr std::chrono::seconds kTimeout{30};
+
+SignalStreamMessage MakeSignal(int id, size_t args_length = 0) {
+  SignalStreamMessage msg;
+  auto* signal = msg.mutable_signal()->mutable_process_signal();
+  signal->set_id(std::to_string(id));
+  signal->set_args(std::string(args_length, 'a'));
+  return msg;
+}
+
+int IdOf(const SignalStreamMessage& msg) {
+  return std::stoi(msg.signal().process_signal().id());
+}
+
+// Collects the ids of the signals received by a MockSensor.
+class ReceivedIds {
+ public:
+  void Observe(MockSensor* sensor) {
+    sensor->SetSignalObserver([this](const SignalStreamMessage& msg) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ids_.push_back(IdOf(msg));
+    });
+  }
+
+  std::vector<int> Get() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ids_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<int> ids_;
+};
+
+std::vector<int> Range(int first, int last) {
+  std::vector<int> ids;
+  for (int id = first; id < last; id++) {
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+// Waits until the client has established its stream, or seen it fail.
+bool WaitForStream(const std::atomic<bool>& stream_active, bool active) {
+  auto deadline = std::chrono::steady_clock::now() + kTimeout;
+  while (stream_active.load() != active) {
+    if (std::chrono::steady_clock::now() >= deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(SignalServiceClientTest, TestRequeueKeepsOrder) {
+  SignalServiceClient client(grpc::CreateChannel("localhost:1", grpc::InsecureChannelCredentials()));
+
+  // The batch being written when the stream failed, then the signals still queued.
+  client.unflushed_.push_back(MakeSignal(0));
+  client.unflushed_.push_back(MakeSignal(1));
+  ASSERT_TRUE(client.queue_.TryPush({MakeSignal(2), 0}));
+  ASSERT_TRUE(client.queue_.TryPush({MakeSignal(3), 0}));
+  // A producer saw the stream down before the sender requeued them.
+  client.replay_.Push(MakeSignal(4));
+
+  client.RequeueForReplay();
+
+  EXPECT_TRUE(client.unflushed_.empty());
+  EXPECT_EQ(client.queue_.Size(), 0);
+  SignalStreamMessage msg;
+  for (int id = 0; id < 5; id++) {
+    ASSERT_TRUE(client.replay_.Pop(&msg));
+    EXPECT_EQ(IdOf(msg), id);
+  }
+  EXPECT_FALSE(client.replay_.Pop(&msg));
+}
+
+TEST(SignalServiceClientTest, TestReplaysAfterReconnect) {
+  CollectorStats::Reset();
+  ReceivedIds received;
+  auto sensor = std::make_unique<MockSensor>("localhost:0");
+  received.Observe(sensor.get());
+  ASSERT_TRUE(sensor->Start());
+  std::string address = sensor->Address();
+
+  SignalServiceClient client(grpc::CreateChannel(address, grpc::InsecureChannelCredentials()));
+  client.Start();
+
+  // The first signal of the first stream asks for the existing processes, and is not sent.
+  ASSERT_TRUE(WaitForStream(client.stream_active_, true));
+  ASSERT_EQ(client.PushSignals(MakeSignal(-1)), SignalHandler::NEEDS_REFRESH);
+  for (int id = 0; id < 10; id++) {
+    ASSERT_EQ(client.PushSignals(MakeSignal(id)), SignalHandler::PROCESSED);
+  }
+  ASSERT_TRUE(MockSensor::WaitFor(sensor->Signals(), 10, kTimeout));
+
+  // Sensor restarts, the signals of the outage are buffered.
+  sensor.reset();
+  ASSERT_TRUE(WaitForStream(client.stream_active_, false));
+  for (int id = 10; id < 30; id++) {
+    ASSERT_EQ(client.PushSignals(MakeSignal(id)), SignalHandler::PROCESSED);
+  }
+
+  sensor = std::make_unique<MockSensor>(address);
+  received.Observe(sensor.get());
+  ASSERT_TRUE(sensor->Start());
+  ASSERT_TRUE(MockSensor::WaitFor(sensor->Signals(), 20, kTimeout));
+
+  // The buffer held the whole outage, the existing processes are not sent again.
+  ASSERT_EQ(client.PushSignals(MakeSignal(30)), SignalHandler::PROCESSED);
+  ASSERT_TRUE(MockSensor::WaitFor(sensor->Signals(), 21, kTimeout));
+  EXPECT_EQ(received.Get(), Range(0, 31));
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::process_replay_sent), 20);
+
+  client.Stop();
+}
+
+TEST(SignalServiceClientTest, TestRefreshesAfterReplayDrops) {
+  ReceivedIds received;
+  auto sensor = std::make_unique<MockSensor>("localhost:0");
+  ASSERT_TRUE(sensor->Start());
+  std::string address = sensor->Address();
+
+  // Room for a single signal.
+  SignalServiceClient client(grpc::CreateChannel(address, grpc::InsecureChannelCredentials()),
+                             SignalServiceClient::kDefaultQueueSize, SignalServiceClient::OverflowPolicy::DROP_NEWEST,
+                             MakeSignal(0, 100).ByteSizeLong());
+  client.Start();
+
+  ASSERT_TRUE(WaitForStream(client.stream_active_, true));
+  ASSERT_EQ(client.PushSignals(MakeSignal(-1)), SignalHandler::NEEDS_REFRESH);
+
+  sensor.reset();
+  ASSERT_TRUE(WaitForStream(client.stream_active_, false));
+  for (int id = 0; id < 3; id++) {
+    ASSERT_EQ(client.PushSignals(MakeSignal(id, 100)), SignalHandler::PROCESSED);
+  }
+
+  sensor = std::make_unique<MockSensor>(address);
+  received.Observe(sensor.get());
+  ASSERT_TRUE(sensor->Start());
+
+  // Only the newest signal of the outage is replayed, the others were dropped so the existing processes are
+  // sent again.
+  ASSERT_TRUE(MockSensor::WaitFor(sensor->Signals(), 1, kTimeout));
+  EXPECT_EQ(client.PushSignals(MakeSignal(3)), SignalHandler::NEEDS_REFRESH);
+  EXPECT_EQ(received.Get(), std::vector<int>({2}));
+
+  client.Stop();
+}
+
+}  // namespace collector
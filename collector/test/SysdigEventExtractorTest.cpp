@@ -0,0 +1,168 @@
+// clang-format off
+#include "libsinsp/sinsp.h"
+#include "libsinsp/filterchecks.h"
+// clang-format on
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "SysdigEventExtractor.h"
+#include "gtest/gtest.h"
+
+namespace collector {
+
+namespace {
+
+constexpr int64_t kTid = 4242;
+constexpr int64_t kSocketFd = 5;
+constexpr int64_t kServerSocketFd = 6;
+constexpr int64_t kFileFd = 7;
+
+// Holds an inspector with a single thread, and an event of that thread built from its parameters.
+class SysdigEventExtractorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    inspector_.reset(new sinsp());
+
+    tinfo_ = new sinsp_threadinfo(inspector_.get());
+    tinfo_->m_tid = kTid;
+    tinfo_->m_pid = kTid;
+    tinfo_->m_ptid = -1;
+    tinfo_->m_comm = "nginx";
+    tinfo_->m_exepath = "/usr/sbin/nginx";
+    tinfo_->m_args = {"-g", "daemon off;"};
+
+    sinsp_fdinfo_t socket;
+    socket.m_type = SCAP_FD_IPV4_SOCK;
+    socket.m_sockinfo.m_ipv4info.m_fields.m_sport = 40000;
+    socket.m_sockinfo.m_ipv4info.m_fields.m_dport = 80;
+    tinfo_->add_fd(kSocketFd, &socket);
+
+    sinsp_fdinfo_t server_socket;
+    server_socket.m_type = SCAP_FD_IPV4_SERVSOCK;
+    server_socket.m_sockinfo.m_ipv4serverinfo.m_port = 8080;
+    tinfo_->add_fd(kServerSocketFd, &server_socket);
+
+    sinsp_fdinfo_t file;
+    file.m_type = SCAP_FD_FILE_V2;
+    tinfo_->add_fd(kFileFd, &file);
+
+    inspector_->add_thread(tinfo_);
+    extractor_.Init(inspector_.get());
+  }
+
+  void TearDown() override { extractor_.ClearWrappers(); }
+
+  // A close() exit event of the thread, returning res, after the thread used the given fd.
+  sinsp_evt* CloseExit(int64_t res, int64_t last_fd) {
+    return Event(PPME_SYSCALL_CLOSE_X, res, last_fd);
+  }
+
+  // A close() enter event of the thread, on the given fd.
+  sinsp_evt* CloseEnter(int64_t fd) {
+    return Event(PPME_SYSCALL_CLOSE_E, fd, fd);
+  }
+
+  // Extracts a field through its sinsp filter check.
+  const uint8_t* Extract(const char* field, sinsp_evt* event) {
+    std::unique_ptr<sinsp_filter_check> check(g_filterlist.new_filter_check_from_fldname(field, inspector_.get(), true));
+    check->parse_field_name(field, true, false);
+    uint32_t len;
+    return check->extract(event, &len);
+  }
+
+  std::unique_ptr<sinsp> inspector_;
+  // Owned by the inspector.
+  sinsp_threadinfo* tinfo_ = nullptr;
+  SysdigEventExtractor extractor_;
+
+ private:
+  sinsp_evt* Event(ppm_event_code type, int64_t param, int64_t last_fd) {
+    char error[SCAP_LASTERR_SIZE];
+    size_t event_size;
+    EXPECT_EQ(scap_event_encode_params(scap_sized_buffer{buffer_, sizeof(buffer_)}, &event_size, error, type, 1, param),
+              SCAP_SUCCESS)
+        << error;
+    reinterpret_cast<scap_evt*>(buffer_)->tid = kTid;
+
+    tinfo_->m_lastevent_fd = last_fd;
+    event_.reset(new sinsp_evt(inspector_.get()));
+    event_->init(buffer_, 0);
+    return event_.get();
+  }
+
+  uint8_t buffer_[256];
+  std::unique_ptr<sinsp_evt> event_;
+};
+
+TEST_F(SysdigEventExtractorTest, TestProcArgs) {
+  auto* event = CloseExit(0, kFileFd);
+
+  const char* args = extractor_.get_proc_args(event);
+  ASSERT_NE(args, nullptr);
+  EXPECT_STREQ(args, "-g daemon off;");
+  EXPECT_STREQ(args, reinterpret_cast<const char*>(Extract("proc.args", event)));
+
+  EXPECT_EQ(extractor_.get_proc_args(nullptr), nullptr);
+}
+
+TEST_F(SysdigEventExtractorTest, TestEventRawres) {
+  auto* event = CloseExit(-2, kFileFd);
+
+  const int64_t* res = extractor_.get_event_rawres(event);
+  ASSERT_NE(res, nullptr);
+  EXPECT_EQ(*res, -2);
+  EXPECT_EQ(*res, *reinterpret_cast<const int64_t*>(Extract("evt.rawres", event)));
+
+  // Enter events have no return value.
+  event = CloseEnter(kFileFd);
+  EXPECT_EQ(extractor_.get_event_rawres(event), nullptr);
+  EXPECT_EQ(Extract("evt.rawres", event), nullptr);
+}
+
+TEST_F(SysdigEventExtractorTest, TestPorts) {
+  auto* event = CloseExit(0, kSocketFd);
+
+  const uint16_t* client_port = extractor_.get_client_port(event);
+  ASSERT_NE(client_port, nullptr);
+  EXPECT_EQ(*client_port, 40000);
+  EXPECT_EQ(*client_port, *reinterpret_cast<const uint16_t*>(Extract("fd.cport", event)));
+
+  const uint16_t* server_port = extractor_.get_server_port(event);
+  ASSERT_NE(server_port, nullptr);
+  EXPECT_EQ(*server_port, 80);
+  EXPECT_EQ(*server_port, *reinterpret_cast<const uint16_t*>(Extract("fd.sport", event)));
+}
+
+TEST_F(SysdigEventExtractorTest, TestServerSocketPorts) {
+  auto* event = CloseExit(0, kServerSocketFd);
+
+  EXPECT_EQ(extractor_.get_client_port(event), nullptr);
+  EXPECT_EQ(Extract("fd.cport", event), nullptr);
+
+  const uint16_t* server_port = extractor_.get_server_port(event);
+  ASSERT_NE(server_port, nullptr);
+  EXPECT_EQ(*server_port, 8080);
+  EXPECT_EQ(*server_port, *reinterpret_cast<const uint16_t*>(Extract("fd.sport", event)));
+}
+
+TEST_F(SysdigEventExtractorTest, TestNoPorts) {
+  // Not a socket.
+  auto* event = CloseExit(0, kFileFd);
+  EXPECT_EQ(extractor_.get_client_port(event), nullptr);
+  EXPECT_EQ(extractor_.get_server_port(event), nullptr);
+  EXPECT_EQ(Extract("fd.cport", event), nullptr);
+  EXPECT_EQ(Extract("fd.sport", event), nullptr);
+
+  // No fd at all.
+  event = CloseExit(0, -1);
+  EXPECT_EQ(extractor_.get_client_port(event), nullptr);
+  EXPECT_EQ(extractor_.get_server_port(event), nullptr);
+  EXPECT_EQ(Extract("fd.cport", event), nullptr);
+  EXPECT_EQ(Extract("fd.sport", event), nullptr);
+}
+
+}  // namespace
+
+}  // namespace collector
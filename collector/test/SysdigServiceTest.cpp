@@ -1,9 +1,92 @@
+#include <utility>
+
+#include "CollectorStats.h"
+#include "EventNames.h"
+#include "ProcessSignalHandler.h"
 #include "SysdigService.h"
+#include "Utility.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace collector {
 
+namespace {
+
+// Records the signals pushed, failing the given one as if the queue was full.
+class DroppingSignalClient : public ISignalServiceClient {
+ public:
+  explicit DroppingSignalClient(size_t failing_push) : failing_push_(failing_push) {}
+
+  void Start() override {}
+  void Stop() override {}
+  SignalHandler::Result PushSignals(const SignalStreamMessage& msg) override {
+    if (pushes_++ == failing_push_) {
+      return SignalHandler::ERROR;
+    }
+    sent_.push_back(msg.signal().process_signal().pid());
+    return SignalHandler::PROCESSED;
+  }
+
+  const std::vector<uint32_t>& Sent() const { return sent_; }
+
+ private:
+  size_t failing_push_;
+  size_t pushes_ = 0;
+  std::vector<uint32_t> sent_;
+};
+
+// Records the events it handles, along with their tag, in a log shared by all handlers.
+class FakeSignalHandler : public SignalHandler {
+ public:
+  FakeSignalHandler(std::string name, std::vector<std::string> events, std::vector<std::string>* log)
+      : name_(std::move(name)), events_(std::move(events)), log_(log) {}
+
+  std::string GetName() override { return name_; }
+  std::vector<std::string> GetRelevantEvents() override { return events_; }
+  EventTag GetEventTag(uint16_t event_type) override { return event_type == PPME_SYSCALL_CLOSE_X ? 1 : 2; }
+
+  Result HandleSignal(sinsp_evt* evt) override { return PROCESSED; }
+  Result HandleTaggedSignal(sinsp_evt* evt, EventTag tag) override {
+    log_->push_back(name_ + ":" + std::to_string(tag));
+    return finished_ ? FINISHED : PROCESSED;
+  }
+  Result Flush() override { return std::exchange(needs_refresh_, false) ? NEEDS_REFRESH : PROCESSED; }
+
+  // Returns FINISHED from the next event on.
+  void Finish() { finished_ = true; }
+  // Returns NEEDS_REFRESH from the next flush.
+  void RequestRefresh() { needs_refresh_ = true; }
+
+ private:
+  std::string name_;
+  std::vector<std::string> events_;
+  std::vector<std::string>* log_;
+  bool finished_ = false;
+  bool needs_refresh_ = false;
+};
+
+// An event of the given type, without parameters, which the fake handlers do not read.
+class FakeEvent {
+ public:
+  FakeEvent(sinsp* inspector, ppm_event_code type) : event_(inspector) {
+    header_.type = type;
+    header_.len = sizeof(header_);
+    event_.init(reinterpret_cast<uint8_t*>(&header_), 0);
+  }
+
+  sinsp_evt* get() { return &event_; }
+
+ private:
+  scap_evt header_{};
+  sinsp_evt event_;
+};
+
+uint16_t ExecveExit() {
+  return EventNames::GetInstance().GetEventIDs("execve<").front();
+}
+
+}  // namespace
+
 TEST(SysdigServiceTest, FilterEvent) {
   std::unique_ptr<sinsp> inspector(new sinsp());
 
@@ -39,4 +122,130 @@ TEST(SysdigServiceTest, FilterEvent) {
   }
 }
 
+TEST(SysdigServiceTest, ExistingProcessesSurviveDrops) {
+  CollectorStats::Reset();
+  SysdigService service;
+  service.inspector_.reset(new sinsp());
+  for (int64_t pid = 100; pid < 104; pid++) {
+    auto* tinfo = new sinsp_threadinfo(service.inspector_.get());
+    tinfo->m_pid = pid;
+    tinfo->m_tid = pid;
+    tinfo->m_ptid = -1;
+    tinfo->m_exepath = "/bin/sleep";
+    tinfo->m_comm = "sleep";
+    tinfo->m_container_id = "0123456789ab";
+    service.inspector_->add_thread(tinfo);
+  }
+
+  auto* client = new DroppingSignalClient(1);
+  service.signal_client_.reset(client);
+  SysdigStats stats;
+  ProcessSignalHandler handler(service.inspector_.get(), client, &stats);
+
+  service.existing_processes_ = ExistingProcessCursor(10);
+  ASSERT_TRUE(service.StartSendingExistingProcesses(&handler));
+  service.SendExistingProcessesBatch();
+
+  // The second process was dropped, the others were still sent.
+  EXPECT_EQ(client->Sent().size(), 3);
+  EXPECT_FALSE(service.existing_processes_.Active());
+  EXPECT_EQ(stats.nProcessSendFailures, 1);
+  EXPECT_EQ(CollectorStats::GetOrCreate().GetCounter(CollectorStats::process_existing_dropped), 1);
+}
+
+TEST(SysdigServiceTest, DispatchTable) {
+  SysdigService service;
+  std::vector<std::string> log;
+  service.AddSignalHandler(MakeUnique<FakeSignalHandler>("first", std::vector<std::string>{"close<", "execve<"}, &log));
+  // No relevant events means all of them.
+  service.AddSignalHandler(MakeUnique<FakeSignalHandler>("all", std::vector<std::string>{}, &log));
+  service.AddSignalHandler(MakeUnique<FakeSignalHandler>("last", std::vector<std::string>{"close<"}, &log));
+
+  // In registration order, with the tag each handler gave the event type.
+  const auto& close = service.dispatch_table_[PPME_SYSCALL_CLOSE_X];
+  ASSERT_EQ(close.num_targets, 3);
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_EQ(close.targets[i].handler, service.signal_handlers_[i].handler.get());
+    EXPECT_EQ(close.targets[i].stats, &service.signal_handlers_[i].stats);
+    EXPECT_EQ(close.targets[i].tag, 1);
+  }
+
+  const auto& execve = service.dispatch_table_[ExecveExit()];
+  ASSERT_EQ(execve.num_targets, 2);
+  EXPECT_EQ(execve.targets[0].handler->GetName(), "first");
+  EXPECT_EQ(execve.targets[1].handler->GetName(), "all");
+  EXPECT_EQ(execve.targets[0].tag, 2);
+
+  const auto& open = service.dispatch_table_[PPME_SYSCALL_OPEN_X];
+  ASSERT_EQ(open.num_targets, 1);
+  EXPECT_EQ(open.targets[0].handler->GetName(), "all");
+
+  std::unique_ptr<sinsp> inspector(new sinsp());
+  FakeEvent event(inspector.get(), PPME_SYSCALL_CLOSE_X);
+  service.DispatchEvent(event.get());
+  EXPECT_EQ(log, std::vector<std::string>({"first:1", "all:1", "last:1"}));
+}
+
+TEST(SysdigServiceTest, FinishedHandlerIsRemoved) {
+  SysdigService service;
+  std::vector<std::string> log;
+  auto first = MakeUnique<FakeSignalHandler>("first", std::vector<std::string>{"close<", "execve<"}, &log);
+  auto* finishing = first.get();
+  service.AddSignalHandler(std::move(first));
+  service.AddSignalHandler(MakeUnique<FakeSignalHandler>("second", std::vector<std::string>{"close<"}, &log));
+  service.AddSignalHandler(MakeUnique<FakeSignalHandler>("third", std::vector<std::string>{"close<", "execve<"}, &log));
+
+  // The handlers after the finished one still get the event.
+  std::unique_ptr<sinsp> inspector(new sinsp());
+  FakeEvent close(inspector.get(), PPME_SYSCALL_CLOSE_X);
+  finishing->Finish();
+  service.DispatchEvent(close.get());
+  EXPECT_EQ(log, std::vector<std::string>({"first:1", "second:1", "third:1"}));
+
+  // It is gone from the table of every event type, and the stats of the others moved along with them.
+  ASSERT_EQ(service.signal_handlers_.size(), 2);
+  const auto& close_dispatch = service.dispatch_table_[PPME_SYSCALL_CLOSE_X];
+  ASSERT_EQ(close_dispatch.num_targets, 2);
+  for (size_t i = 0; i < 2; i++) {
+    EXPECT_EQ(close_dispatch.targets[i].handler, service.signal_handlers_[i].handler.get());
+    EXPECT_EQ(close_dispatch.targets[i].stats, &service.signal_handlers_[i].stats);
+  }
+  const auto& execve_dispatch = service.dispatch_table_[ExecveExit()];
+  ASSERT_EQ(execve_dispatch.num_targets, 1);
+  EXPECT_EQ(execve_dispatch.targets[0].handler->GetName(), "third");
+  EXPECT_EQ(execve_dispatch.targets[0].stats, &service.signal_handlers_[1].stats);
+  EXPECT_EQ(execve_dispatch.targets[0].stats->name, "third");
+
+  log.clear();
+  service.DispatchEvent(close.get());
+  EXPECT_EQ(log, std::vector<std::string>({"second:1", "third:1"}));
+}
+
+TEST(SysdigServiceTest, FlushStartsExistingProcesses) {
+  SysdigService service;
+  service.inspector_.reset(new sinsp());
+  auto* tinfo = new sinsp_threadinfo(service.inspector_.get());
+  tinfo->m_pid = 100;
+  tinfo->m_tid = 100;
+  tinfo->m_ptid = -1;
+  tinfo->m_container_id = "0123456789ab";
+  service.inspector_->add_thread(tinfo);
+
+  std::vector<std::string> log;
+  auto handler = MakeUnique<FakeSignalHandler>("process", std::vector<std::string>{"execve<"}, &log);
+  auto* refreshing = handler.get();
+  service.AddSignalHandler(std::move(handler));
+
+  service.FlushSignalHandlers();
+  EXPECT_FALSE(service.existing_processes_.Active());
+
+  // A handler which lost the stream without seeing an event since does not wait for one.
+  refreshing->RequestRefresh();
+  service.FlushSignalHandlers();
+  EXPECT_TRUE(service.existing_processes_.Active());
+  EXPECT_EQ(service.existing_processes_.Handler(), refreshing);
+  EXPECT_EQ(service.existing_processes_.Remaining(), 1);
+  EXPECT_TRUE(log.empty());
+}
+
 }  // namespace collector
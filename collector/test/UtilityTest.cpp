@@ -1,6 +1,8 @@
 #include <gmock/gmock-actions.h>
 #include <gmock/gmock-spec-builders.h>
 
+#include <unordered_set>
+
 #include "Utility.cpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -115,4 +117,17 @@ TEST(ExtractContainerIDFromCgroupTest, TestExtractContainerIDFromCgroup) {
     EXPECT_EQ(short_container_id, c.expected_output);
   }
 }
+
+TEST(UUIDStrTest, TestFormat) {
+  std::string uuid = UUIDStr();
+  ASSERT_EQ(uuid.size(), kUUIDStringLength);
+  EXPECT_THAT(uuid, MatchesRegex("[0-9a-f]{8}-[0-9a-f]{4}-4[0-9a-f]{3}-[89ab][0-9a-f]{3}-[0-9a-f]{12}"));
+}
+
+TEST(UUIDStrTest, TestUnique) {
+  std::unordered_set<std::string> uuids;
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_TRUE(uuids.insert(UUIDStr()).second);
+  }
+}
 }  // namespace collector